@@ -0,0 +1,41 @@
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace seabots_pi;
+
+static std::atomic<uint64_t> allocationCount(0);
+
+void* operator new(size_t size)
+{
+    ++allocationCount;
+    if (void* ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+uint64_t benchmarks::getAllocationCount()
+{
+    return allocationCount.load();
+}
+
+void benchmarks::reportAllocations(benchmark::State& state, uint64_t start)
+{
+    state.counters["allocs"] = benchmark::Counter(
+        getAllocationCount() - start,
+        benchmark::Counter::kAvgIterations
+    );
+}
@@ -0,0 +1,24 @@
+#ifndef SEABOTS_PI_BENCHMARK_ALLOCATIONCOUNTER_HPP
+#define SEABOTS_PI_BENCHMARK_ALLOCATIONCOUNTER_HPP
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+namespace seabots_pi {
+    namespace benchmarks {
+        /** Number of calls to the global operator new since the start of the
+         * program
+         *
+         * It is counted by the replacement operator new defined in
+         * AllocationCounter.cpp
+         */
+        uint64_t getAllocationCount();
+
+        /** Report the allocations made since \c start as a per-iteration
+         * "allocs" counter
+         */
+        void reportAllocations(benchmark::State& state, uint64_t start);
+    }
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+#include "AllocationCounter.hpp"
+#include "../src/AISEncoder.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+static ais_base::Position makePosition()
+{
+    ais_base::Position position;
+    position.mmsi = 227006760;
+    position.status = static_cast<decltype(position.status)>(0);
+    position.yaw_velocity = 0.01;
+    position.speed_over_ground = 3.2;
+    position.high_accuracy_position = true;
+    position.course_over_ground = base::Angle::fromDeg(-45.3);
+    position.yaw = base::Angle::fromDeg(-40);
+    position.latitude = base::Angle::fromDeg(48.3821);
+    position.longitude = base::Angle::fromDeg(-4.4947);
+    return position;
+}
+
+static ais_base::VesselInformation makeVessel()
+{
+    ais_base::VesselInformation vessel;
+    vessel.mmsi = 227006760;
+    vessel.imo = 9134270;
+    vessel.call_sign = "SB01";
+    vessel.name = "SEABOT ONE";
+    vessel.ship_type = static_cast<decltype(vessel.ship_type)>(37);
+    vessel.length = 12;
+    vessel.width = 4;
+    vessel.draft = 1.5;
+    return vessel;
+}
+
+static void BM_AISEncodePositionReport(benchmark::State& state)
+{
+    AISEncoder encoder;
+    auto position = makePosition();
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        encoder.encode(position);
+        benchmark::DoNotOptimize(encoder.data());
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AISEncodePositionReport);
+
+static void BM_AISEncodeStaticData(benchmark::State& state)
+{
+    AISEncoder encoder;
+    auto vessel = makeVessel();
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        encoder.encode(vessel);
+        benchmark::DoNotOptimize(encoder.data());
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AISEncodeStaticData);
+
+static void BM_AISEncodeClassBPositionReport(benchmark::State& state)
+{
+    AISEncoder encoder;
+    auto position = makePosition();
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        encoder.clear();
+        encoder.setPosition(position);
+        encoder.encode(AISEncoder::MESSAGE_18);
+        benchmark::DoNotOptimize(encoder.data());
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AISEncodeClassBPositionReport);
+
+static void BM_AISEncodeAidToNavigationReport(benchmark::State& state)
+{
+    AISEncoder encoder;
+    auto position = makePosition();
+    auto vessel = makeVessel();
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        encoder.clear();
+        encoder.setPosition(position);
+        encoder.setVessel(vessel);
+        encoder.encode(AISEncoder::MESSAGE_21);
+        benchmark::DoNotOptimize(encoder.data());
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AISEncodeAidToNavigationReport);
+
+static void BM_AISEncodeClassBStaticData(benchmark::State& state)
+{
+    AISEncoder encoder;
+    auto vessel = makeVessel();
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        encoder.clear();
+        encoder.setVessel(vessel);
+        encoder.encode(AISEncoder::MESSAGE_24A);
+        benchmark::DoNotOptimize(encoder.data());
+        encoder.encode(AISEncoder::MESSAGE_24B);
+        benchmark::DoNotOptimize(encoder.data());
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AISEncodeClassBStaticData);
@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include "AllocationCounter.hpp"
+#include "../src/ContactBuffer.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+/** Contacts spread on a grid of about 100x100 km */
+static vector<ais_base::Position> makeContacts(size_t count)
+{
+    vector<ais_base::Position> contacts(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto& position = contacts[i];
+        position.mmsi = 227000000 + i;
+        position.latitude = base::Angle::fromDeg(48 + (i % 100) * 0.01);
+        position.longitude = base::Angle::fromDeg(-4 + (i / 100) * 0.015);
+        position.course_over_ground = base::Angle::fromDeg(i % 360);
+    }
+    return contacts;
+}
+
+/** One position update of every contact */
+static void BM_ContactBufferUpdatePositions(benchmark::State& state)
+{
+    ContactBuffer buffer;
+    auto contacts = makeContacts(state.range(0));
+    for (auto const& position : contacts) {
+        buffer.updatePosition(position, base::Time::fromSeconds(0));
+    }
+
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        for (auto const& position : contacts) {
+            buffer.updatePosition(position, base::Time::fromSeconds(1));
+        }
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations() * contacts.size());
+}
+BENCHMARK(BM_ContactBufferUpdatePositions)->Arg(10000);
+
+/** The per-frame cost of the renderer when the contacts changed */
+static void BM_ContactBufferSnapshot(benchmark::State& state)
+{
+    ContactBuffer buffer;
+    auto contacts = makeContacts(state.range(0));
+    for (auto const& position : contacts) {
+        buffer.updatePosition(position, base::Time::fromSeconds(0));
+    }
+
+    ContactBuffer::Snapshot snapshot;
+    buffer.updateSnapshot(snapshot);
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        buffer.updatePosition(contacts[0], base::Time::fromSeconds(1));
+        buffer.updateSnapshot(snapshot);
+        benchmark::DoNotOptimize(snapshot.positions.data());
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ContactBufferSnapshot)->Arg(10000);
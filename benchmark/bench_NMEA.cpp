@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+#include "AllocationCounter.hpp"
+#include "../src/NMEA.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+static base::Time const TIME = base::Time::fromMilliseconds(1556222665123);
+static base::Angle const LATITUDE = base::Angle::fromDeg(43.2135634);
+static base::Angle const LONGITUDE = base::Angle::fromDeg(43.018);
+static base::Angle const TRACK = base::Angle::fromDeg(10.42);
+static base::Angle const VARIATION = base::Angle::fromDeg(2);
+
+static void BM_NMEACreateRMC(benchmark::State& state)
+{
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            nmea::createRMC(TIME, LATITUDE, LONGITUDE, 1.4, TRACK, VARIATION)
+        );
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEACreateRMC);
+
+static void BM_NMEAEncodeRMC(benchmark::State& state)
+{
+    nmea::Sentence sentence;
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        nmea::encodeRMC(sentence, TIME, LATITUDE, LONGITUDE, 1.4, TRACK, VARIATION);
+        benchmark::DoNotOptimize(sentence.data());
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEAEncodeRMC);
+
+static void BM_NMEACreateVTG(benchmark::State& state)
+{
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nmea::createVTG(TRACK, TRACK, 1.4));
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEACreateVTG);
+
+static void BM_NMEAEncodeVTG(benchmark::State& state)
+{
+    nmea::Sentence sentence;
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        nmea::encodeVTG(sentence, TRACK, TRACK, 1.4);
+        benchmark::DoNotOptimize(sentence.data());
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEAEncodeVTG);
+
+static void BM_NMEAEncodeHDT(benchmark::State& state)
+{
+    nmea::Sentence sentence;
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        nmea::encodeHDT(sentence, TRACK);
+        benchmark::DoNotOptimize(sentence.data());
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEAEncodeHDT);
@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+#include "AllocationCounter.hpp"
+#include "../src/NMEAOutput.hpp"
+
+#include <string>
+
+using namespace std;
+using namespace seabots_pi;
+
+static string const SENTENCE =
+    "$SBRMC,200425.12,A,4312.813,N,04301.079,E,2.7,349.6,250419,2.0,E*5E";
+
+static size_t sunk = 0;
+
+/** Stand-in for PushNMEABuffer, which takes its argument by value */
+static void sink(wxString sentence)
+{
+    sunk += sentence.length();
+}
+
+static void BM_NMEAOutputImplicitConversion(benchmark::State& state)
+{
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        sink(wxString(SENTENCE));
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEAOutputImplicitConversion);
+
+static void BM_NMEAOutputFromAscii(benchmark::State& state)
+{
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        sink(wxString::FromAscii(SENTENCE.data(), SENTENCE.size()));
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEAOutputFromAscii);
+
+static void BM_NMEAOutputReusedBuffer(benchmark::State& state)
+{
+    NMEAOutput output(sink);
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        output.push(SENTENCE.data(), SENTENCE.size());
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEAOutputReusedBuffer);
@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+#include "AllocationCounter.hpp"
+#include "../src/NMEA.hpp"
+#include "../src/NMEAParser.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+// Same values as bench_NMEA.cpp, so that the parse rates can be compared
+// with the encode rates
+static base::Time const TIME = base::Time::fromMilliseconds(1556222665123);
+static base::Angle const LATITUDE = base::Angle::fromDeg(43.2135634);
+static base::Angle const LONGITUDE = base::Angle::fromDeg(43.018);
+static base::Angle const TRACK = base::Angle::fromDeg(10.42);
+static base::Angle const VARIATION = base::Angle::fromDeg(2);
+
+static void BM_NMEAValidateChecksum(benchmark::State& state)
+{
+    nmea::Sentence sentence;
+    nmea::encodeRMC(sentence, TIME, LATITUDE, LONGITUDE, 1.4, TRACK, VARIATION);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            nmea::validateChecksum(sentence.data(), sentence.size())
+        );
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * sentence.size());
+}
+BENCHMARK(BM_NMEAValidateChecksum);
+
+static void BM_NMEAParseRMC(benchmark::State& state)
+{
+    nmea::Sentence sentence;
+    nmea::encodeRMC(sentence, TIME, LATITUDE, LONGITUDE, 1.4, TRACK, VARIATION);
+    nmea::RMCData rmc;
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        nmea::parseRMC(sentence.data(), sentence.size(), rmc);
+        benchmark::DoNotOptimize(rmc);
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEAParseRMC);
+
+static void BM_NMEAParseVTG(benchmark::State& state)
+{
+    nmea::Sentence sentence;
+    nmea::encodeVTG(sentence, TRACK, TRACK, 1.4);
+    nmea::VTGData vtg;
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        nmea::parseVTG(sentence.data(), sentence.size(), vtg);
+        benchmark::DoNotOptimize(vtg);
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEAParseVTG);
+
+static void BM_NMEAParseHDT(benchmark::State& state)
+{
+    nmea::Sentence sentence;
+    nmea::encodeHDT(sentence, TRACK);
+    base::Angle heading;
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        nmea::parseHDT(sentence.data(), sentence.size(), heading);
+        benchmark::DoNotOptimize(heading);
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEAParseHDT);
+
+/** Encoding and parsing back the sentence, as in the round-trip tests */
+static void BM_NMEARoundTripRMC(benchmark::State& state)
+{
+    nmea::Sentence sentence;
+    nmea::RMCData rmc;
+    uint64_t allocations = benchmarks::getAllocationCount();
+    for (auto _ : state) {
+        nmea::encodeRMC(sentence, TIME, LATITUDE, LONGITUDE, 1.4, TRACK, VARIATION);
+        nmea::validateChecksum(sentence.data(), sentence.size());
+        nmea::parseRMC(sentence.data(), sentence.size(), rmc);
+        benchmark::DoNotOptimize(rmc);
+    }
+    benchmarks::reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NMEARoundTripRMC);
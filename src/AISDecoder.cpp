@@ -0,0 +1,184 @@
+#include "AISDecoder.hpp"
+#include <cmath>
+
+using namespace std;
+using namespace seabots_pi;
+
+static const double KNOT_TO_MS = 1852.0 / 3600;
+
+const size_t AISDecoder::MAX_PAYLOAD_SIZE;
+
+/** Value of an armored character, or -1 if it is invalid */
+static int dearmor(char c)
+{
+    if (c >= '0' && c <= 'W') {
+        return c - '0';
+    }
+    else if (c >= '`' && c <= 'w') {
+        return c - '`' + 40;
+    }
+    return -1;
+}
+
+bool AISDecoder::push(nmea::VDMFragment const& fragment)
+{
+    mComplete = false;
+    if (fragment.number == 1) {
+        mNextFragment = 1;
+        mFragmentCount = fragment.count;
+        mSequenceID = fragment.sequence_id;
+        mChannel = fragment.channel;
+        mPayloadSize = 0;
+    }
+    else if (fragment.number != mNextFragment ||
+             fragment.count != mFragmentCount ||
+             fragment.sequence_id != mSequenceID ||
+             fragment.channel != mChannel) {
+        mNextFragment = 0;
+        return false;
+    }
+
+    if (mPayloadSize + fragment.payload.size > MAX_PAYLOAD_SIZE) {
+        mNextFragment = 0;
+        return false;
+    }
+    for (size_t i = 0; i < fragment.payload.size; ++i) {
+        int value = dearmor(fragment.payload.data[i]);
+        if (value < 0) {
+            mNextFragment = 0;
+            return false;
+        }
+        mPayload[mPayloadSize++] = value;
+    }
+
+    if (fragment.number < fragment.count) {
+        ++mNextFragment;
+        return false;
+    }
+
+    mNextFragment = 0;
+    if (mPayloadSize * 6 < static_cast<size_t>(fragment.fill_bits) + 38) {
+        return false;
+    }
+    mBitCount = mPayloadSize * 6 - fragment.fill_bits;
+    mComplete = true;
+    return true;
+}
+
+int AISDecoder::getMessageType() const
+{
+    return mComplete ? getUInt(0, 6) : 0;
+}
+
+uint32_t AISDecoder::getMMSI() const
+{
+    return getUInt(8, 30);
+}
+
+size_t AISDecoder::getBitCount() const
+{
+    return mBitCount;
+}
+
+uint32_t AISDecoder::getUInt(size_t start, size_t length) const
+{
+    uint32_t result = 0;
+    for (size_t i = start; i < start + length; ++i) {
+        uint32_t bit = 0;
+        if (i < mBitCount) {
+            bit = (mPayload[i / 6] >> (5 - i % 6)) & 1;
+        }
+        result = result << 1 | bit;
+    }
+    return result;
+}
+
+int32_t AISDecoder::getInt(size_t start, size_t length) const
+{
+    uint32_t value = getUInt(start, length);
+    uint32_t sign = 1u << (length - 1);
+    return static_cast<int32_t>(value ^ sign) - static_cast<int32_t>(sign);
+}
+
+string AISDecoder::getText(size_t start, size_t characters) const
+{
+    string result;
+    result.reserve(characters);
+    for (size_t i = 0; i < characters; ++i) {
+        uint32_t value = getUInt(start + i * 6, 6);
+        char c = value < 32 ? value + 64 : value;
+        if (c == '@') {
+            break;
+        }
+        result += c;
+    }
+    size_t end = result.find_last_not_of(' ');
+    result.resize(end == string::npos ? 0 : end + 1);
+    return result;
+}
+
+/** Convert an AIS course or heading into Rock's convention */
+static base::Angle angleFromAIS(double deg)
+{
+    // AIS goes positive towards east
+    return base::Angle::fromDeg(-deg);
+}
+
+bool AISDecoder::decode(ais_base::Position& position) const
+{
+    int type = getMessageType();
+    if (type < 1 || type > 3 || mBitCount < 149) {
+        return false;
+    }
+
+    position.mmsi = getMMSI();
+    position.status = static_cast<decltype(position.status)>(getUInt(38, 4));
+
+    int rot = getInt(42, 8);
+    if (rot == -128 || rot == 127 || rot == -127) {
+        // -128 is "not available", +-127 is "turning at more than 5 deg/30s"
+        // without any rate information
+        position.yaw_velocity = base::unknown<double>();
+    }
+    else {
+        double deg_per_min = pow(rot / 4.733, 2);
+        position.yaw_velocity =
+            (rot < 0 ? -deg_per_min : deg_per_min) / 60 * M_PI / 180;
+    }
+
+    uint32_t sog = getUInt(50, 10);
+    position.speed_over_ground =
+        sog == 1023 ? base::unknown<double>() : sog / 10.0 * KNOT_TO_MS;
+    position.high_accuracy_position = getUInt(60, 1);
+
+    int32_t longitude = getInt(61, 28);
+    int32_t latitude = getInt(89, 27);
+    position.longitude = longitude == 181 * 600000 ?
+        base::Angle() : base::Angle::fromDeg(longitude / 600000.0);
+    position.latitude = latitude == 91 * 600000 ?
+        base::Angle() : base::Angle::fromDeg(latitude / 600000.0);
+
+    uint32_t cog = getUInt(116, 12);
+    position.course_over_ground =
+        cog >= 3600 ? base::Angle() : angleFromAIS(cog / 10.0);
+    uint32_t heading = getUInt(128, 9);
+    position.yaw = heading >= 360 ? base::Angle() : angleFromAIS(heading);
+    return true;
+}
+
+bool AISDecoder::decode(ais_base::VesselInformation& vessel) const
+{
+    if (getMessageType() != 5 || mBitCount < 302) {
+        return false;
+    }
+
+    vessel.mmsi = getMMSI();
+    vessel.imo = getUInt(40, 30);
+    vessel.call_sign = getText(70, 7);
+    vessel.name = getText(112, 20);
+    vessel.ship_type = static_cast<decltype(vessel.ship_type)>(getUInt(232, 8));
+    vessel.length = getUInt(240, 9) + getUInt(249, 9);
+    vessel.width = getUInt(258, 6) + getUInt(264, 6);
+    vessel.draft = getUInt(294, 8) / 10.0;
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef SEABOTS_PI_AISDECODER_HPP
+#define SEABOTS_PI_AISDECODER_HPP
+
+#include <cstdint>
+#include <string>
+#include <ais_base/Position.hpp>
+#include <ais_base/VesselInformation.hpp>
+#include "NMEAParser.hpp"
+
+namespace seabots_pi {
+    /** Reassembles the fragments of AIS messages and decodes them
+     *
+     * The payload is de-armored into a fixed buffer, and fields are read
+     * directly from it. Only the position reports (messages 1, 2 and 3) and
+     * the static and voyage data (message 5) are decoded into Rock types.
+     *
+     * Fragments of a multi-fragment message must arrive in order. A
+     * fragment that does not continue the message being assembled aborts it.
+     */
+    class AISDecoder
+    {
+    public:
+        /** Maximum number of armored characters of a message
+         *
+         * This is five fragments of 82-character sentences, more than any
+         * message uses in practice
+         */
+        static const size_t MAX_PAYLOAD_SIZE = 5 * 82;
+
+        /** Add a fragment
+         *
+         * @return true if it completes a message, which can then be
+         *   accessed until the next call
+         */
+        bool push(nmea::VDMFragment const& fragment);
+
+        /** Type of the last complete message */
+        int getMessageType() const;
+
+        /** MMSI of the last complete message */
+        uint32_t getMMSI() const;
+
+        /** Number of bits of the last complete message */
+        size_t getBitCount() const;
+
+        /** Read an unsigned field of the last complete message
+         *
+         * Bits past the end of the message read as zero
+         */
+        uint32_t getUInt(size_t start, size_t length) const;
+
+        /** Read a two's complement field of the last complete message */
+        int32_t getInt(size_t start, size_t length) const;
+
+        /** Read a six-bit text field, without its '@' and space padding */
+        std::string getText(size_t start, size_t characters) const;
+
+        /** Decode a position report (message 1, 2 or 3)
+         *
+         * The time is left untouched
+         *
+         * @return false if the last message is not a position report
+         */
+        bool decode(ais_base::Position& position) const;
+
+        /** Decode a static and voyage related data message (message 5)
+         *
+         * The time is left untouched
+         *
+         * @return false if the last message is not a message 5
+         */
+        bool decode(ais_base::VesselInformation& vessel) const;
+
+    private:
+        /** De-armored payload, one six-bit value per byte */
+        uint8_t mPayload[MAX_PAYLOAD_SIZE];
+        size_t mPayloadSize = 0;
+        size_t mBitCount = 0;
+
+        /** Number of the next expected fragment, 0 if no message is being
+         * assembled
+         */
+        int mNextFragment = 0;
+        int mFragmentCount = 0;
+        int mSequenceID = -1;
+        char mChannel = 0;
+        bool mComplete = false;
+    };
+}
+
+#endif
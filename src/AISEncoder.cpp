@@ -0,0 +1,563 @@
+#include "AISEncoder.hpp"
+#include "NMEA.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+using namespace seabots_pi;
+
+const size_t AISEncoder::MAX_BITS;
+const size_t AISEncoder::FRAGMENT_SIZE;
+const size_t AISEncoder::MAX_TEXT_SIZE;
+const int AISEncoder::ALL_TARGET_CLASSES;
+
+/** Armored character of each six-bit value */
+static const char ARMOR[64] = {
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', ':', ';', '<', '=', '>', '?',
+    '@', 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O',
+    'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', '`', 'a', 'b', 'c', 'd', 'e', 'f', 'g',
+    'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w'
+};
+
+static const char HEX[] = "0123456789ABCDEF";
+
+namespace {
+    /** Description of a field of a message */
+    struct FieldDescriptor
+    {
+        enum Kind
+        {
+            CONSTANT,
+            NUMBER,
+            TEXT
+        };
+
+        Kind kind;
+        /** Size of the field in bits */
+        unsigned int bits;
+        /** The value of a CONSTANT, the AISEncoder::Field of a NUMBER or
+         * the AISEncoder::TextField of a TEXT
+         */
+        uint32_t value;
+    };
+
+    FieldDescriptor constant(unsigned int bits, uint32_t value)
+    {
+        return FieldDescriptor { FieldDescriptor::CONSTANT, bits, value };
+    }
+
+    FieldDescriptor number(AISEncoder::Field field, unsigned int bits)
+    {
+        return FieldDescriptor { FieldDescriptor::NUMBER, bits, field };
+    }
+
+    FieldDescriptor text(AISEncoder::TextField field, unsigned int characters)
+    {
+        return FieldDescriptor { FieldDescriptor::TEXT, characters * 6, field };
+    }
+
+    /** Message ID and repeat indicator */
+    #define AIS_HEADER(id) constant(6, id), constant(2, 0)
+    /** Time stamp not available */
+    #define AIS_TIME_STAMP constant(6, 60)
+    #define AIS_DIMENSIONS \
+        number(AISEncoder::FIELD_TO_BOW, 9), \
+        number(AISEncoder::FIELD_TO_STERN, 9), \
+        number(AISEncoder::FIELD_TO_PORT, 6), \
+        number(AISEncoder::FIELD_TO_STARBOARD, 6)
+    /** Undefined EPFD */
+    #define AIS_EPFD constant(4, 0)
+
+    FieldDescriptor const MESSAGE_1_FIELDS[] = {
+        AIS_HEADER(1),
+        number(AISEncoder::FIELD_MMSI, 30),
+        number(AISEncoder::FIELD_STATUS, 4),
+        number(AISEncoder::FIELD_RATE_OF_TURN, 8),
+        number(AISEncoder::FIELD_SPEED_OVER_GROUND, 10),
+        number(AISEncoder::FIELD_POSITION_ACCURACY, 1),
+        number(AISEncoder::FIELD_LONGITUDE, 28),
+        number(AISEncoder::FIELD_LATITUDE, 27),
+        number(AISEncoder::FIELD_COURSE_OVER_GROUND, 12),
+        number(AISEncoder::FIELD_HEADING, 9),
+        AIS_TIME_STAMP,
+        // No special maneuver, spare, RAIM and radio status
+        constant(2, 0), constant(3, 0), constant(1, 0), constant(19, 0)
+    };
+
+    FieldDescriptor const MESSAGE_5_FIELDS[] = {
+        AIS_HEADER(5),
+        number(AISEncoder::FIELD_MMSI, 30),
+        // AIS version
+        constant(2, 0),
+        number(AISEncoder::FIELD_IMO, 30),
+        text(AISEncoder::TEXT_CALL_SIGN, 7),
+        text(AISEncoder::TEXT_NAME, 20),
+        number(AISEncoder::FIELD_SHIP_TYPE, 8),
+        AIS_DIMENSIONS,
+        AIS_EPFD,
+        // ETA not available
+        constant(4, 0), constant(5, 0), constant(5, 24), constant(6, 60),
+        number(AISEncoder::FIELD_DRAUGHT, 8),
+        text(AISEncoder::TEXT_EMPTY, 20),
+        // DTE not ready and spare
+        constant(1, 1), constant(1, 0)
+    };
+
+    /** Flags of a class B "CS" unit, not assigned, without RAIM, and the
+     * fixed radio status that CS units use
+     */
+    #define AIS_CLASS_B_CS_FLAGS \
+        constant(1, 1), constant(1, 0), constant(1, 0), constant(1, 1), \
+        constant(1, 0), constant(1, 0), constant(1, 0), \
+        constant(20, 0xE0006)
+
+    FieldDescriptor const MESSAGE_18_FIELDS[] = {
+        AIS_HEADER(18),
+        number(AISEncoder::FIELD_MMSI, 30),
+        constant(8, 0),
+        number(AISEncoder::FIELD_SPEED_OVER_GROUND, 10),
+        number(AISEncoder::FIELD_POSITION_ACCURACY, 1),
+        number(AISEncoder::FIELD_LONGITUDE, 28),
+        number(AISEncoder::FIELD_LATITUDE, 27),
+        number(AISEncoder::FIELD_COURSE_OVER_GROUND, 12),
+        number(AISEncoder::FIELD_HEADING, 9),
+        AIS_TIME_STAMP,
+        constant(2, 0),
+        AIS_CLASS_B_CS_FLAGS
+    };
+
+    FieldDescriptor const MESSAGE_19_FIELDS[] = {
+        AIS_HEADER(19),
+        number(AISEncoder::FIELD_MMSI, 30),
+        constant(8, 0),
+        number(AISEncoder::FIELD_SPEED_OVER_GROUND, 10),
+        number(AISEncoder::FIELD_POSITION_ACCURACY, 1),
+        number(AISEncoder::FIELD_LONGITUDE, 28),
+        number(AISEncoder::FIELD_LATITUDE, 27),
+        number(AISEncoder::FIELD_COURSE_OVER_GROUND, 12),
+        number(AISEncoder::FIELD_HEADING, 9),
+        AIS_TIME_STAMP,
+        constant(4, 0),
+        text(AISEncoder::TEXT_NAME, 20),
+        number(AISEncoder::FIELD_SHIP_TYPE, 8),
+        AIS_DIMENSIONS,
+        AIS_EPFD,
+        // No RAIM, DTE not ready, not assigned and spare
+        constant(1, 0), constant(1, 1), constant(1, 0), constant(4, 0)
+    };
+
+    FieldDescriptor const MESSAGE_21_FIELDS[] = {
+        AIS_HEADER(21),
+        number(AISEncoder::FIELD_MMSI, 30),
+        // Type of aid to navigation not specified
+        constant(5, 0),
+        text(AISEncoder::TEXT_NAME, 20),
+        number(AISEncoder::FIELD_POSITION_ACCURACY, 1),
+        number(AISEncoder::FIELD_LONGITUDE, 28),
+        number(AISEncoder::FIELD_LATITUDE, 27),
+        AIS_DIMENSIONS,
+        AIS_EPFD,
+        AIS_TIME_STAMP,
+        // On position, regional reserved and no RAIM
+        constant(1, 0), constant(8, 0), constant(1, 0),
+        number(AISEncoder::FIELD_VIRTUAL_AID, 1),
+        // Not assigned and spare
+        constant(1, 0), constant(1, 0)
+    };
+
+    FieldDescriptor const MESSAGE_24A_FIELDS[] = {
+        AIS_HEADER(24),
+        number(AISEncoder::FIELD_MMSI, 30),
+        constant(2, 0),
+        text(AISEncoder::TEXT_NAME, 20),
+        constant(8, 0)
+    };
+
+    FieldDescriptor const MESSAGE_24B_FIELDS[] = {
+        AIS_HEADER(24),
+        number(AISEncoder::FIELD_MMSI, 30),
+        constant(2, 1),
+        number(AISEncoder::FIELD_SHIP_TYPE, 8),
+        // Vendor ID, unit model code and serial number
+        text(AISEncoder::TEXT_EMPTY, 3), constant(4, 0), constant(20, 0),
+        text(AISEncoder::TEXT_CALL_SIGN, 7),
+        AIS_DIMENSIONS,
+        AIS_EPFD,
+        constant(2, 0)
+    };
+
+    #undef AIS_HEADER
+    #undef AIS_TIME_STAMP
+    #undef AIS_DIMENSIONS
+    #undef AIS_EPFD
+    #undef AIS_CLASS_B_CS_FLAGS
+
+    struct MessageLayout
+    {
+        FieldDescriptor const* fields;
+        size_t size;
+    };
+
+    template<size_t N>
+    MessageLayout layout(FieldDescriptor const (&fields)[N])
+    {
+        return MessageLayout { fields, N };
+    }
+
+    /** The layouts, indexed by AISEncoder::Message */
+    MessageLayout const MESSAGES[AISEncoder::MESSAGE_COUNT] = {
+        layout(MESSAGE_1_FIELDS),
+        layout(MESSAGE_5_FIELDS),
+        layout(MESSAGE_18_FIELDS),
+        layout(MESSAGE_19_FIELDS),
+        layout(MESSAGE_21_FIELDS),
+        layout(MESSAGE_24A_FIELDS),
+        layout(MESSAGE_24B_FIELDS)
+    };
+}
+
+AISEncoder::AISEncoder()
+{
+    clear();
+}
+
+bool AISEncoder::isAidToNavigation(uint32_t mmsi)
+{
+    return mmsi / 10000000 == 99;
+}
+
+bool AISEncoder::isVirtualAidToNavigation(uint32_t mmsi)
+{
+    return isAidToNavigation(mmsi) && (mmsi / 1000) % 10 == 6;
+}
+
+AISEncoder::TargetClass AISEncoder::getTargetClass(
+    ais_base::Position const& position
+)
+{
+    if (isAidToNavigation(position.mmsi)) {
+        return AID_TO_NAVIGATION;
+    }
+    else if (position.status == ais_base::STATUS_NOT_DEFINED &&
+             base::isUnknown(position.yaw_velocity)) {
+        return CLASS_B;
+    }
+    return CLASS_A;
+}
+
+int AISEncoder::parseTargetClasses(string const& names)
+{
+    static const pair<char const*, TargetClass> CLASSES[] = {
+        { "A", CLASS_A }, { "B", CLASS_B }, { "AtoN", AID_TO_NAVIGATION }
+    };
+
+    int result = 0;
+    size_t start = 0;
+    while (start <= names.size()) {
+        size_t end = names.find(',', start);
+        if (end == string::npos) {
+            end = names.size();
+        }
+        string name = names.substr(start, end - start);
+        start = end + 1;
+        if (name.empty()) {
+            continue;
+        }
+
+        bool found = false;
+        for (auto const& target_class : CLASSES) {
+            if (name == target_class.first) {
+                result |= 1 << target_class.second;
+                found = true;
+            }
+        }
+        if (!found) {
+            throw invalid_argument("'" + name + "' is not an AIS target class");
+        }
+    }
+    return result;
+}
+
+size_t AISEncoder::getMessageBits(Message message)
+{
+    MessageLayout const& layout = MESSAGES[message];
+    size_t bits = 0;
+    for (size_t i = 0; i < layout.size; ++i) {
+        bits += layout.fields[i].bits;
+    }
+    return bits;
+}
+
+void AISEncoder::begin()
+{
+    mAccumulator = 0;
+    mAccumulatedBits = 0;
+    mPayloadSize = 0;
+}
+
+void AISEncoder::putUInt(uint32_t value, unsigned int bits)
+{
+    // At most 5 bits are left in the accumulator, and fields are at most
+    // 30 bits, so this never overflows
+    uint64_t mask = (uint64_t(1) << bits) - 1;
+    mAccumulator = (mAccumulator << bits) | (value & mask);
+    mAccumulatedBits += bits;
+    while (mAccumulatedBits >= 6) {
+        mAccumulatedBits -= 6;
+        mPayload[mPayloadSize++] = ARMOR[(mAccumulator >> mAccumulatedBits) & 0x3F];
+    }
+}
+
+/** Six-bit value of a character of an AIS text field */
+static uint8_t sixbitFromChar(char c)
+{
+    if (c >= 'a' && c <= 'z') {
+        c = c - 'a' + 'A';
+    }
+    if (c >= '@' && c <= '_') {
+        return c - '@';
+    }
+    else if (c >= ' ' && c <= '?') {
+        return c;
+    }
+    return ' ';
+}
+
+/** Convert a text to six-bit values, padded with '@', i.e. zero */
+static void sixbitFromText(
+    uint8_t* sixbits, string const& text, size_t characters
+)
+{
+    size_t size = min(text.size(), characters);
+    for (size_t i = 0; i < size; ++i) {
+        sixbits[i] = sixbitFromChar(text[i]);
+    }
+    fill(sixbits + size, sixbits + characters, 0);
+}
+
+void AISEncoder::putText(uint8_t const* sixbits, size_t characters)
+{
+    for (size_t i = 0; i < characters; ++i) {
+        putUInt(sixbits[i], 6);
+    }
+}
+
+void AISEncoder::finish()
+{
+    mFillBits = 0;
+    if (mAccumulatedBits) {
+        mFillBits = 6 - mAccumulatedBits;
+        putUInt(0, mFillBits);
+    }
+    frame();
+}
+
+void AISEncoder::frame()
+{
+    mFragmentCount = (mPayloadSize + FRAGMENT_SIZE - 1) / FRAGMENT_SIZE;
+    char* out = mSentences;
+    for (size_t i = 0; i < mFragmentCount; ++i) {
+        if (i != 0) {
+            *out++ = '\n';
+        }
+
+        char* start = out;
+        memcpy(out, "!AIVDM,", 7);
+        out += 7;
+        *out++ = '0' + mFragmentCount;
+        *out++ = ',';
+        *out++ = '1' + i;
+        memcpy(out, ",,B,", 4);
+        out += 4;
+
+        size_t offset = i * FRAGMENT_SIZE;
+        size_t size = min(FRAGMENT_SIZE, mPayloadSize - offset);
+        memcpy(out, mPayload + offset, size);
+        out += size;
+        *out++ = ',';
+        *out++ = (i + 1 == mFragmentCount) ? '0' + mFillBits : '0';
+
+        uint8_t checksum = 0;
+        for (char const* c = start + 1; c != out; ++c) {
+            checksum ^= *c;
+        }
+        *out++ = '*';
+        *out++ = HEX[checksum >> 4];
+        *out++ = HEX[checksum & 0xF];
+    }
+    mSentencesSize = out - mSentences;
+}
+
+/** AIS encoding of a course or heading, in 1/scale degrees
+ *
+ * AIS goes positive towards east, in [0, 360)
+ */
+static uint32_t angleToAIS(base::Angle const& angle, int scale)
+{
+    long full_turn = 360 * scale;
+    long value = lround(-angle.getDeg() * scale) % full_turn;
+    return value < 0 ? value + full_turn : value;
+}
+
+static int32_t rateOfTurnToAIS(double yaw_velocity)
+{
+    if (base::isUnknown(yaw_velocity)) {
+        return -128;
+    }
+
+    // ROT_AIS = 4.733 * sqrt(ROT_sensor), the sensor rate being in deg/min
+    double deg_per_min = yaw_velocity * 180 / M_PI * 60;
+    double rot = 4.733 * sqrt(fabs(deg_per_min));
+    int32_t value = rot > 126.5 ? 127 : lround(rot);
+    return deg_per_min < 0 ? -value : value;
+}
+
+static int32_t latlonToAIS(base::Angle const& angle, int not_available)
+{
+    double deg = angle.getDeg();
+    if (base::isUnknown(deg)) {
+        return not_available * 600000;
+    }
+    return llround(deg * 600000);
+}
+
+/** Split a dimension in two halves of whole meters, with the given maximum
+ * each
+ */
+static pair<uint32_t, uint32_t> splitDimension(double value, uint32_t max)
+{
+    if (base::isUnknown(value) || value < 0) {
+        return make_pair(0, 0);
+    }
+
+    uint32_t total = lround(value);
+    uint32_t first = total / 2;
+    return make_pair(min(first, max), min(total - first, max));
+}
+
+void AISEncoder::clear()
+{
+    fill(mFields, mFields + FIELD_COUNT, 0);
+    mFields[FIELD_RATE_OF_TURN] = static_cast<uint32_t>(-128);
+    mFields[FIELD_SPEED_OVER_GROUND] = 1023;
+    mFields[FIELD_LONGITUDE] = 181 * 600000;
+    mFields[FIELD_LATITUDE] = 91 * 600000;
+    mFields[FIELD_COURSE_OVER_GROUND] = 3600;
+    mFields[FIELD_HEADING] = 511;
+    memset(mTexts, 0, sizeof(mTexts));
+}
+
+void AISEncoder::setPosition(ais_base::Position const& position)
+{
+    mFields[FIELD_MMSI] = position.mmsi;
+    mFields[FIELD_VIRTUAL_AID] = isVirtualAidToNavigation(position.mmsi);
+    mFields[FIELD_STATUS] = position.status;
+    mFields[FIELD_RATE_OF_TURN] = rateOfTurnToAIS(position.yaw_velocity);
+
+    double sog = position.speed_over_ground;
+    mFields[FIELD_SPEED_OVER_GROUND] = base::isUnknown(sog) ?
+        1023 : min<long>(max<long>(lround(sog * nmea::MS_TO_KNOT * 10), 0), 1022);
+    mFields[FIELD_POSITION_ACCURACY] = position.high_accuracy_position;
+    mFields[FIELD_LONGITUDE] = latlonToAIS(position.longitude, 181);
+    mFields[FIELD_LATITUDE] = latlonToAIS(position.latitude, 91);
+
+    mFields[FIELD_COURSE_OVER_GROUND] =
+        base::isUnknown(position.course_over_ground.getRad()) ?
+        3600 : angleToAIS(position.course_over_ground, 10);
+    mFields[FIELD_HEADING] = base::isUnknown(position.yaw.getRad()) ?
+        511 : angleToAIS(position.yaw, 1);
+}
+
+void AISEncoder::setVessel(ais_base::VesselInformation const& vessel)
+{
+    mFields[FIELD_MMSI] = vessel.mmsi;
+    mFields[FIELD_VIRTUAL_AID] = isVirtualAidToNavigation(vessel.mmsi);
+    mFields[FIELD_IMO] = vessel.imo;
+    sixbitFromText(mTexts[TEXT_CALL_SIGN], vessel.call_sign, 7);
+    sixbitFromText(mTexts[TEXT_NAME], vessel.name, 20);
+    mFields[FIELD_SHIP_TYPE] = vessel.ship_type;
+
+    auto length = splitDimension(vessel.length, 511);
+    mFields[FIELD_TO_BOW] = length.first;
+    mFields[FIELD_TO_STERN] = length.second;
+    auto width = splitDimension(vessel.width, 63);
+    mFields[FIELD_TO_PORT] = width.first;
+    mFields[FIELD_TO_STARBOARD] = width.second;
+
+    double draft = vessel.draft;
+    mFields[FIELD_DRAUGHT] = base::isUnknown(draft) || draft < 0 ?
+        0 : min<long>(lround(draft * 10), 255);
+}
+
+void AISEncoder::encode(Message message)
+{
+    MessageLayout const& layout = MESSAGES[message];
+    begin();
+    for (size_t i = 0; i < layout.size; ++i) {
+        FieldDescriptor const& field = layout.fields[i];
+        switch (field.kind) {
+            case FieldDescriptor::CONSTANT:
+                putUInt(field.value, field.bits);
+                break;
+            case FieldDescriptor::NUMBER:
+                putUInt(mFields[field.value], field.bits);
+                break;
+            case FieldDescriptor::TEXT:
+                putText(mTexts[field.value], field.bits / 6);
+                break;
+        }
+    }
+    finish();
+}
+
+void AISEncoder::encode(ais_base::Position const& position)
+{
+    clear();
+    setPosition(position);
+    encode(MESSAGE_1);
+}
+
+void AISEncoder::encode(ais_base::VesselInformation const& vessel)
+{
+    clear();
+    setVessel(vessel);
+    encode(MESSAGE_5);
+}
+
+char const* AISEncoder::data() const
+{
+    return mSentences;
+}
+
+size_t AISEncoder::size() const
+{
+    return mSentencesSize;
+}
+
+string AISEncoder::str() const
+{
+    return string(mSentences, mSentencesSize);
+}
+
+size_t AISEncoder::getFragmentCount() const
+{
+    return mFragmentCount;
+}
+
+char const* AISEncoder::getPayload() const
+{
+    return mPayload;
+}
+
+size_t AISEncoder::getPayloadSize() const
+{
+    return mPayloadSize;
+}
+
+int AISEncoder::getFillBits() const
+{
+    return mFillBits;
+}
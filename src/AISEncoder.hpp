@@ -0,0 +1,203 @@
+#ifndef SEABOTS_PI_AISENCODER_HPP
+#define SEABOTS_PI_AISENCODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <ais_base/Position.hpp>
+#include <ais_base/VesselInformation.hpp>
+
+namespace seabots_pi {
+    /** Encodes Rock AIS samples into VDM sentences
+     *
+     * The fields of the Rock samples are first converted into their AIS
+     * representation with setPosition and setVessel. Each message type is
+     * then described by a table of fields, which a single packing loop
+     * turns into armored six-bit characters. The VDM sentences are framed
+     * in a fixed buffer. It does not allocate.
+     *
+     * The fields that Rock does not have (e.g. the time stamp or the ETA)
+     * are set to their "not available" value. Sentences use the AIVDM
+     * address on channel B, without sequential message ID, and split the
+     * payload in fragments of FRAGMENT_SIZE characters.
+     */
+    class AISEncoder
+    {
+    public:
+        /** Size in bits of the largest supported message, message 5 */
+        static const size_t MAX_BITS = 424;
+        /** Maximum number of armored characters per sentence */
+        static const size_t FRAGMENT_SIZE = 60;
+
+        /** The supported messages */
+        enum Message
+        {
+            /** Class A position report */
+            MESSAGE_1,
+            /** Class A static and voyage related data */
+            MESSAGE_5,
+            /** Class B position report */
+            MESSAGE_18,
+            /** Extended class B position report, with the static data */
+            MESSAGE_19,
+            /** Aid-to-navigation report, with its static data */
+            MESSAGE_21,
+            /** Class B static data, part A (name) */
+            MESSAGE_24A,
+            /** Class B static data, part B (type, call sign, dimensions) */
+            MESSAGE_24B,
+            MESSAGE_COUNT
+        };
+
+        /** The kind of station a target is reported as */
+        enum TargetClass
+        {
+            CLASS_A,
+            CLASS_B,
+            AID_TO_NAVIGATION
+        };
+
+        AISEncoder();
+
+        /** Whether a MMSI is the one of an aid to navigation, i.e. 99MIDXXXX
+         */
+        static bool isAidToNavigation(uint32_t mmsi);
+
+        /** Whether a MMSI is the one of a virtual aid to navigation, i.e.
+         * 99MID6XXX
+         */
+        static bool isVirtualAidToNavigation(uint32_t mmsi);
+
+        /** The class to report a target as, based on its position
+         *
+         * Aids to navigation are recognized by their MMSI. Class B
+         * transponders report neither a navigational status nor a rate of
+         * turn, so positions that have neither are reported as class B.
+         * This is also what tracked contacts look like
+         */
+        static TargetClass getTargetClass(ais_base::Position const& position);
+
+        /** Set of all target classes, as (1 << TargetClass) flags */
+        static const int ALL_TARGET_CLASSES =
+            (1 << CLASS_A) | (1 << CLASS_B) | (1 << AID_TO_NAVIGATION);
+
+        /** Parse a comma-separated list of target classes into a set of
+         * (1 << TargetClass) flags
+         *
+         * The class names are A, B and AtoN
+         *
+         * @throw std::invalid_argument if one of the names is not a target
+         *   class
+         */
+        static int parseTargetClasses(std::string const& names);
+
+        /** Number of bits of a message */
+        static size_t getMessageBits(Message message);
+
+        /** Set all fields to their "not available" value */
+        void clear();
+
+        /** Set the fields of a position */
+        void setPosition(ais_base::Position const& position);
+
+        /** Set the fields of static data
+         *
+         * The length and width are split equally between bow and stern, and
+         * port and starboard.
+         */
+        void setVessel(ais_base::VesselInformation const& vessel);
+
+        /** Encode a message from the fields set so far */
+        void encode(Message message);
+
+        /** Encode a position report as a message 1 */
+        void encode(ais_base::Position const& position);
+
+        /** Encode static data as a message 5 */
+        void encode(ais_base::VesselInformation const& vessel);
+
+        /** The newline-separated VDM sentences of the last message */
+        char const* data() const;
+        /** Size of the sentences of the last message */
+        size_t size() const;
+        /** The sentences of the last message, as a string */
+        std::string str() const;
+
+        /** Number of sentences of the last message */
+        size_t getFragmentCount() const;
+
+        /** The armored payload of the last message */
+        char const* getPayload() const;
+        /** Number of armored characters of the last message */
+        size_t getPayloadSize() const;
+        /** Number of padding bits at the end of the payload */
+        int getFillBits() const;
+
+        /** Identifiers of the numeric fields, used by the message tables */
+        enum Field
+        {
+            FIELD_MMSI,
+            FIELD_STATUS,
+            FIELD_RATE_OF_TURN,
+            FIELD_SPEED_OVER_GROUND,
+            FIELD_POSITION_ACCURACY,
+            FIELD_LONGITUDE,
+            FIELD_LATITUDE,
+            FIELD_COURSE_OVER_GROUND,
+            FIELD_HEADING,
+            FIELD_IMO,
+            FIELD_SHIP_TYPE,
+            FIELD_TO_BOW,
+            FIELD_TO_STERN,
+            FIELD_TO_PORT,
+            FIELD_TO_STARBOARD,
+            FIELD_DRAUGHT,
+            FIELD_VIRTUAL_AID,
+            FIELD_COUNT
+        };
+
+        /** Identifiers of the text fields, used by the message tables */
+        enum TextField
+        {
+            TEXT_CALL_SIGN,
+            TEXT_NAME,
+            /** Always empty, for the fields that Rock does not have */
+            TEXT_EMPTY,
+            TEXT_COUNT
+        };
+
+        /** Maximum number of characters of a text field */
+        static const size_t MAX_TEXT_SIZE = 20;
+
+    private:
+        void begin();
+        void putUInt(uint32_t value, unsigned int bits);
+        void putText(uint8_t const* sixbits, size_t characters);
+        void finish();
+        void frame();
+
+        /** The fields in their AIS representation, negative values in two's
+         * complement
+         */
+        uint32_t mFields[FIELD_COUNT];
+        /** The text fields as six-bit values, padded with zeros ('@') */
+        uint8_t mTexts[TEXT_COUNT][MAX_TEXT_SIZE];
+
+        /** Bits not yet armored, in the low bits */
+        uint64_t mAccumulator = 0;
+        unsigned int mAccumulatedBits = 0;
+
+        char mPayload[(MAX_BITS + 5) / 6];
+        size_t mPayloadSize = 0;
+        int mFillBits = 0;
+
+        /** The framed sentences. A sentence is at most 82 characters, plus
+         * the newline
+         */
+        char mSentences[((MAX_BITS + 5) / 6 / FRAGMENT_SIZE + 1) * 83];
+        size_t mSentencesSize = 0;
+        size_t mFragmentCount = 0;
+    };
+}
+
+#endif
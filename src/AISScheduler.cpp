@@ -0,0 +1,171 @@
+#include "AISScheduler.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace seabots_pi;
+
+static const double EARTH_RADIUS = 6371000;
+static const double KNOT = 1852.0 / 3600;
+
+AISScheduler::AISScheduler()
+{
+}
+
+AISScheduler::AISScheduler(Configuration const& configuration)
+    : mConfiguration(configuration)
+{
+}
+
+void AISScheduler::setConfiguration(Configuration const& configuration)
+{
+    mConfiguration = configuration;
+}
+
+AISScheduler::Configuration AISScheduler::getConfiguration() const
+{
+    return mConfiguration;
+}
+
+void AISScheduler::updateOwnship(Ownship const& ownship)
+{
+    mHasOwnship = !base::isUnknown(ownship.latitude.getRad()) &&
+                  !base::isUnknown(ownship.longitude.getRad());
+    mOwnship = ownship;
+}
+
+base::Time AISScheduler::getReportingInterval(double speed_over_ground)
+{
+    if (base::isUnknown(speed_over_ground)) {
+        return base::Time::fromSeconds(10);
+    }
+    else if (speed_over_ground < 3 * KNOT) {
+        return base::Time::fromSeconds(3 * 60);
+    }
+    else if (speed_over_ground < 14 * KNOT) {
+        return base::Time::fromSeconds(10);
+    }
+    else if (speed_over_ground < 23 * KNOT) {
+        return base::Time::fromSeconds(6);
+    }
+    return base::Time::fromSeconds(2);
+}
+
+/** Velocity in the NWU frame, zero if unknown */
+static void velocityNWU(
+    double speed, base::Angle const& course, double& north, double& west
+)
+{
+    if (base::isUnknown(speed) || base::isUnknown(course.getRad())) {
+        north = 0;
+        west = 0;
+        return;
+    }
+    north = speed * cos(course.getRad());
+    west = speed * sin(course.getRad());
+}
+
+AISScheduler::Decision AISScheduler::schedule(
+    ais_base::Position const& position, base::Time const& now
+) const
+{
+    Decision decision;
+    if (!mHasOwnship || now - mOwnship.time > mConfiguration.ownship_timeout ||
+        base::isUnknown(position.latitude.getRad()) ||
+        base::isUnknown(position.longitude.getRad())) {
+        decision.priority = true;
+        return decision;
+    }
+
+    // Local tangent plane around ownship, which is good enough at the
+    // ranges where the CPA matters
+    double own_lat = mOwnship.latitude.getRad();
+    double delta_lon = (position.longitude - mOwnship.longitude).getRad();
+    double x = (position.latitude.getRad() - own_lat) * EARTH_RADIUS;
+    double y = -delta_lon * cos(own_lat) * EARTH_RADIUS;
+    decision.range = sqrt(x * x + y * y);
+
+    double own_vx, own_vy, target_vx, target_vy;
+    velocityNWU(mOwnship.speed_over_ground, mOwnship.course_over_ground,
+                own_vx, own_vy);
+    velocityNWU(position.speed_over_ground, position.course_over_ground,
+                target_vx, target_vy);
+    double vx = target_vx - own_vx;
+    double vy = target_vy - own_vy;
+    double v2 = vx * vx + vy * vy;
+    if (v2 > 1e-6) {
+        decision.tcpa = -(x * vx + y * vy) / v2;
+        double t = max(decision.tcpa, 0.0);
+        decision.cpa = hypot(x + vx * t, y + vy * t);
+    }
+    else {
+        decision.cpa = decision.range;
+    }
+
+    bool converging = decision.cpa < mConfiguration.cpa_threshold &&
+        !base::isUnknown(decision.tcpa) && decision.tcpa >= 0 &&
+        decision.tcpa < mConfiguration.tcpa_threshold.toSeconds();
+    if (converging || decision.range < mConfiguration.near_range) {
+        decision.priority = true;
+        return decision;
+    }
+
+    double interval = getReportingInterval(position.speed_over_ground).toSeconds();
+    if (decision.range > mConfiguration.far_range) {
+        interval *= decision.range / mConfiguration.far_range;
+    }
+    decision.interval = min(
+        base::Time::fromSeconds(interval), mConfiguration.max_interval
+    );
+    return decision;
+}
+
+/** Number of tokens reserved to the priority targets */
+static double getReserve(AISScheduler::Configuration const& configuration)
+{
+    return configuration.priority_reserve * configuration.sentences_per_second;
+}
+
+/** Size of the token bucket, which is one second of budget */
+static double getCapacity(AISScheduler::Configuration const& configuration)
+{
+    // At low rates, a full bucket must still allow one sentence above the
+    // reserve
+    return max(
+        configuration.sentences_per_second, 1 + getReserve(configuration)
+    );
+}
+
+void AISScheduler::refill(base::Time const& now)
+{
+    double capacity = getCapacity(mConfiguration);
+    if (!mHasLastRefill || now < mLastRefill) {
+        mTokens = capacity;
+    }
+    else {
+        double elapsed = (now - mLastRefill).toSeconds();
+        mTokens = min(
+            capacity, mTokens + elapsed * mConfiguration.sentences_per_second
+        );
+    }
+    mHasLastRefill = true;
+    mLastRefill = now;
+}
+
+bool AISScheduler::hasBudget(Decision const& decision, base::Time const& now)
+{
+    if (mConfiguration.sentences_per_second <= 0) {
+        return true;
+    }
+
+    refill(now);
+    double reserve = decision.priority ? 0 : getReserve(mConfiguration);
+    return mTokens - reserve >= 1;
+}
+
+void AISScheduler::consume(size_t sentences)
+{
+    if (mConfiguration.sentences_per_second > 0) {
+        mTokens -= sentences;
+    }
+}
@@ -0,0 +1,147 @@
+#ifndef SEABOTS_PI_AISSCHEDULER_HPP
+#define SEABOTS_PI_AISSCHEDULER_HPP
+
+#include <cstdint>
+#include <base/Angle.hpp>
+#include <base/Float.hpp>
+#include <base/Time.hpp>
+#include <ais_base/Position.hpp>
+
+namespace seabots_pi {
+    /** Decides at which rate the AIS positions of each target are sent to
+     * OpenCPN, based on the last ownship fix
+     *
+     * Each target gets a minimum interval between two sent positions:
+     * - targets within the near range, or whose closest point of approach
+     *   (CPA) is within the CPA threshold in less than the TCPA threshold,
+     *   are sent at full rate. They are the priority targets.
+     * - other targets get the reporting interval of a class A transponder
+     *   at their speed: 3 minutes when under 3 knots, 10 seconds under
+     *   14 knots, 6 seconds under 23 knots and 2 seconds above.
+     * - beyond the far range, that interval grows linearly with the range.
+     *
+     * Intervals are at most the maximum interval. Without a recent ownship
+     * fix, all targets are sent at full rate.
+     *
+     * On top of this, the positions sent by all targets are limited by a
+     * token bucket of the given number of sentences per second, with a
+     * burst of one second. A fraction of the bucket is reserved for the
+     * priority targets, so that a crowded anchorage far away does not delay
+     * a converging target. All sent sentences are charged to the bucket,
+     * including the static data which is never delayed. The bucket may
+     * then go in debt, which delays the next positions.
+     *
+     * The positions are expected to be in Rock's convention, i.e. the
+     * course positive counter-clockwise from north.
+     *
+     * It must be used from a single thread
+     */
+    class AISScheduler
+    {
+    public:
+        struct Configuration
+        {
+            /** Range under which targets are sent at full rate, in meters */
+            double near_range = 2 * 1852;
+            /** Range from which the interval grows with the range, in
+             * meters
+             */
+            double far_range = 12 * 1852;
+            /** CPA under which a converging target is sent at full rate,
+             * in meters
+             */
+            double cpa_threshold = 1852;
+            /** Maximum time to the CPA for a target to be a priority target
+             */
+            base::Time tcpa_threshold = base::Time::fromSeconds(20 * 60);
+            /** Maximum interval between two sent positions of a target */
+            base::Time max_interval = base::Time::fromSeconds(3 * 60);
+            /** Time after which the ownship fix is not used anymore */
+            base::Time ownship_timeout = base::Time::fromSeconds(10);
+            /** Maximum number of AIS sentences sent per second, zero for
+             * no limit
+             */
+            double sentences_per_second = 50;
+            /** Fraction of the budget that only priority targets may use */
+            double priority_reserve = 0.25;
+        };
+
+        /** The last fix of the system */
+        struct Ownship
+        {
+            base::Time time;
+            base::Angle latitude;
+            base::Angle longitude;
+            /** Speed over ground in m/s */
+            double speed_over_ground = 0;
+            /** Course over ground in Rock's convention */
+            base::Angle course_over_ground;
+        };
+
+        /** The scheduling of a target position */
+        struct Decision
+        {
+            /** Minimum time since the last sent position of the target */
+            base::Time interval;
+            /** Whether the target may use the reserved part of the budget */
+            bool priority = false;
+            /** Range to ownship in meters, unknown without ownship fix */
+            double range = base::unknown<double>();
+            /** Distance at the closest point of approach in meters, unknown
+             * without ownship fix
+             */
+            double cpa = base::unknown<double>();
+            /** Time to the closest point of approach in seconds, negative
+             * if it is in the past. Unknown if there is no ownship fix or if the
+             * relative velocity is null
+             */
+            double tcpa = base::unknown<double>();
+        };
+
+        AISScheduler();
+        explicit AISScheduler(Configuration const& configuration);
+
+        void setConfiguration(Configuration const& configuration);
+        Configuration getConfiguration() const;
+
+        /** Update the ownship fix used to compute the ranges and CPAs */
+        void updateOwnship(Ownship const& ownship);
+
+        /** Reporting interval of a class A transponder for a given speed
+         *
+         * An unknown speed is handled as a moving target
+         */
+        static base::Time getReportingInterval(double speed_over_ground);
+
+        /** Compute the interval and priority of a target position */
+        Decision schedule(ais_base::Position const& position, base::Time const& now) const;
+
+        /** Whether there is budget left to send a position with the given
+         * decision
+         *
+         * It does not consume it, see consume()
+         */
+        bool hasBudget(Decision const& decision, base::Time const& now);
+
+        /** Consume the budget of sent sentences
+         *
+         * It is called for all sent messages with their number of
+         * fragments, static data included
+         */
+        void consume(size_t sentences = 1);
+
+    private:
+        Configuration mConfiguration;
+
+        bool mHasOwnship = false;
+        Ownship mOwnship;
+
+        bool mHasLastRefill = false;
+        double mTokens = 0;
+        base::Time mLastRefill;
+
+        void refill(base::Time const& now);
+    };
+}
+
+#endif
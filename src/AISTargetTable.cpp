@@ -0,0 +1,277 @@
+#include "AISTargetTable.hpp"
+#include <cstring>
+
+using namespace std;
+using namespace seabots_pi;
+
+namespace {
+    /** FNV-1a hash of the fields of a sample */
+    class Hasher
+    {
+    public:
+        Hasher& add(void const* data, size_t size)
+        {
+            auto bytes = static_cast<uint8_t const*>(data);
+            for (size_t i = 0; i < size; ++i) {
+                mHash = (mHash ^ bytes[i]) * 1099511628211ULL;
+            }
+            return *this;
+        }
+
+        Hasher& add(int64_t value)
+        {
+            return add(&value, sizeof(value));
+        }
+
+        Hasher& add(double value)
+        {
+            // Make sure that all NaNs hash to the same value
+            if (value != value) {
+                return add(static_cast<int64_t>(0x7ff8000000000000LL));
+            }
+            int64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return add(bits);
+        }
+
+        Hasher& add(string const& value)
+        {
+            add(static_cast<int64_t>(value.size()));
+            return add(value.data(), value.size());
+        }
+
+        uint64_t get() const { return mHash; }
+
+    private:
+        uint64_t mHash = 14695981039346656037ULL;
+    };
+}
+
+AISTargetTable::AISTargetTable()
+{
+}
+
+AISTargetTable::AISTargetTable(Configuration const& configuration)
+    : mConfiguration(configuration)
+{
+}
+
+void AISTargetTable::setConfiguration(Configuration const& configuration)
+{
+    mConfiguration = configuration;
+}
+
+AISTargetTable::Configuration AISTargetTable::getConfiguration() const
+{
+    return mConfiguration;
+}
+
+uint64_t AISTargetTable::hash(ais_base::Position const& position)
+{
+    return Hasher()
+        .add(static_cast<int64_t>(position.mmsi))
+        .add(static_cast<int64_t>(position.status))
+        .add(position.yaw_velocity)
+        .add(position.speed_over_ground)
+        .add(static_cast<int64_t>(position.high_accuracy_position))
+        .add(position.course_over_ground.getRad())
+        .add(position.yaw.getRad())
+        .add(position.latitude.getRad())
+        .add(position.longitude.getRad())
+        .get();
+}
+
+uint64_t AISTargetTable::hash(ais_base::VesselInformation const& vessel)
+{
+    return Hasher()
+        .add(static_cast<int64_t>(vessel.mmsi))
+        .add(static_cast<int64_t>(vessel.imo))
+        .add(vessel.call_sign)
+        .add(vessel.name)
+        .add(static_cast<int64_t>(vessel.ship_type))
+        .add(vessel.length)
+        .add(vessel.width)
+        .add(vessel.draft)
+        .get();
+}
+
+bool AISTargetTable::updatePosition(
+    ais_base::Position const& position, base::Time const& now,
+    base::Time const& min_interval, bool has_budget
+)
+{
+    uint64_t contentHash = hash(position);
+
+    lock_guard<mutex> lock(mMutex);
+    pruneIfNeeded(now);
+    Target& target = mTargets[position.mmsi];
+    target.statistics.last_update = now;
+    target.target_class = AISEncoder::getTargetClass(position);
+    if (target.has_position && target.position_hash == contentHash &&
+        now - target.last_position < mConfiguration.position_repeat_period) {
+        ++target.statistics.positions_suppressed;
+        ++mPositionSuppressedCount;
+        return false;
+    }
+    if (target.has_position && now - target.last_position < min_interval) {
+        ++target.statistics.positions_decimated;
+        ++mPositionDecimatedCount;
+        return false;
+    }
+    if (!has_budget) {
+        ++target.statistics.positions_over_budget;
+        ++mPositionOverBudgetCount;
+        return false;
+    }
+
+    target.has_position = true;
+    target.position_hash = contentHash;
+    target.last_position = now;
+    ++target.statistics.positions_sent;
+    return true;
+}
+
+bool AISTargetTable::updateStatic(
+    ais_base::VesselInformation const& vessel, base::Time const& now
+)
+{
+    uint64_t contentHash = hash(vessel);
+
+    lock_guard<mutex> lock(mMutex);
+    pruneIfNeeded(now);
+    Target& target = mTargets[vessel.mmsi];
+    target.statistics.last_update = now;
+    if (target.has_static && target.static_hash == contentHash &&
+        now - target.last_static < mConfiguration.static_period) {
+        ++target.statistics.static_suppressed;
+        ++mStaticSuppressedCount;
+        return false;
+    }
+
+    target.has_static = true;
+    target.static_hash = contentHash;
+    target.last_static = now;
+    target.vessel = vessel;
+    ++target.statistics.static_sent;
+    return true;
+}
+
+bool AISTargetTable::takeDueStatic(
+    uint32_t mmsi, base::Time const& now, ais_base::VesselInformation& vessel
+)
+{
+    lock_guard<mutex> lock(mMutex);
+    auto it = mTargets.find(mmsi);
+    if (it == mTargets.end()) {
+        return false;
+    }
+
+    Target& target = it->second;
+    if (!target.has_static ||
+        now - target.last_static < mConfiguration.static_period) {
+        return false;
+    }
+
+    target.last_static = now;
+    ++target.statistics.static_repeated;
+    ++mStaticRepeatedCount;
+    vessel = target.vessel;
+    return true;
+}
+
+bool AISTargetTable::getStatic(
+    uint32_t mmsi, ais_base::VesselInformation& vessel
+) const
+{
+    lock_guard<mutex> lock(mMutex);
+    auto it = mTargets.find(mmsi);
+    if (it == mTargets.end() || !it->second.has_static) {
+        return false;
+    }
+    vessel = it->second.vessel;
+    return true;
+}
+
+AISEncoder::TargetClass AISTargetTable::getTargetClass(uint32_t mmsi) const
+{
+    if (AISEncoder::isAidToNavigation(mmsi)) {
+        return AISEncoder::AID_TO_NAVIGATION;
+    }
+
+    lock_guard<mutex> lock(mMutex);
+    auto it = mTargets.find(mmsi);
+    if (it == mTargets.end()) {
+        return AISEncoder::CLASS_A;
+    }
+    return it->second.target_class;
+}
+
+void AISTargetTable::prune(base::Time const& now)
+{
+    lock_guard<mutex> lock(mMutex);
+    eraseStaleTargets(now);
+}
+
+void AISTargetTable::pruneIfNeeded(base::Time const& now)
+{
+    // Pruning is done at most once per timeout, so that targets are kept
+    // at most twice the timeout
+    if (now - mLastPrune >= mConfiguration.target_timeout) {
+        eraseStaleTargets(now);
+    }
+}
+
+void AISTargetTable::eraseStaleTargets(base::Time const& now)
+{
+    mLastPrune = now;
+    for (auto it = mTargets.begin(); it != mTargets.end(); ) {
+        if (now - it->second.statistics.last_update > mConfiguration.target_timeout) {
+            it = mTargets.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+size_t AISTargetTable::size() const
+{
+    lock_guard<mutex> lock(mMutex);
+    return mTargets.size();
+}
+
+bool AISTargetTable::getStatistics(uint32_t mmsi, TargetStatistics& statistics) const
+{
+    lock_guard<mutex> lock(mMutex);
+    auto it = mTargets.find(mmsi);
+    if (it == mTargets.end()) {
+        return false;
+    }
+    statistics = it->second.statistics;
+    return true;
+}
+
+uint64_t AISTargetTable::getPositionSuppressedCount() const
+{
+    return mPositionSuppressedCount;
+}
+
+uint64_t AISTargetTable::getPositionDecimatedCount() const
+{
+    return mPositionDecimatedCount;
+}
+
+uint64_t AISTargetTable::getPositionOverBudgetCount() const
+{
+    return mPositionOverBudgetCount;
+}
+
+uint64_t AISTargetTable::getStaticSuppressedCount() const
+{
+    return mStaticSuppressedCount;
+}
+
+uint64_t AISTargetTable::getStaticRepeatedCount() const
+{
+    return mStaticRepeatedCount;
+}
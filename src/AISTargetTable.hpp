@@ -0,0 +1,210 @@
+#ifndef SEABOTS_PI_AISTARGETTABLE_HPP
+#define SEABOTS_PI_AISTARGETTABLE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <base/Time.hpp>
+#include <ais_base/Position.hpp>
+#include <ais_base/VesselInformation.hpp>
+#include "AISEncoder.hpp"
+
+namespace seabots_pi {
+    /** State of the AIS targets sent to OpenCPN, by MMSI
+     *
+     * It decides which AIS updates are worth encoding and sending:
+     * - static data is sent only if its content changed, or if the static
+     *   period elapsed since it was last sent. The last static data is
+     *   kept, so that it can be re-sent at that cadence while only
+     *   positions are received, as a real transponder would.
+     * - a position report that is identical to the last sent one is
+     *   skipped, unless the position repeat period elapsed.
+     * - a position report received less than a minimum interval after the
+     *   last sent one is skipped. The interval is given by the caller, see
+     *   AISScheduler.
+     * - a position report that passes these checks is still skipped if the
+     *   caller has no budget left to send it. It is then not recorded, so
+     *   that the next position of the target is sent as soon as there is
+     *   budget.
+     *
+     * Content is compared through a hash of the fields that are encoded in
+     * the AIS messages. The sample times are not part of it.
+     *
+     * The table also keeps the class of each target, as given by its last
+     * position, so that its static data is encoded with the matching
+     * messages.
+     *
+     * Targets that have not been updated for the target timeout are
+     * forgotten.
+     *
+     * The update methods must be called from a single thread. The
+     * statistics may be read from any thread.
+     */
+    class AISTargetTable
+    {
+    public:
+        struct Configuration
+        {
+            /** Period at which unchanged static data is re-sent
+             *
+             * This is the reporting interval of the static data of real
+             * AIS transponders
+             */
+            base::Time static_period = base::Time::fromSeconds(6 * 60);
+            /** Period at which an unchanged position is re-sent
+             *
+             * This is the reporting interval of anchored class A
+             * transponders
+             */
+            base::Time position_repeat_period = base::Time::fromSeconds(3 * 60);
+            /** Time after which a target that received no update is
+             * forgotten
+             */
+            base::Time target_timeout = base::Time::fromSeconds(20 * 60);
+        };
+
+        /** Statistics of a single target */
+        struct TargetStatistics
+        {
+            uint64_t positions_sent = 0;
+            uint64_t positions_suppressed = 0;
+            /** Number of positions not sent because they were received
+             * within the minimum interval
+             */
+            uint64_t positions_decimated = 0;
+            /** Number of positions not sent because there was no budget */
+            uint64_t positions_over_budget = 0;
+            uint64_t static_sent = 0;
+            /** Number of static data updates not sent because they did not
+             * change
+             */
+            uint64_t static_suppressed = 0;
+            /** Number of times the stored static data was re-sent */
+            uint64_t static_repeated = 0;
+            base::Time last_update;
+        };
+
+        AISTargetTable();
+        explicit AISTargetTable(Configuration const& configuration);
+
+        void setConfiguration(Configuration const& configuration);
+        Configuration getConfiguration() const;
+
+        /** Hash of the fields of a position that are sent to OpenCPN */
+        static uint64_t hash(ais_base::Position const& position);
+
+        /** Hash of the fields of a vessel information that are sent to
+         * OpenCPN
+         */
+        static uint64_t hash(ais_base::VesselInformation const& vessel);
+
+        /** Whether this position should be sent
+         *
+         * A position for which it returns true becomes the reference for the
+         * next decisions
+         *
+         * @param min_interval minimum time since the last sent position of
+         *   the target
+         * @param has_budget whether the position can be sent if it passes
+         *   the other checks
+         */
+        bool updatePosition(
+            ais_base::Position const& position, base::Time const& now,
+            base::Time const& min_interval = base::Time(),
+            bool has_budget = true
+        );
+
+        /** Whether this static data should be sent
+         *
+         * If it returns true, it is stored as the target's static data
+         */
+        bool updateStatic(ais_base::VesselInformation const& vessel, base::Time const& now);
+
+        /** Get the stored static data of a target if it is due for a re-send
+         *
+         * If it returns true, the static data is considered sent at \c now
+         */
+        bool takeDueStatic(
+            uint32_t mmsi, base::Time const& now,
+            ais_base::VesselInformation& vessel
+        );
+
+        /** Get the stored static data of a target
+         *
+         * @return false if the target has no static data
+         */
+        bool getStatic(uint32_t mmsi, ais_base::VesselInformation& vessel) const;
+
+        /** The class of a target, as given by its last position
+         *
+         * Aids to navigation are recognized by their MMSI. Other targets
+         * without position are class A
+         */
+        AISEncoder::TargetClass getTargetClass(uint32_t mmsi) const;
+
+        /** Forget the targets that received no update for the target timeout
+         */
+        void prune(base::Time const& now);
+
+        /** Number of targets currently tracked */
+        size_t size() const;
+
+        /** Get the statistics of a target
+         *
+         * @return false if the target is unknown
+         */
+        bool getStatistics(uint32_t mmsi, TargetStatistics& statistics) const;
+
+        /** Total number of position reports not sent */
+        uint64_t getPositionSuppressedCount() const;
+        /** Total number of position reports not sent because of the minimum
+         * interval
+         */
+        uint64_t getPositionDecimatedCount() const;
+        /** Total number of position reports not sent because there was no
+         * budget
+         */
+        uint64_t getPositionOverBudgetCount() const;
+        /** Total number of static data updates not sent */
+        uint64_t getStaticSuppressedCount() const;
+        /** Total number of re-sends of the stored static data */
+        uint64_t getStaticRepeatedCount() const;
+
+    private:
+        struct Target
+        {
+            bool has_position = false;
+            uint64_t position_hash = 0;
+            base::Time last_position;
+            AISEncoder::TargetClass target_class = AISEncoder::CLASS_A;
+
+            bool has_static = false;
+            uint64_t static_hash = 0;
+            base::Time last_static;
+            ais_base::VesselInformation vessel;
+
+            TargetStatistics statistics;
+        };
+
+        Configuration mConfiguration;
+
+        /** Protects the targets against concurrent statistics reads */
+        mutable std::mutex mMutex;
+        std::unordered_map<uint32_t, Target> mTargets;
+        base::Time mLastPrune;
+
+        std::atomic<uint64_t> mPositionSuppressedCount { 0 };
+        std::atomic<uint64_t> mPositionDecimatedCount { 0 };
+        std::atomic<uint64_t> mPositionOverBudgetCount { 0 };
+        std::atomic<uint64_t> mStaticSuppressedCount { 0 };
+        std::atomic<uint64_t> mStaticRepeatedCount { 0 };
+
+        /** Both must be called with mMutex held */
+        void pruneIfNeeded(base::Time const& now);
+        void eraseStaleTargets(base::Time const& now);
+    };
+}
+
+#endif
@@ -0,0 +1,222 @@
+#include "ContactBuffer.hpp"
+#include <cmath>
+
+using namespace std;
+using namespace seabots_pi;
+
+size_t ContactBuffer::Snapshot::size() const
+{
+    return headings.size();
+}
+
+ContactBuffer::ContactBuffer()
+{
+}
+
+ContactBuffer::ContactBuffer(Configuration const& configuration)
+    : mConfiguration(configuration)
+{
+}
+
+void ContactBuffer::setConfiguration(Configuration const& configuration)
+{
+    lock_guard<mutex> lock(mMutex);
+    mConfiguration = configuration;
+}
+
+/** Direction of the glyph of a contact */
+static float getGlyphHeading(ais_base::Position const& position)
+{
+    if (!base::isUnknown(position.yaw.getRad())) {
+        return position.yaw.getRad();
+    }
+    else if (!base::isUnknown(position.course_over_ground.getRad())) {
+        return position.course_over_ground.getRad();
+    }
+    return 0;
+}
+
+/** Scale factor of the mercator projection at a given latitude */
+static float getMercatorScale(double latitude_deg)
+{
+    return 1 / cos(latitude_deg * M_PI / 180);
+}
+
+void ContactBuffer::updatePosition(
+    ais_base::Position const& position, base::Time const& now
+)
+{
+    double latitude = position.latitude.getDeg();
+    double longitude = position.longitude.getDeg();
+    if (base::isUnknown(latitude) || base::isUnknown(longitude)) {
+        return;
+    }
+
+    lock_guard<mutex> lock(mMutex);
+    pruneIfNeeded(now);
+    if (!mHasOrigin) {
+        mOrigin = mercator::Origin(latitude, longitude);
+        mHasOrigin = true;
+    }
+
+    size_t index;
+    auto it = mIndices.find(position.mmsi);
+    if (it != mIndices.end()) {
+        index = it->second;
+    }
+    else {
+        index = mMMSIs.size();
+        mIndices[position.mmsi] = index;
+        mMMSIs.push_back(position.mmsi);
+        mUpdateTimes.push_back(now);
+        mPositions.resize(mPositions.size() + 2);
+        mHeadings.push_back(0);
+        mClasses.push_back(0);
+        mLengths.push_back(0);
+        mLengthScales.push_back(0);
+    }
+
+    float scale = getMercatorScale(latitude);
+    if (mLengthScales[index] != scale) {
+        auto static_it = mStaticData.find(position.mmsi);
+        float length = static_it == mStaticData.end() ? 0 : static_it->second.length;
+        mLengthScales[index] = scale;
+        mLengths[index] = length * scale;
+    }
+
+    Eigen::Vector2d local = mOrigin.toLocal(latitude, longitude);
+    mUpdateTimes[index] = now;
+    mPositions[2 * index] = local.x();
+    mPositions[2 * index + 1] = local.y();
+    mHeadings[index] = getGlyphHeading(position);
+    mClasses[index] = AISEncoder::getTargetClass(position);
+    ++mRevision;
+}
+
+void ContactBuffer::updateStatic(
+    ais_base::VesselInformation const& vessel, base::Time const& now
+)
+{
+    float length = base::isUnknown(vessel.length) || vessel.length < 0 ?
+        0 : vessel.length;
+
+    lock_guard<mutex> lock(mMutex);
+    StaticData& data = mStaticData[vessel.mmsi];
+    data.length = length;
+    data.time = now;
+
+    auto it = mIndices.find(vessel.mmsi);
+    if (it == mIndices.end()) {
+        return;
+    }
+    float scaled = length * mLengthScales[it->second];
+    if (mLengths[it->second] != scaled) {
+        mLengths[it->second] = scaled;
+        ++mRevision;
+    }
+}
+
+bool ContactBuffer::prune(base::Time const& now)
+{
+    lock_guard<mutex> lock(mMutex);
+    return eraseStaleContacts(now);
+}
+
+void ContactBuffer::pruneIfNeeded(base::Time const& now)
+{
+    // As AISTargetTable, prune at most once per timeout
+    if (now - mLastPrune >= mConfiguration.timeout) {
+        eraseStaleContacts(now);
+    }
+}
+
+bool ContactBuffer::eraseStaleContacts(base::Time const& now)
+{
+    mLastPrune = now;
+    size_t count = mMMSIs.size();
+    for (size_t i = 0; i < mMMSIs.size(); ) {
+        if (now - mUpdateTimes[i] > mConfiguration.timeout) {
+            erase(i);
+        }
+        else {
+            ++i;
+        }
+    }
+    for (auto it = mStaticData.begin(); it != mStaticData.end(); ) {
+        if (now - it->second.time > mConfiguration.timeout &&
+            mIndices.find(it->first) == mIndices.end()) {
+            it = mStaticData.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    return mMMSIs.size() != count;
+}
+
+void ContactBuffer::erase(size_t index)
+{
+    size_t last = mMMSIs.size() - 1;
+    mIndices.erase(mMMSIs[index]);
+    if (index != last) {
+        mMMSIs[index] = mMMSIs[last];
+        mUpdateTimes[index] = mUpdateTimes[last];
+        mPositions[2 * index] = mPositions[2 * last];
+        mPositions[2 * index + 1] = mPositions[2 * last + 1];
+        mHeadings[index] = mHeadings[last];
+        mLengths[index] = mLengths[last];
+        mClasses[index] = mClasses[last];
+        mLengthScales[index] = mLengthScales[last];
+        mIndices[mMMSIs[index]] = index;
+    }
+
+    mMMSIs.pop_back();
+    mUpdateTimes.pop_back();
+    mPositions.resize(2 * last);
+    mHeadings.pop_back();
+    mLengths.pop_back();
+    mClasses.pop_back();
+    mLengthScales.pop_back();
+    ++mRevision;
+}
+
+bool ContactBuffer::getTargetClass(
+    uint32_t mmsi, AISEncoder::TargetClass& target_class
+) const
+{
+    lock_guard<mutex> lock(mMutex);
+    auto it = mIndices.find(mmsi);
+    if (it == mIndices.end()) {
+        return false;
+    }
+    target_class = static_cast<AISEncoder::TargetClass>(mClasses[it->second]);
+    return true;
+}
+
+size_t ContactBuffer::size() const
+{
+    lock_guard<mutex> lock(mMutex);
+    return mMMSIs.size();
+}
+
+uint64_t ContactBuffer::getRevision() const
+{
+    lock_guard<mutex> lock(mMutex);
+    return mRevision;
+}
+
+bool ContactBuffer::updateSnapshot(Snapshot& snapshot) const
+{
+    lock_guard<mutex> lock(mMutex);
+    if (snapshot.revision == mRevision) {
+        return false;
+    }
+
+    snapshot.revision = mRevision;
+    snapshot.origin = mOrigin;
+    snapshot.positions.assign(mPositions.begin(), mPositions.end());
+    snapshot.headings.assign(mHeadings.begin(), mHeadings.end());
+    snapshot.lengths.assign(mLengths.begin(), mLengths.end());
+    snapshot.classes.assign(mClasses.begin(), mClasses.end());
+    return true;
+}
@@ -0,0 +1,154 @@
+#ifndef SEABOTS_PI_CONTACTBUFFER_HPP
+#define SEABOTS_PI_CONTACTBUFFER_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <base/Time.hpp>
+#include <ais_base/Position.hpp>
+#include <ais_base/VesselInformation.hpp>
+#include "AISEncoder.hpp"
+#include "Mercator.hpp"
+
+namespace seabots_pi {
+    /** The contacts drawn by the plugin's own overlay, as a structure of
+     * arrays
+     *
+     * Each field of the contacts is stored in its own array, in the layout
+     * of the per-instance attributes of contacts.vert, so that the renderer
+     * uploads them as-is and draws all contacts in a single instanced call.
+     *
+     * Positions are mercator coordinates relative to an origin, which is
+     * the position of the first contact. As for the trajectories, the
+     * projection on the canvas is done on the GPU.
+     *
+     * Contacts that received no position for the timeout are removed by
+     * prune(), which must be called periodically so that contacts disappear
+     * even if no more positions arrive. Removal moves the last contact in
+     * place of the removed one, so the order of the contacts is not stable.
+     *
+     * Updates are done from a single thread. Pruning and snapshots may be
+     * done from any thread
+     */
+    class ContactBuffer
+    {
+    public:
+        struct Configuration
+        {
+            /** Time after which a contact that received no position is
+             * removed
+             */
+            base::Time timeout = base::Time::fromSeconds(10 * 60);
+        };
+
+        /** A copy of the contacts, for the renderer */
+        struct Snapshot
+        {
+            /** Incremented at each change of the contacts */
+            uint64_t revision = 0;
+            mercator::Origin origin;
+            /** Mercator coordinates relative to the origin, as (x, y) pairs
+             */
+            std::vector<float> positions;
+            /** Heading, or course if the heading is unknown, in radians
+             * counter-clockwise from north as in Rock. Zero if both are
+             * unknown
+             */
+            std::vector<float> headings;
+            /** Length in mercator meters, i.e. scaled by the secant of the
+             * contact's latitude as the positions are. Zero if unknown
+             */
+            std::vector<float> lengths;
+            /** AISEncoder::TargetClass of the contacts */
+            std::vector<float> classes;
+
+            /** Number of contacts */
+            size_t size() const;
+        };
+
+        ContactBuffer();
+        explicit ContactBuffer(Configuration const& configuration);
+
+        void setConfiguration(Configuration const& configuration);
+
+        /** Add a contact, or update its position */
+        void updatePosition(ais_base::Position const& position, base::Time const& now);
+
+        /** Update the length of a contact
+         *
+         * It is kept until the contact's first position if it is not
+         * known yet
+         */
+        void updateStatic(ais_base::VesselInformation const& vessel, base::Time const& now);
+
+        /** Remove the contacts that received no position for the timeout
+         *
+         * @return true if contacts were removed
+         */
+        bool prune(base::Time const& now);
+
+        /** Get the class of a contact
+         *
+         * @return false if the contact is unknown
+         */
+        bool getTargetClass(uint32_t mmsi, AISEncoder::TargetClass& target_class) const;
+
+        /** Number of contacts */
+        size_t size() const;
+
+        /** Current revision of the contacts */
+        uint64_t getRevision() const;
+
+        /** Copy the contacts into a snapshot if they changed since it was
+         * taken
+         *
+         * The snapshot's arrays are reused, so that the copy does not
+         * allocate once they reached the number of contacts
+         *
+         * @return true if the snapshot was updated
+         */
+        bool updateSnapshot(Snapshot& snapshot) const;
+
+    private:
+        struct StaticData
+        {
+            float length = 0;
+            base::Time time;
+        };
+
+        Configuration mConfiguration;
+
+        /** Protects all the fields below against concurrent snapshots */
+        mutable std::mutex mMutex;
+        uint64_t mRevision = 0;
+        bool mHasOrigin = false;
+        mercator::Origin mOrigin;
+
+        /** Index of each contact in the arrays */
+        std::unordered_map<uint32_t, size_t> mIndices;
+        std::vector<uint32_t> mMMSIs;
+        std::vector<base::Time> mUpdateTimes;
+        std::vector<float> mPositions;
+        std::vector<float> mHeadings;
+        std::vector<float> mLengths;
+        std::vector<float> mClasses;
+        /** Mercator scale factor at the latitude of each contact, to convert
+         * its length into mercator meters
+         */
+        std::vector<float> mLengthScales;
+
+        /** The static data of all targets, including the ones that have no
+         * position yet
+         */
+        std::unordered_map<uint32_t, StaticData> mStaticData;
+        base::Time mLastPrune;
+
+        /** All must be called with mMutex held */
+        void pruneIfNeeded(base::Time const& now);
+        bool eraseStaleContacts(base::Time const& now);
+        void erase(size_t index);
+    };
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include "Mercator.hpp"
+#include <cmath>
+#include <limits>
+
+using namespace std;
+using namespace seabots_pi;
+
+static const double DEG2RAD = M_PI / 180.0;
+
+double mercator::northing(double latitude_deg)
+{
+    double s = sin(latitude_deg * DEG2RAD);
+    return 0.5 * log((1 + s) / (1 - s)) * RADIUS;
+}
+
+double mercator::easting(double longitude_deg, double reference_longitude_deg)
+{
+    double delta = longitude_deg - reference_longitude_deg;
+    if (delta > 180) {
+        delta -= 360;
+    }
+    else if (delta < -180) {
+        delta += 360;
+    }
+    return delta * DEG2RAD * RADIUS;
+}
+
+mercator::Origin::Origin()
+{
+}
+
+mercator::Origin::Origin(double latitude_deg, double longitude_deg)
+    : latitude_deg(latitude_deg)
+    , longitude_deg(longitude_deg)
+    , northing(mercator::northing(latitude_deg))
+{
+}
+
+Eigen::Vector2d mercator::Origin::toLocal(
+    double latitude_deg, double longitude_deg
+) const
+{
+    return Eigen::Vector2d(
+        mercator::easting(longitude_deg, this->longitude_deg),
+        mercator::northing(latitude_deg) - northing
+    );
+}
+
+Eigen::AlignedBox2d mercator::Origin::toLocal(
+    double latitude_min_deg, double latitude_max_deg,
+    double longitude_min_deg, double longitude_max_deg
+) const
+{
+    Eigen::Vector2d min = toLocal(latitude_min_deg, longitude_min_deg);
+    Eigen::Vector2d max = toLocal(latitude_max_deg, longitude_max_deg);
+    if (longitude_max_deg - longitude_min_deg >= 360 || max.x() < min.x()) {
+        min.x() = -numeric_limits<double>::infinity();
+        max.x() = numeric_limits<double>::infinity();
+    }
+    return Eigen::AlignedBox2d(min, max);
+}
+
+Eigen::Vector2d mercator::getOriginOffset(
+    Origin const& origin, Viewport const& viewport
+)
+{
+    return Eigen::Vector2d(
+        easting(origin.longitude_deg, viewport.center_longitude_deg),
+        origin.northing - northing(viewport.center_latitude_deg)
+    );
+}
+
+Eigen::Vector2d mercator::toPixel(
+    Origin const& origin, Viewport const& viewport,
+    Eigen::Vector2d const& local
+)
+{
+    Eigen::Vector2d p = (local + getOriginOffset(origin, viewport)) * viewport.scale;
+
+    double c = cos(viewport.rotation_rad);
+    double s = sin(viewport.rotation_rad);
+    Eigen::Vector2d rotated(p.x() * c + p.y() * s, p.y() * c - p.x() * s);
+    return Eigen::Vector2d(
+        viewport.width / 2.0 + rotated.x(),
+        viewport.height / 2.0 - rotated.y()
+    );
+}
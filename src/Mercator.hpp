@@ -0,0 +1,94 @@
+#ifndef SEABOTS_PI_MERCATOR_HPP
+#define SEABOTS_PI_MERCATOR_HPP
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace seabots_pi {
+    namespace mercator {
+        /** Radius of the sphere used by OpenCPN's mercator projection
+         *
+         * This is the WGS84 semi-major axis scaled by the mercator k0 factor,
+         * as in OpenCPN's toSM
+         */
+        static const double RADIUS = 6378137.0 * 0.9996;
+
+        /** Mercator northing of a latitude, in meters from the equator */
+        double northing(double latitude_deg);
+
+        /** Mercator easting of a longitude relative to a reference longitude
+         *
+         * Both longitudes are brought in the same phase first, i.e. the
+         * shortest way around the antimeridian is used
+         */
+        double easting(double longitude_deg, double reference_longitude_deg);
+
+        /** Reference point of viewport-independent coordinates
+         *
+         * The local coordinates are the mercator easting and northing, in
+         * meters, relative to the origin. They are stored as float on the
+         * GPU, the origin itself being kept in double precision
+         */
+        struct Origin
+        {
+            double latitude_deg = 0;
+            double longitude_deg = 0;
+            double northing = 0;
+
+            Origin();
+            Origin(double latitude_deg, double longitude_deg);
+
+            /** Local coordinates of a lat/lon position */
+            Eigen::Vector2d toLocal(
+                double latitude_deg, double longitude_deg
+            ) const;
+
+            /** Local bounding box of a lat/lon bounding box
+             *
+             * The box is unbounded along the X axis if the longitude range
+             * crosses the antimeridian of the origin
+             */
+            Eigen::AlignedBox2d toLocal(
+                double latitude_min_deg, double latitude_max_deg,
+                double longitude_min_deg, double longitude_max_deg
+            ) const;
+        };
+
+        /** The parameters of a viewport needed to project positions on it
+         *
+         * This is the subset of OpenCPN's PlugIn_ViewPort that is used by its
+         * mercator projection
+         */
+        struct Viewport
+        {
+            double center_latitude_deg = 0;
+            double center_longitude_deg = 0;
+            /** Scale in pixels per meter */
+            double scale = 1;
+            /** Rotation of the view, including the chart skew if relevant */
+            double rotation_rad = 0;
+            int width = 0;
+            int height = 0;
+        };
+
+        /** Offset in meters from the viewport center to the given origin
+         *
+         * Adding this to local coordinates gives coordinates relative to the
+         * viewport center
+         */
+        Eigen::Vector2d getOriginOffset(
+            Origin const& origin, Viewport const& viewport
+        );
+
+        /** Pixel position of local coordinates in the given viewport
+         *
+         * This is the CPU equivalent of trajectory.vert
+         */
+        Eigen::Vector2d toPixel(
+            Origin const& origin, Viewport const& viewport,
+            Eigen::Vector2d const& local
+        );
+    }
+}
+
+#endif
@@ -1,6 +1,9 @@
 #include "NMEA.hpp"
-#include <iomanip>
-#include <sstream>
+#include "NMEALayout.hpp"
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
 
 using namespace std;
 using namespace seabots_pi;
@@ -15,7 +18,163 @@ static double headingToNMEA(base::Angle angle)
     return deg;
 }
 
-string nmea::createVTG(
+const size_t nmea::Sentence::CAPACITY;
+
+nmea::Sentence::Sentence()
+{
+}
+
+void nmea::Sentence::clear()
+{
+    mSize = 0;
+    mOverflow = false;
+}
+
+string nmea::Sentence::str() const
+{
+    return string(mData, mSize);
+}
+
+void nmea::Sentence::put(char c)
+{
+    if (mSize == CAPACITY) {
+        mOverflow = true;
+        return;
+    }
+    mData[mSize++] = c;
+}
+
+void nmea::Sentence::put(char const* str)
+{
+    put(str, strlen(str));
+}
+
+void nmea::Sentence::put(char const* str, size_t length)
+{
+    if (mSize + length > CAPACITY) {
+        length = CAPACITY - mSize;
+        mOverflow = true;
+    }
+    memcpy(mData + mSize, str, length);
+    mSize += length;
+}
+
+char* nmea::Sentence::append(size_t length)
+{
+    if (mSize + length > CAPACITY) {
+        mOverflow = true;
+        return nullptr;
+    }
+    char* result = mData + mSize;
+    mSize += length;
+    return result;
+}
+
+void nmea::Sentence::putUInt(uint64_t value, int width)
+{
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    for (int i = count; i < width; ++i) {
+        put('0');
+    }
+    while (count) {
+        put(digits[--count]);
+    }
+}
+
+void nmea::Sentence::putFixed(double value, int precision)
+{
+    static const double POW10[] = { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+    if (std::isnan(value)) {
+        put("nan");
+        return;
+    }
+    // Like iostream, negative values that round to zero keep their sign
+    if (std::signbit(value)) {
+        put('-');
+        value = -value;
+    }
+    if (std::isinf(value)) {
+        put("inf");
+        return;
+    }
+
+    // Round like printf, i.e. from the exact decimal value of the double,
+    // ties to even. The scale being exact, fma gives the rounding error of
+    // the product, which decides the values that look like ties
+    double factor = POW10[precision];
+    double product = value * factor;
+    double error = std::fma(value, factor, -product);
+    double integral = std::floor(product);
+    double fraction = product - integral;
+    uint64_t scaled = integral;
+    if (fraction > 0.5 ||
+        (fraction == 0.5 && (error > 0 || (error == 0 && scaled % 2 == 1)))) {
+        ++scaled;
+    }
+
+    uint64_t scale = factor;
+    putUInt(scaled / scale);
+    if (precision > 0) {
+        put('.');
+        putUInt(scaled % scale, precision);
+    }
+}
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+void nmea::putChecksum(Sentence& sentence, uint8_t checksum)
+{
+    char digits[2] = { HEX_DIGITS[checksum >> 4], HEX_DIGITS[checksum & 0xF] };
+    sentence.put(digits, 2);
+}
+
+/** Write '$', the payload, '*' and the checksum in a single pass
+ *
+ * \c out must have room for length + 4 characters
+ */
+static void frame(char* out, char const* payload, size_t length)
+{
+    uint8_t checksum = 0;
+    *out++ = '$';
+    for (size_t i = 0; i < length; ++i) {
+        char c = payload[i];
+        checksum ^= c;
+        out[i] = c;
+    }
+    out += length;
+    out[0] = '*';
+    out[1] = HEX_DIGITS[checksum >> 4];
+    out[2] = HEX_DIGITS[checksum & 0xF];
+}
+
+void nmea::frameSentence(Sentence& sentence, char const* payload, size_t length)
+{
+    sentence.clear();
+    if (char* out = sentence.append(length + 4)) {
+        frame(out, payload, length);
+    }
+}
+
+void nmea::finalizeSentence(Sentence& sentence)
+{
+    uint8_t checksum = 0;
+    char const* data = sentence.data();
+    for (size_t i = 1; i < sentence.size(); ++i) {
+        checksum ^= data[i];
+    }
+    sentence.put('*');
+    putChecksum(sentence, checksum);
+}
+
+void nmea::encodeVTG(
+    Sentence& sentence,
     base::Angle track_true_north,
     base::Angle track_magnetic,
     double speed)
@@ -26,51 +185,283 @@ string nmea::createVTG(
         speed = -speed;
     }
 
-    double track_true_north_nmea = headingToNMEA(track_true_north);
-    double track_magnetic_nmea = headingToNMEA(track_magnetic);
     double speed_kmh = speed * 3.6;
+    layout::VTG::encode(sentence,
+        headingToNMEA(track_true_north), headingToNMEA(track_magnetic),
+        speed_kmh / KNOT_TO_KMH, speed_kmh);
+}
 
-    ostringstream str;
-    str << "SBVTG,"
-        << fixed << setprecision(2) << track_true_north_nmea << ",T,"
-        << fixed << setprecision(2) << track_magnetic_nmea << ",M,"
-        << fixed << setprecision(2) << (speed_kmh / KNOT_TO_KMH) << ",N,"
-        << fixed << setprecision(2) << speed_kmh << ",K";
+void nmea::encodeHDT(Sentence& sentence, base::Angle heading)
+{
+    layout::HDT::encode(sentence, headingToNMEA(heading));
+}
+
+void nmea::encodeRMC(
+    Sentence& sentence,
+    base::Time const& time, base::Angle latitude, base::Angle longitude,
+    double speed_over_ground, base::Angle track, base::Angle magnetic_variation)
+{
+    layout::RMC::encode(sentence, time, latitude, longitude,
+        speed_over_ground * MS_TO_KNOT, headingToNMEA(track), time,
+        magnetic_variation.getDeg());
+}
+
+void nmea::encodeGGA(
+    Sentence& sentence,
+    base::Time const& time, base::Angle latitude, base::Angle longitude,
+    int quality, int satellites, double altitude)
+{
+    layout::GGA::encode(sentence, time, latitude, longitude,
+        quality, satellites, altitude);
+}
 
-    return nmea::createPackage(str.str());
+void nmea::encodeZDA(Sentence& sentence, base::Time const& time)
+{
+    layout::ZDA::encode(sentence, time, time);
+}
+
+void nmea::encodeROT(Sentence& sentence, double yaw_rate)
+{
+    // NMEA goes positive towards starboard, in degrees per minute
+    layout::ROT::encode(sentence, -yaw_rate * 180 / M_PI * 60);
+}
+
+int nmea::parsePoseSentences(string const& names)
+{
+    static const pair<char const*, int> SENTENCES[] = {
+        { "RMC", POSE_RMC }, { "HDT", POSE_HDT }, { "VTG", POSE_VTG },
+        { "GGA", POSE_GGA }, { "ZDA", POSE_ZDA }, { "ROT", POSE_ROT }
+    };
+
+    int result = 0;
+    size_t start = 0;
+    while (start <= names.size()) {
+        size_t end = names.find(',', start);
+        if (end == string::npos) {
+            end = names.size();
+        }
+        string name = names.substr(start, end - start);
+        start = end + 1;
+        if (name.empty()) {
+            continue;
+        }
+
+        bool found = false;
+        for (auto const& sentence : SENTENCES) {
+            if (name == sentence.first) {
+                result |= sentence.second;
+                found = true;
+            }
+        }
+        if (!found) {
+            throw invalid_argument("'" + name + "' is not a pose sentence");
+        }
+    }
+    return result;
+}
+
+void nmea::encodePoseBurst(string& burst, Pose const& pose, int sentences)
+{
+    burst.clear();
+
+    Sentence sentence;
+    auto append = [&burst, &sentence] {
+        if (!burst.empty()) {
+            burst += '\n';
+        }
+        burst.append(sentence.data(), sentence.size());
+    };
+
+    if (sentences & POSE_RMC) {
+        encodeRMC(sentence, pose.time, pose.latitude, pose.longitude,
+            pose.speed_over_ground, pose.track, base::Angle::fromRad(0));
+        append();
+    }
+    if (sentences & POSE_HDT) {
+        encodeHDT(sentence, pose.heading);
+        append();
+    }
+    if (sentences & POSE_VTG) {
+        // We have no magnetic variation, see RMC above
+        encodeVTG(sentence, pose.track, pose.track, pose.speed_over_ground);
+        append();
+    }
+    if (sentences & POSE_GGA) {
+        encodeGGA(sentence, pose.time, pose.latitude, pose.longitude,
+            1, 0, pose.altitude);
+        append();
+    }
+    if (sentences & POSE_ZDA) {
+        encodeZDA(sentence, pose.time);
+        append();
+    }
+    if (sentences & POSE_ROT) {
+        encodeROT(sentence, pose.yaw_rate);
+        append();
+    }
+}
+
+static const int64_t SECONDS_PER_DAY = 24 * 3600;
+
+static int64_t floorDiv(int64_t value, int64_t divisor)
+{
+    int64_t result = value / divisor;
+    return (value % divisor < 0) ? result - 1 : result;
+}
+
+static void putTwoDigits(char* out, int value)
+{
+    out[0] = '0' + value / 10;
+    out[1] = '0' + value % 10;
+}
+
+void nmea::TimeFormatter::updateSecond(int64_t second)
+{
+    if (second == mSecond) {
+        return;
+    }
+    mSecond = second;
+
+    int64_t day = floorDiv(second, SECONDS_PER_DAY);
+    int second_of_day = second - day * SECONDS_PER_DAY;
+    putTwoDigits(mHHMMSS, second_of_day / 3600);
+    putTwoDigits(mHHMMSS + 2, second_of_day / 60 % 60);
+    putTwoDigits(mHHMMSS + 4, second_of_day % 60);
+
+    if (day == mDay) {
+        return;
+    }
+    mDay = day;
+
+    time_t unix_time = second;
+    struct tm utc_time;
+    gmtime_r(&unix_time, &utc_time);
+    putTwoDigits(mDDMMYY, utc_time.tm_mday);
+    putTwoDigits(mDDMMYY + 2, utc_time.tm_mon + 1);
+    putTwoDigits(mDDMMYY + 4, utc_time.tm_year % 100);
+
+    int year = utc_time.tm_year + 1900;
+    putTwoDigits(mDateFields, utc_time.tm_mday);
+    mDateFields[2] = ',';
+    putTwoDigits(mDateFields + 3, utc_time.tm_mon + 1);
+    mDateFields[5] = ',';
+    putTwoDigits(mDateFields + 6, year / 100);
+    putTwoDigits(mDateFields + 8, year % 100);
+}
+
+void nmea::TimeFormatter::putTime(Sentence& sentence, base::Time const& time)
+{
+    int64_t us = time.toMicroseconds();
+    int64_t second = floorDiv(us, 1000000);
+    updateSecond(second);
+
+    if (char* out = sentence.append(9)) {
+        memcpy(out, mHHMMSS, 6);
+        out[6] = '.';
+        putTwoDigits(out + 7, (us - second * 1000000) / 10000);
+    }
+}
+
+void nmea::TimeFormatter::putDate(Sentence& sentence, base::Time const& time)
+{
+    updateSecond(floorDiv(time.toMicroseconds(), 1000000));
+    sentence.put(mDDMMYY, 6);
+}
+
+void nmea::TimeFormatter::putDateFields(Sentence& sentence, base::Time const& time)
+{
+    updateSecond(floorDiv(time.toMicroseconds(), 1000000));
+    sentence.put(mDateFields, 10);
+}
+
+static thread_local nmea::TimeFormatter threadTimeFormatter;
+
+void nmea::layout::DateFields::write(Sentence& sentence, base::Time const& time)
+{
+    threadTimeFormatter.putDateFields(sentence, time);
+}
+
+void nmea::putTime(Sentence& sentence, base::Time const& time)
+{
+    threadTimeFormatter.putTime(sentence, time);
+}
+
+void nmea::putDate(Sentence& sentence, base::Time const& time)
+{
+    threadTimeFormatter.putDate(sentence, time);
+}
+
+void nmea::putAngleDMS(Sentence& sentence, base::Angle const& angle, int dwidth)
+{
+    double i_as_d;
+    double f = modf(fabs(angle.getDeg() * 60), &i_as_d);
+    int i = round(i_as_d);
+
+    int d = i / 60;
+    int m = i % 60;
+
+    sentence.putUInt(d, dwidth);
+    sentence.putUInt(m, 2);
+    sentence.put('.');
+    sentence.putUInt(static_cast<int>(f * 1000), 3);
+}
+
+string nmea::createVTG(
+    base::Angle track_true_north,
+    base::Angle track_magnetic,
+    double speed)
+{
+    Sentence sentence;
+    encodeVTG(sentence, track_true_north, track_magnetic, speed);
+    return sentence.str();
 }
 
 string nmea::createHDT(base::Angle heading)
 {
-    ostringstream str;
-    str << "SBHDT," << headingToNMEA(heading) << ",T";
-    return createPackage(str.str());
+    Sentence sentence;
+    encodeHDT(sentence, heading);
+    return sentence.str();
 }
 
 string nmea::createRMC(
     base::Time const& time, base::Angle latitude, base::Angle longitude,
     double speed_over_ground, base::Angle track, base::Angle magnetic_variation)
 {
-    auto time_and_date = getTimeAndDate(time);
+    Sentence sentence;
+    encodeRMC(sentence, time, latitude, longitude,
+        speed_over_ground, track, magnetic_variation);
+    return sentence.str();
+}
+
+string nmea::createGGA(
+    base::Time const& time, base::Angle latitude, base::Angle longitude,
+    int quality, int satellites, double altitude)
+{
+    Sentence sentence;
+    encodeGGA(sentence, time, latitude, longitude,
+        quality, satellites, altitude);
+    return sentence.str();
+}
 
-    ostringstream str;
-    str << "SBRMC,"
-        << time_and_date.first << ",A,"
-        << getAngleDMS(latitude, 2)  << "," << (latitude.getRad() > 0 ? "N," : "S,")
-        << getAngleDMS(longitude, 3) << "," << (longitude.getRad() > 0 ? "E," : "W,")
-        << fixed << setprecision(1)
-        << speed_over_ground * MS_TO_KNOT << ","
-        << headingToNMEA(track) << ","
-        << time_and_date.second << ","
-        << fabs(magnetic_variation.getDeg()) << "," << (magnetic_variation.getRad() > 0 ? "E" : "W");
+string nmea::createZDA(base::Time const& time)
+{
+    Sentence sentence;
+    encodeZDA(sentence, time);
+    return sentence.str();
+}
 
-    return createPackage(str.str());
+string nmea::createROT(double yaw_rate)
+{
+    Sentence sentence;
+    encodeROT(sentence, yaw_rate);
+    return sentence.str();
 }
 
 string nmea::createPackage(string payload)
 {
-    string checksum = nmea::computeChecksum(payload);
-    return "$" + payload + "*" + checksum;
+    string result(payload.size() + 4, '\0');
+    frame(&result[0], payload.data(), payload.size());
+    return result;
 }
 
 string nmea::computeChecksum(string payload)
@@ -81,40 +472,23 @@ string nmea::computeChecksum(string payload)
         checksum = checksum ^ payload[i];
     }
 
-    ostringstream str;
-    str << uppercase << hex << static_cast<unsigned int>(checksum);
+    Sentence str;
+    putChecksum(str, checksum);
     return str.str();
 }
 
 pair<string, string> nmea::getTimeAndDate(base::Time const& time)
 {
-    time_t unix_time = time.toMicroseconds() / 1000000;
-    struct tm* utc_time = gmtime(&unix_time);
-
-    char buffer[32];
-    strftime(buffer, 32, "%H%M%S.", utc_time);
-    int centisecs = (time.toMilliseconds() / 10) % 100;
-    snprintf(buffer + 7, 32 - 7, "%02i", centisecs);
-    string hhmmss(buffer);
-
-    strftime(buffer, 32, "%d%m%y", utc_time);
-    string ddmmyy(buffer);
-    return make_pair(hhmmss, ddmmyy);
+    Sentence hhmmss;
+    putTime(hhmmss, time);
+    Sentence ddmmyy;
+    putDate(ddmmyy, time);
+    return make_pair(hhmmss.str(), ddmmyy.str());
 }
 
 string nmea::getAngleDMS(base::Angle const& angle, int dwidth)
 {
-    double i_as_d;
-    double f = modf(fabs(angle.getDeg() * 60), &i_as_d);
-    int i = round(i_as_d);
-
-    int d = i / 60;
-    int m = i % 60;
-
-    ostringstream str;
-    str << setfill('0')
-        << setw(dwidth) << d
-        << setw(2) << m << "."
-        << setw(3) << static_cast<int>(f * 1000);
+    Sentence str;
+    putAngleDMS(str, angle, dwidth);
     return str.str();
 }
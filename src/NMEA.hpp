@@ -2,6 +2,8 @@
 #define SEABOTS_PI_NMEA_HPP
 
 #include <string>
+#include <cstdint>
+#include <limits>
 #include <base/Angle.hpp>
 #include <base/Time.hpp>
 
@@ -13,6 +15,207 @@ namespace seabots_pi {
         static const double KNOT_TO_KMH = 1.852;
         static const double MS_TO_KNOT = 3.6 / KNOT_TO_KMH;
 
+        /** Fixed-capacity buffer in which the allocation-free encoders
+         * format a sentence
+         *
+         * Numbers are formatted without iostreams or printf, and therefore
+         * do not depend on the process locale. Characters written past the
+         * capacity are dropped, which is reported by hasOverflowed
+         */
+        class Sentence
+        {
+        public:
+            /** Capacity of the buffer. The NMEA standard limits sentences to
+             * 82 characters including the CR/LF
+             */
+            static const size_t CAPACITY = 96;
+
+            Sentence();
+
+            char const* data() const { return mData; }
+            size_t size() const { return mSize; }
+            bool hasOverflowed() const { return mOverflow; }
+            void clear();
+
+            /** Copy the sentence into a string, which allocates */
+            std::string str() const;
+
+            void put(char c);
+            void put(char const* str);
+            void put(char const* str, size_t length);
+
+            /** Grow the sentence by \c length characters and return a
+             * pointer to them, to be written by the caller
+             *
+             * Returns nullptr and reports an overflow if the sentence would
+             * not fit in the buffer
+             */
+            char* append(size_t length);
+
+            /** Write an unsigned integer, left-padded with zeroes to the
+             * given width
+             */
+            void putUInt(uint64_t value, int width = 0);
+
+            /** Write a value with a fixed number of decimals */
+            void putFixed(double value, int precision);
+
+        private:
+            char mData[CAPACITY];
+            size_t mSize = 0;
+            bool mOverflow = false;
+        };
+
+        /** Formatting of UTC times and dates that caches the current day and
+         * second
+         *
+         * The date is only recomputed when the day changes and the hhmmss
+         * part when the second changes, the centiseconds being patched on
+         * each call. An instance must not be shared between threads, but
+         * separate instances can be used concurrently.
+         *
+         * The putTime and putDate free functions use one formatter per thread
+         */
+        class TimeFormatter
+        {
+        public:
+            /** Write a UTC time in the hhmmss.ss format */
+            void putTime(Sentence& sentence, base::Time const& time);
+
+            /** Write a UTC date in the ddmmyy format */
+            void putDate(Sentence& sentence, base::Time const& time);
+
+            /** Write a UTC date as the dd,mm,yyyy fields of ZDA */
+            void putDateFields(Sentence& sentence, base::Time const& time);
+
+        private:
+            int64_t mSecond = std::numeric_limits<int64_t>::min();
+            int64_t mDay = std::numeric_limits<int64_t>::min();
+            char mHHMMSS[6];
+            char mDDMMYY[6];
+            char mDateFields[10];
+
+            void updateSecond(int64_t second);
+        };
+
+        /** Recommended minimum navigation information
+         *
+         * Allocation-free version of createRMC
+         */
+        void encodeRMC(
+            Sentence& sentence,
+            base::Time const& time, base::Angle latitude, base::Angle longitude,
+            double speed_over_ground, base::Angle track, base::Angle magnetic_variation);
+
+        /** Velocities
+         *
+         * Allocation-free version of createVTG
+         */
+        void encodeVTG(
+            Sentence& sentence,
+            base::Angle track_true_north,
+            base::Angle track_magnetic, double speed);
+
+        /** Heading
+         *
+         * Allocation-free version of createHDT
+         */
+        void encodeHDT(Sentence& sentence, base::Angle heading);
+
+        /** Global positioning system fix data
+         *
+         * The HDOP and geoid separation fields are left empty
+         *
+         * @param quality fix quality, 0 for invalid, 1 for a GPS fix
+         * @param altitude altitude above the geoid in meters
+         */
+        void encodeGGA(
+            Sentence& sentence,
+            base::Time const& time, base::Angle latitude, base::Angle longitude,
+            int quality, int satellites, double altitude);
+
+        /** Time and date, in UTC */
+        void encodeZDA(Sentence& sentence, base::Time const& time);
+
+        /** Rate of turn
+         *
+         * @param yaw_rate the yaw rate in rad/s, positive counter-clockwise
+         *   as in Rock. It is converted into NMEA's degrees per minute,
+         *   positive towards starboard
+         */
+        void encodeROT(Sentence& sentence, double yaw_rate);
+
+        /** Sentences that can be part of a pose burst */
+        enum PoseSentences
+        {
+            POSE_RMC = 0x01,
+            POSE_HDT = 0x02,
+            POSE_VTG = 0x04,
+            POSE_GGA = 0x08,
+            POSE_ZDA = 0x10,
+            POSE_ROT = 0x20,
+            POSE_ALL = 0x3F
+        };
+
+        /** Parse a comma-separated list of sentence names into a set of
+         * PoseSentences flags
+         *
+         * @throw std::invalid_argument if one of the names is not a
+         *   sentence of the pose burst
+         */
+        int parsePoseSentences(std::string const& names);
+
+        /** The data a pose burst is generated from */
+        struct Pose
+        {
+            base::Time time;
+            base::Angle latitude;
+            base::Angle longitude;
+            /** Altitude above the geoid in meters */
+            double altitude = 0;
+            /** Speed over ground in m/s */
+            double speed_over_ground = 0;
+            /** Course over ground, in Rock's convention */
+            base::Angle track;
+            /** Heading, in Rock's convention */
+            base::Angle heading;
+            /** Yaw rate in rad/s, positive counter-clockwise */
+            double yaw_rate = 0;
+        };
+
+        /** Encode a set of sentences from the same pose
+         *
+         * The sentences are written in \c burst separated by newlines, in
+         * the order of the PoseSentences flags. \c burst is cleared first,
+         * so its capacity is reused across calls
+         *
+         * @param sentences set of PoseSentences flags
+         */
+        void encodePoseBurst(std::string& burst, Pose const& pose, int sentences);
+
+        /** Add the checksum to a sentence made of '$' and the payload */
+        void finalizeSentence(Sentence& sentence);
+
+        /** Write the '$' delimiter, the payload and its checksum in a single
+         * pass
+         *
+         * The sentence is cleared first. It reports an overflow if the framed
+         * payload does not fit in its capacity
+         */
+        void frameSentence(Sentence& sentence, char const* payload, size_t length);
+
+        /** Write a checksum as two hexadecimal digits */
+        void putChecksum(Sentence& sentence, uint8_t checksum);
+
+        /** Write a UTC time in the hhmmss.ss format */
+        void putTime(Sentence& sentence, base::Time const& time);
+
+        /** Write a UTC date in the ddmmyy format */
+        void putDate(Sentence& sentence, base::Time const& time);
+
+        /** Write an angle in ddmm.mmm format */
+        void putAngleDMS(Sentence& sentence, base::Angle const& angle, int dwidth);
+
         /**
          * Recommended minimum navigation information
          */
@@ -32,6 +235,23 @@ namespace seabots_pi {
          */
         std::string createHDT(base::Angle heading);
 
+        /**
+         * Global positioning system fix data
+         */
+        std::string createGGA(
+            base::Time const& time, base::Angle latitude, base::Angle longitude,
+            int quality, int satellites, double altitude);
+
+        /**
+         * Time and date
+         */
+        std::string createZDA(base::Time const& time);
+
+        /**
+         * Rate of turn
+         */
+        std::string createROT(double yaw_rate);
+
         /** Add delimiters and checksum to a NMEA payload */
         std::string createPackage(std::string payload);
 
@@ -46,4 +266,4 @@ namespace seabots_pi {
     }
 }
 
-#endif
\ No newline at end of file
+#endif
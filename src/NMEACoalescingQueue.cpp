@@ -0,0 +1,62 @@
+#include "NMEACoalescingQueue.hpp"
+#include <algorithm>
+
+using namespace std;
+using namespace seabots_pi;
+
+static size_t countSentences(string const& sentences)
+{
+    return count(sentences.begin(), sentences.end(), '\n') + 1;
+}
+
+void NMEACoalescingQueue::push(Key const& key, string sentences)
+{
+    auto it = mSequences.find(key);
+    if (it != mSequences.end()) {
+        Entry& entry = mEntries[it->second - mFrontSequence];
+        mCoalescedCount += entry.count;
+        entry.count = countSentences(sentences);
+        entry.sentences = move(sentences);
+        return;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.count = countSentences(sentences);
+    entry.sentences = move(sentences);
+    mSequences[key] = mFrontSequence + mEntries.size();
+    mEntries.push_back(move(entry));
+}
+
+size_t NMEACoalescingQueue::flush(size_t budget, Sink const& sink)
+{
+    size_t sent = 0;
+    while (!mEntries.empty()) {
+        Entry& entry = mEntries.front();
+        if (budget && sent && sent + entry.count > budget) {
+            break;
+        }
+
+        sink(entry.sentences);
+        sent += entry.count;
+        mSequences.erase(entry.key);
+        mEntries.pop_front();
+        ++mFrontSequence;
+    }
+    return sent;
+}
+
+size_t NMEACoalescingQueue::size() const
+{
+    return mEntries.size();
+}
+
+bool NMEACoalescingQueue::empty() const
+{
+    return mEntries.empty();
+}
+
+uint64_t NMEACoalescingQueue::getCoalescedCount() const
+{
+    return mCoalescedCount;
+}
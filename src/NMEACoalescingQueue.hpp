@@ -0,0 +1,94 @@
+#ifndef SEABOTS_PI_NMEACOALESCINGQUEUE_HPP
+#define SEABOTS_PI_NMEACOALESCINGQUEUE_HPP
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+namespace seabots_pi {
+    /** Queue of NMEA sentences waiting to be sent to OpenCPN, in which only
+     * the latest sentences for a given key are kept
+     *
+     * The key identifies the stream the sentences belong to, e.g. the AIS
+     * position reports of a given MMSI. Pushing sentences for a key that is
+     * already pending replaces them, keeping the position of the pending
+     * entry in the queue. An entry may hold several newline-separated
+     * sentences, e.g. multi-fragment VDMs or a pose burst, which are always
+     * sent together.
+     *
+     * It is not thread-safe
+     */
+    class NMEACoalescingQueue
+    {
+    public:
+        struct Key
+        {
+            uint32_t type = 0;
+            uint32_t id = 0;
+
+            Key() {}
+            Key(uint32_t type, uint32_t id)
+                : type(type), id(id) {}
+
+            bool operator ==(Key const& other) const
+            {
+                return type == other.type && id == other.id;
+            }
+        };
+
+        typedef std::function<void(std::string const&)> Sink;
+
+        /** Queue sentences, replacing the pending sentences with the same key
+         */
+        void push(Key const& key, std::string sentences);
+
+        /** Send the oldest entries to the sink, within the given budget
+         *
+         * Entries are sent as long as the total number of sentences stays
+         * within the budget. The oldest entry is always sent, even if it is
+         * larger than the budget, so that the queue always makes progress
+         *
+         * @param budget maximum number of sentences, zero for no limit
+         * @return the number of sentences sent
+         */
+        size_t flush(size_t budget, Sink const& sink);
+
+        /** Number of pending entries */
+        size_t size() const;
+        bool empty() const;
+
+        /** Number of sentences that were replaced before being sent */
+        uint64_t getCoalescedCount() const;
+
+    private:
+        struct KeyHash
+        {
+            size_t operator ()(Key const& key) const
+            {
+                return std::hash<uint64_t>()(
+                    static_cast<uint64_t>(key.type) << 32 | key.id
+                );
+            }
+        };
+
+        struct Entry
+        {
+            Key key;
+            std::string sentences;
+            size_t count = 0;
+        };
+
+        /** Pending entries, oldest first */
+        std::deque<Entry> mEntries;
+        /** Sequence number of the front of mEntries */
+        uint64_t mFrontSequence = 0;
+        /** Sequence number of the pending entry of each key */
+        std::unordered_map<Key, uint64_t, KeyHash> mSequences;
+
+        uint64_t mCoalescedCount = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,255 @@
+#include "NMEAIngest.hpp"
+#include "NMEAParser.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+/** Period at which the ingest thread checks the queue if it was not
+ * notified
+ */
+static const chrono::milliseconds POLL_PERIOD(100);
+
+NMEAIngest::NMEAIngest(size_t queueSize, Outputs const& outputs)
+    : mOutputs(outputs)
+    , mQueue(queueSize)
+{
+}
+
+NMEAIngest::~NMEAIngest()
+{
+    stop();
+}
+
+void NMEAIngest::start()
+{
+    if (mThread.joinable()) {
+        return;
+    }
+    mQuit = false;
+    mThread = thread([this] { run(); });
+}
+
+void NMEAIngest::stop()
+{
+    if (!mThread.joinable()) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(mMutex);
+        mQuit = true;
+    }
+    mCondition.notify_one();
+    mThread.join();
+}
+
+bool NMEAIngest::push(base::Time const& time, char const* sentence, size_t length)
+{
+    ReceivedSentence received;
+    received.time = time;
+    received.sentence.put(sentence, length);
+    if (!mQueue.push(received)) {
+        return false;
+    }
+    // Notifying without the lock may lose a wakeup, in which case the
+    // sentence is processed at the next poll
+    mCondition.notify_one();
+    return true;
+}
+
+void NMEAIngest::run()
+{
+    unique_lock<mutex> lock(mMutex);
+    while (!mQuit) {
+        lock.unlock();
+        process();
+        lock.lock();
+        mCondition.wait_for(lock, POLL_PERIOD);
+    }
+    lock.unlock();
+    process();
+}
+
+size_t NMEAIngest::process()
+{
+    size_t count = 0;
+    ReceivedSentence received;
+    while (mQueue.pop(received)) {
+        process(received);
+        ++count;
+    }
+    return count;
+}
+
+void NMEAIngest::process(ReceivedSentence const& received)
+{
+    nmea::Sentence const& sentence = received.sentence;
+    char const* data = sentence.data();
+    size_t length = nmea::trimSentence(data, sentence.size());
+    if (sentence.hasOverflowed() || !nmea::validateChecksum(data, length)) {
+        ++mRejectedCount;
+        return;
+    }
+
+    if (data[0] == '!') {
+        processAIS(received.time, data, length);
+    }
+    else if (!nmea::isTalker(data, length, "SB")) {
+        processNMEA(received.time, data, length);
+    }
+}
+
+static gps_base::GPS_SOLUTION_TYPES solutionTypeFromGGA(int quality)
+{
+    switch (quality) {
+        case 0: return gps_base::NO_SOLUTION;
+        case 1: return gps_base::AUTONOMOUS;
+        case 2: return gps_base::DIFFERENTIAL;
+        case 4: return gps_base::RTK_FIXED;
+        case 5: return gps_base::RTK_FLOAT;
+        default: return gps_base::INVALID;
+    }
+}
+
+/** Full time of a GGA time of day, using the date of the reception time
+ *
+ * The closest of the previous, current and next day is used, to handle
+ * sentences received around midnight
+ */
+static base::Time timeFromTimeOfDay(
+    base::Time const& reception_time, base::Time const& time_of_day
+)
+{
+    static const int64_t DAY = 24LL * 3600 * 1000000;
+    int64_t reception = reception_time.toMicroseconds();
+    int64_t midnight = reception - ((reception % DAY) + DAY) % DAY;
+    int64_t result = midnight + time_of_day.toMicroseconds();
+    if (result - reception > DAY / 2) {
+        result -= DAY;
+    }
+    else if (reception - result > DAY / 2) {
+        result += DAY;
+    }
+    return base::Time::fromMicroseconds(result);
+}
+
+void NMEAIngest::processNMEA(
+    base::Time const& time, char const* sentence, size_t length
+)
+{
+    gps_base::Solution solution;
+    if (nmea::isSentenceType(sentence, length, "RMC")) {
+        nmea::RMCData rmc;
+        if (!nmea::parseRMC(sentence, length, rmc)) {
+            ++mRejectedCount;
+            return;
+        }
+        solution.time = rmc.time;
+        solution.latitude = rmc.latitude.getDeg();
+        solution.longitude = rmc.longitude.getDeg();
+        solution.positionType =
+            rmc.valid ? gps_base::AUTONOMOUS : gps_base::NO_SOLUTION;
+    }
+    else if (nmea::isSentenceType(sentence, length, "GGA")) {
+        nmea::GGAData gga;
+        if (!nmea::parseGGA(sentence, length, gga)) {
+            ++mRejectedCount;
+            return;
+        }
+        solution.time = timeFromTimeOfDay(time, gga.time_of_day);
+        solution.latitude = gga.latitude.getDeg();
+        solution.longitude = gga.longitude.getDeg();
+        solution.positionType = solutionTypeFromGGA(gga.quality);
+        solution.noOfSatellites = gga.satellites;
+        solution.altitude = gga.altitude;
+        solution.geoidalSeparation = gga.geoidal_separation;
+    }
+    else {
+        return;
+    }
+
+    if (mOutputs.solution) {
+        mOutputs.solution(solution);
+        ++mPublishedCount;
+    }
+}
+
+void NMEAIngest::processAIS(
+    base::Time const& time, char const* sentence, size_t length
+)
+{
+    nmea::VDMFragment fragment;
+    if (!nmea::parseVDM(sentence, length, fragment)) {
+        ++mRejectedCount;
+        return;
+    }
+    if (!mAISDecoder.push(fragment) ||
+        isIgnoredAISTarget(mAISDecoder.getMMSI(), time)) {
+        return;
+    }
+
+    ais_base::Position position;
+    ais_base::VesselInformation vessel;
+    if (mAISDecoder.decode(position)) {
+        position.time = time;
+        if (mOutputs.position) {
+            mOutputs.position(position);
+            ++mPublishedCount;
+        }
+    }
+    else if (mAISDecoder.decode(vessel)) {
+        vessel.time = time;
+        if (mOutputs.vessel) {
+            mOutputs.vessel(vessel);
+            ++mPublishedCount;
+        }
+    }
+}
+
+void NMEAIngest::setIgnoredAISTargetTimeout(base::Time const& timeout)
+{
+    lock_guard<mutex> lock(mIgnoredAISTargetsMutex);
+    mIgnoredAISTargetTimeout = timeout;
+}
+
+void NMEAIngest::ignoreAISTarget(uint32_t mmsi, base::Time const& time)
+{
+    lock_guard<mutex> lock(mIgnoredAISTargetsMutex);
+    mIgnoredAISTargets[mmsi] = time;
+
+    // As AISTargetTable, forget the expired targets at most once per timeout
+    if (time - mLastIgnoredAISTargetsPrune < mIgnoredAISTargetTimeout) {
+        return;
+    }
+    mLastIgnoredAISTargetsPrune = time;
+    for (auto it = mIgnoredAISTargets.begin(); it != mIgnoredAISTargets.end(); ) {
+        if (time - it->second > mIgnoredAISTargetTimeout) {
+            it = mIgnoredAISTargets.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+bool NMEAIngest::isIgnoredAISTarget(uint32_t mmsi, base::Time const& time)
+{
+    lock_guard<mutex> lock(mIgnoredAISTargetsMutex);
+    auto it = mIgnoredAISTargets.find(mmsi);
+    return it != mIgnoredAISTargets.end() &&
+        time - it->second <= mIgnoredAISTargetTimeout;
+}
+
+uint64_t NMEAIngest::getDropCount() const
+{
+    return mQueue.getDropCount();
+}
+
+uint64_t NMEAIngest::getRejectedCount() const
+{
+    return mRejectedCount.load();
+}
+
+uint64_t NMEAIngest::getPublishedCount() const
+{
+    return mPublishedCount.load();
+}
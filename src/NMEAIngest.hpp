@@ -0,0 +1,137 @@
+#ifndef SEABOTS_PI_NMEAINGEST_HPP
+#define SEABOTS_PI_NMEAINGEST_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <gps_base/BaseTypes.hpp>
+#include <ais_base/Position.hpp>
+#include <ais_base/VesselInformation.hpp>
+#include "AISDecoder.hpp"
+#include "NMEA.hpp"
+#include "SPSCQueue.hpp"
+
+namespace seabots_pi {
+    /** Forwards the NMEA and AIS sentences received by OpenCPN to Rock
+     *
+     * OpenCPN hands the sentences to the plugin on the GUI thread. There,
+     * the only work done is copying them into a bounded queue. A
+     * background thread then validates their checksums and parses them
+     * without allocating. It passes the results to the outputs: RMC and GGA
+     * become gps_base::Solution samples, and AIS position reports and
+     * static data become ais_base samples.
+     *
+     * Sentences from the plugin's own talker (SB), and AIS messages of the
+     * targets sent to OpenCPN by the plugin, are ignored so that the
+     * plugin's output does not loop back into Rock. A target is ignored
+     * until the ignore timeout after the plugin last sent it.
+     */
+    class NMEAIngest
+    {
+    public:
+        /** Where the parsed samples go. They are called from the ingest
+         * thread, and may be left empty
+         */
+        struct Outputs
+        {
+            std::function<void(gps_base::Solution const&)> solution;
+            std::function<void(ais_base::Position const&)> position;
+            std::function<void(ais_base::VesselInformation const&)> vessel;
+        };
+
+        /** A sentence as received from OpenCPN */
+        struct ReceivedSentence
+        {
+            base::Time time;
+            nmea::Sentence sentence;
+        };
+
+        NMEAIngest(size_t queueSize, Outputs const& outputs);
+
+        /** Stops the ingest thread */
+        ~NMEAIngest();
+
+        /** Start processing the queued sentences in a background thread */
+        void start();
+
+        /** Stop the background thread, processing the sentences that are
+         * already queued
+         */
+        void stop();
+
+        /** Queue a sentence received at the given time
+         *
+         * It must always be called from the same thread. Sentences longer
+         * than nmea::Sentence::CAPACITY are rejected
+         *
+         * @return false if the queue was full and the sentence dropped
+         */
+        bool push(base::Time const& time, char const* sentence, size_t length);
+
+        /** Process the queued sentences in the calling thread
+         *
+         * This is what the background thread does. It must not be called
+         * while it runs
+         *
+         * @return the number of processed sentences
+         */
+        size_t process();
+
+        /** Set the time during which the AIS messages of a target are
+         * ignored after the plugin sent it
+         *
+         * It is 20 minutes by default, the target timeout of AISTargetTable.
+         * It is thread-safe
+         */
+        void setIgnoredAISTargetTimeout(base::Time const& timeout);
+
+        /** Ignore the AIS messages of the given target, received up to the
+         * ignore timeout after the given time
+         *
+         * This is used for the targets that the plugin itself sends to
+         * OpenCPN. It is thread-safe
+         */
+        void ignoreAISTarget(uint32_t mmsi, base::Time const& time);
+
+        /** Number of sentences dropped because the queue was full */
+        uint64_t getDropCount() const;
+
+        /** Number of sentences rejected because of an invalid checksum or
+         * content
+         */
+        uint64_t getRejectedCount() const;
+
+        /** Number of samples passed to the outputs */
+        uint64_t getPublishedCount() const;
+
+    private:
+        void process(ReceivedSentence const& received);
+        void processNMEA(base::Time const& time, char const* sentence, size_t length);
+        void processAIS(base::Time const& time, char const* sentence, size_t length);
+        bool isIgnoredAISTarget(uint32_t mmsi, base::Time const& time);
+        void run();
+
+        Outputs mOutputs;
+        SPSCQueue<ReceivedSentence> mQueue;
+        AISDecoder mAISDecoder;
+
+        std::mutex mIgnoredAISTargetsMutex;
+        base::Time mIgnoredAISTargetTimeout = base::Time::fromSeconds(20 * 60);
+        /** Time at which each ignored target was last sent by the plugin */
+        std::unordered_map<uint32_t, base::Time> mIgnoredAISTargets;
+        base::Time mLastIgnoredAISTargetsPrune;
+
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        bool mQuit = false;
+        std::thread mThread;
+
+        std::atomic<uint64_t> mRejectedCount { 0 };
+        std::atomic<uint64_t> mPublishedCount { 0 };
+    };
+}
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef SEABOTS_PI_NMEALAYOUT_HPP
+#define SEABOTS_PI_NMEALAYOUT_HPP
+
+#include "NMEA.hpp"
+#include <cmath>
+
+namespace seabots_pi {
+    namespace nmea {
+        /** Compile-time description of NMEA sentences
+         *
+         * A sentence is declared as a Layout of an Address and a list of
+         * fields. Layout::encode then formats the sentence with one call per
+         * field, without any runtime description to interpret.
+         *
+         * The checksum contribution of everything that does not depend on
+         * the field values - the address, the separators and the constant
+         * fields - is computed at compile time. Only the bytes written by the
+         * value fields are checksummed at runtime.
+         *
+         * Each field type provides a constexpr \c checksum() for its constant
+         * part, a \c HAS_VALUE flag and a static \c write method, which takes
+         * the field value if HAS_VALUE is true.
+         */
+        namespace layout {
+            /** Compile-time checksum of a string */
+            constexpr uint8_t checksum(char const* str)
+            {
+                return *str ? static_cast<uint8_t>(*str ^ checksum(str + 1)) : 0;
+            }
+
+            /** Compile-time checksum of a sequence of characters */
+            constexpr uint8_t checksumChars()
+            {
+                return 0;
+            }
+
+            template<typename... Chars>
+            constexpr uint8_t checksumChars(char c, Chars... chars)
+            {
+                return static_cast<uint8_t>(c ^ checksumChars(chars...));
+            }
+
+            /** Runtime checksum of the bytes of a sentence, starting at
+             * \c start
+             */
+            inline uint8_t checksum(Sentence const& sentence, size_t start)
+            {
+                uint8_t result = 0;
+                char const* data = sentence.data();
+                for (size_t i = start; i < sentence.size(); ++i) {
+                    result ^= data[i];
+                }
+                return result;
+            }
+
+            /** Talker and type of a sentence, e.g. Address<'S','B','R','M','C'> */
+            template<char... C>
+            struct Address
+            {
+                static constexpr uint8_t checksum() { return checksumChars(C...); }
+
+                static void write(Sentence& sentence)
+                {
+                    static const char chars[] = { '$', C... };
+                    sentence.put(chars, sizeof(chars));
+                }
+            };
+
+            /** Field with a constant value, e.g. the unit in VTG */
+            template<char... C>
+            struct Const
+            {
+                static constexpr bool HAS_VALUE = false;
+                static constexpr uint8_t checksum() { return checksumChars(C...); }
+
+                static void write(Sentence& sentence)
+                {
+                    static const char chars[] = { C... };
+                    sentence.put(chars, sizeof...(C));
+                }
+            };
+
+            /** Field left empty */
+            typedef Const<> Empty;
+
+            /** Floating-point field with a fixed number of decimals */
+            template<int Precision>
+            struct Fixed
+            {
+                static constexpr bool HAS_VALUE = true;
+                static constexpr uint8_t checksum() { return 0; }
+
+                static void write(Sentence& sentence, double value)
+                {
+                    sentence.putFixed(value, Precision);
+                }
+            };
+
+            /** Unsigned integer field, zero-padded to the given width */
+            template<int Width>
+            struct UInt
+            {
+                static constexpr bool HAS_VALUE = true;
+                static constexpr uint8_t checksum() { return 0; }
+
+                static void write(Sentence& sentence, uint64_t value)
+                {
+                    sentence.putUInt(value, Width);
+                }
+            };
+
+            /** Pair of fields made of an absolute value and a direction
+             *
+             * E.g. the magnetic variation in RMC. \c Positive is used for
+             * strictly positive values and \c Negative otherwise
+             */
+            template<int Precision, char Positive, char Negative>
+            struct SignedFixed
+            {
+                static constexpr bool HAS_VALUE = true;
+                static constexpr uint8_t checksum() { return 0; }
+
+                static void write(Sentence& sentence, double value)
+                {
+                    sentence.putFixed(std::fabs(value), Precision);
+                    sentence.put(',');
+                    sentence.put(value > 0 ? Positive : Negative);
+                }
+            };
+
+            /** Latitude or longitude in ddmm.mmm format, and its hemisphere
+             *
+             * \c DegreeWidth is 2 for latitudes and 3 for longitudes
+             */
+            template<int DegreeWidth, char Positive, char Negative>
+            struct DMS
+            {
+                static constexpr bool HAS_VALUE = true;
+                static constexpr uint8_t checksum() { return 0; }
+
+                static void write(Sentence& sentence, base::Angle const& angle)
+                {
+                    putAngleDMS(sentence, angle, DegreeWidth);
+                    sentence.put(',');
+                    sentence.put(angle.getRad() > 0 ? Positive : Negative);
+                }
+            };
+
+            typedef DMS<2, 'N', 'S'> Latitude;
+            typedef DMS<3, 'E', 'W'> Longitude;
+
+            /** UTC time in hhmmss.ss format */
+            struct Time
+            {
+                static constexpr bool HAS_VALUE = true;
+                static constexpr uint8_t checksum() { return 0; }
+
+                static void write(Sentence& sentence, base::Time const& time)
+                {
+                    putTime(sentence, time);
+                }
+            };
+
+            /** UTC date in ddmmyy format */
+            struct Date
+            {
+                static constexpr bool HAS_VALUE = true;
+                static constexpr uint8_t checksum() { return 0; }
+
+                static void write(Sentence& sentence, base::Time const& time)
+                {
+                    putDate(sentence, time);
+                }
+            };
+
+            /** UTC date as the three dd,mm,yyyy fields of ZDA */
+            struct DateFields
+            {
+                static constexpr bool HAS_VALUE = true;
+                static constexpr uint8_t checksum() { return 0; }
+
+                static void write(Sentence& sentence, base::Time const& time);
+            };
+
+            template<typename... Fields>
+            struct FieldList;
+
+            template<typename Field, bool HasValue = Field::HAS_VALUE>
+            struct FieldWriter;
+
+            template<typename Field>
+            struct FieldWriter<Field, false>
+            {
+                template<typename Next, typename... Args>
+                static uint8_t write(Sentence& sentence, Args const&... args)
+                {
+                    Field::write(sentence);
+                    return Next::write(sentence, args...);
+                }
+            };
+
+            template<typename Field>
+            struct FieldWriter<Field, true>
+            {
+                template<typename Next, typename Arg, typename... Args>
+                static uint8_t write(
+                    Sentence& sentence, Arg const& arg, Args const&... args
+                )
+                {
+                    size_t start = sentence.size();
+                    Field::write(sentence, arg);
+                    uint8_t result = checksum(sentence, start);
+                    return result ^ Next::write(sentence, args...);
+                }
+            };
+
+            template<>
+            struct FieldList<>
+            {
+                static constexpr size_t VALUE_COUNT = 0;
+                static constexpr uint8_t checksum() { return 0; }
+                static uint8_t write(Sentence&) { return 0; }
+            };
+
+            /** Writes a list of fields, each preceded by a separator
+             *
+             * write() returns the checksum of the bytes written by the
+             * value fields
+             */
+            template<typename Field, typename... Fields>
+            struct FieldList<Field, Fields...>
+            {
+                typedef FieldList<Fields...> Next;
+
+                static constexpr size_t VALUE_COUNT =
+                    (Field::HAS_VALUE ? 1 : 0) + Next::VALUE_COUNT;
+
+                static constexpr uint8_t checksum()
+                {
+                    return ',' ^ Field::checksum() ^ Next::checksum();
+                }
+
+                template<typename... Args>
+                static uint8_t write(Sentence& sentence, Args const&... args)
+                {
+                    sentence.put(',');
+                    return FieldWriter<Field>::template write<Next>(
+                        sentence, args...
+                    );
+                }
+            };
+
+            /** A complete sentence
+             *
+             * encode() takes one argument per value field, in order
+             */
+            template<typename SentenceAddress, typename... Fields>
+            struct Layout
+            {
+                typedef FieldList<Fields...> List;
+
+                /** Checksum of the parts of the sentence that do not depend
+                 * on the field values
+                 */
+                static constexpr uint8_t constantChecksum()
+                {
+                    return SentenceAddress::checksum() ^ List::checksum();
+                }
+
+                template<typename... Args>
+                static void encode(Sentence& sentence, Args const&... args)
+                {
+                    static_assert(sizeof...(Args) == List::VALUE_COUNT,
+                        "wrong number of values for this sentence layout");
+
+                    sentence.clear();
+                    SentenceAddress::write(sentence);
+                    uint8_t variable = List::write(sentence, args...);
+                    sentence.put('*');
+                    putChecksum(sentence, constantChecksum() ^ variable);
+                }
+            };
+
+            typedef Layout<
+                Address<'S', 'B', 'R', 'M', 'C'>,
+                Time, Const<'A'>, Latitude, Longitude,
+                Fixed<1>, Fixed<1>, Date, SignedFixed<1, 'E', 'W'>
+            > RMC;
+
+            typedef Layout<
+                Address<'S', 'B', 'V', 'T', 'G'>,
+                Fixed<2>, Const<'T'>, Fixed<2>, Const<'M'>,
+                Fixed<2>, Const<'N'>, Fixed<2>, Const<'K'>
+            > VTG;
+
+            typedef Layout<
+                Address<'S', 'B', 'H', 'D', 'T'>,
+                Fixed<2>, Const<'T'>
+            > HDT;
+
+            typedef Layout<
+                Address<'S', 'B', 'G', 'G', 'A'>,
+                Time, Latitude, Longitude, UInt<1>, UInt<2>, Empty,
+                Fixed<1>, Const<'M'>, Empty, Const<'M'>, Empty, Empty
+            > GGA;
+
+            typedef Layout<
+                Address<'S', 'B', 'Z', 'D', 'A'>,
+                Time, DateFields, Const<'0', '0'>, Const<'0', '0'>
+            > ZDA;
+
+            typedef Layout<
+                Address<'S', 'B', 'R', 'O', 'T'>,
+                Fixed<1>, Const<'A'>
+            > ROT;
+        }
+    }
+}
+
+#endif
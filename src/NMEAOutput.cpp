@@ -0,0 +1,42 @@
+#include "NMEAOutput.hpp"
+#include <cstring>
+
+using namespace seabots_pi;
+
+NMEAOutput::NMEAOutput(Sink sink)
+    : mSink(sink)
+{
+}
+
+void NMEAOutput::push(char const* sentences, size_t length)
+{
+    char const* end = sentences + length;
+    while (sentences < end) {
+        char const* eol = static_cast<char const*>(
+            memchr(sentences, '\n', end - sentences)
+        );
+        if (!eol) {
+            eol = end;
+        }
+        if (eol != sentences) {
+            assign(sentences, eol - sentences);
+            mSink(mBuffer);
+        }
+        sentences = eol + 1;
+    }
+}
+
+void NMEAOutput::assign(char const* ascii, size_t length)
+{
+    wxStringBufferLength buffer(mBuffer, length);
+    wxChar* out = buffer;
+    for (size_t i = 0; i < length; ++i) {
+        out[i] = static_cast<unsigned char>(ascii[i]);
+    }
+    buffer.SetLength(length);
+}
+
+wxString const& NMEAOutput::getBuffer() const
+{
+    return mBuffer;
+}
@@ -0,0 +1,42 @@
+#ifndef SEABOTS_PI_NMEAOUTPUT_HPP
+#define SEABOTS_PI_NMEAOUTPUT_HPP
+
+#include <wx/string.h>
+#include <cstddef>
+
+namespace seabots_pi {
+    /** Hands NMEA sentences to OpenCPN
+     *
+     * Sentences are kept as ASCII bytes up to this point. Building a
+     * wxString from a std::string or char* goes through the current locale's
+     * multibyte conversion. Since NMEA is pure ASCII, this class widens the
+     * bytes directly into a wxString buffer that is reused from one sentence
+     * to the next, which is the only conversion on the output path.
+     *
+     * It is not thread-safe, and must be used from the GUI thread
+     */
+    class NMEAOutput
+    {
+    public:
+        typedef void (*Sink)(wxString sentence);
+
+        /** Create an output that pushes the sentences to the given sink,
+         * which is normally OpenCPN's PushNMEABuffer
+         */
+        explicit NMEAOutput(Sink sink);
+
+        /** Push newline-separated sentences, one at a time */
+        void push(char const* sentences, size_t length);
+
+        /** The buffer holding the last pushed sentence */
+        wxString const& getBuffer() const;
+
+    private:
+        Sink mSink;
+        wxString mBuffer;
+
+        void assign(char const* ascii, size_t length);
+    };
+}
+
+#endif
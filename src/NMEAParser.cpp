@@ -0,0 +1,492 @@
+#include "NMEAParser.hpp"
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+using namespace seabots_pi;
+
+static const double KNOT_TO_MS = 1852.0 / 3600;
+
+size_t nmea::trimSentence(char const* sentence, size_t length)
+{
+    while (length > 0) {
+        char c = sentence[length - 1];
+        if (c != '\r' && c != '\n' && c != ' ') {
+            break;
+        }
+        --length;
+    }
+    return length;
+}
+
+static int parseHexDigit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+bool nmea::validateChecksum(char const* sentence, size_t length)
+{
+    if (length < 4 || (sentence[0] != '$' && sentence[0] != '!') ||
+        sentence[length - 3] != '*') {
+        return false;
+    }
+    int high = parseHexDigit(sentence[length - 2]);
+    int low = parseHexDigit(sentence[length - 1]);
+    if (high < 0 || low < 0) {
+        return false;
+    }
+
+    // XOR eight bytes at a time, and fold the result at the end
+    char const* data = sentence + 1;
+    size_t size = length - 4;
+    uint64_t words = 0;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        words ^= word;
+    }
+    words ^= words >> 32;
+    words ^= words >> 16;
+    words ^= words >> 8;
+    uint8_t checksum = words & 0xFF;
+    for (; i < size; ++i) {
+        checksum ^= data[i];
+    }
+    return checksum == (high << 4 | low);
+}
+
+bool nmea::isSentenceType(char const* sentence, size_t length, char const* type)
+{
+    return length >= 6 && memcmp(sentence + 3, type, 3) == 0;
+}
+
+bool nmea::isTalker(char const* sentence, size_t length, char const* talker)
+{
+    return length >= 3 && memcmp(sentence + 1, talker, 2) == 0;
+}
+
+nmea::FieldReader::FieldReader(char const* sentence, size_t length)
+    : mCurrent(sentence)
+    , mEnd(sentence + length)
+{
+    if (length >= 3 && sentence[length - 3] == '*') {
+        mEnd -= 3;
+    }
+
+    // Skip the address field
+    char const* comma = static_cast<char const*>(
+        memchr(mCurrent, ',', mEnd - mCurrent)
+    );
+    if (comma) {
+        mCurrent = comma + 1;
+    }
+    else {
+        mDone = true;
+    }
+}
+
+bool nmea::FieldReader::next(Field& field)
+{
+    if (mDone) {
+        return false;
+    }
+
+    char const* comma = static_cast<char const*>(
+        memchr(mCurrent, ',', mEnd - mCurrent)
+    );
+    if (!comma) {
+        comma = mEnd;
+        mDone = true;
+    }
+    field.data = mCurrent;
+    field.size = comma - mCurrent;
+    mCurrent = comma + 1;
+    return true;
+}
+
+nmea::Field nmea::FieldReader::next()
+{
+    Field field;
+    next(field);
+    return field;
+}
+
+bool nmea::parseUInt(Field const& field, uint64_t& value)
+{
+    if (field.empty() || field.size > 19) {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (size_t i = 0; i < field.size; ++i) {
+        unsigned int digit = field.data[i] - '0';
+        if (digit > 9) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    value = result;
+    return true;
+}
+
+bool nmea::parseDouble(Field const& field, double& value)
+{
+    static const double POW10[] = {
+        1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+        1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+    };
+
+    char const* it = field.data;
+    char const* end = field.data + field.size;
+    bool negative = false;
+    if (it != end && (*it == '-' || *it == '+')) {
+        negative = (*it == '-');
+        ++it;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int decimals = -1;
+    for (; it != end; ++it) {
+        if (*it == '.' && decimals < 0) {
+            decimals = 0;
+            continue;
+        }
+        unsigned int digit = *it - '0';
+        if (digit > 9 || digits == 18) {
+            return false;
+        }
+        mantissa = mantissa * 10 + digit;
+        ++digits;
+        if (decimals >= 0) {
+            ++decimals;
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+
+    double result = mantissa / POW10[decimals > 0 ? decimals : 0];
+    value = negative ? -result : result;
+    return true;
+}
+
+static bool parseTwoDigits(char const* data, int& value)
+{
+    unsigned int high = data[0] - '0';
+    unsigned int low = data[1] - '0';
+    if (high > 9 || low > 9) {
+        return false;
+    }
+    value = high * 10 + low;
+    return true;
+}
+
+bool nmea::parseTimeOfDay(Field const& field, base::Time& value)
+{
+    int hours, minutes;
+    double seconds;
+    if (field.size < 6 ||
+        !parseTwoDigits(field.data, hours) ||
+        !parseTwoDigits(field.data + 2, minutes) ||
+        !parseDouble(Field { field.data + 4, field.size - 4 }, seconds)) {
+        return false;
+    }
+    if (hours > 23 || minutes > 59 || seconds >= 61) {
+        return false;
+    }
+
+    value = base::Time::fromMicroseconds(
+        (hours * 3600 + minutes * 60) * 1000000LL + llround(seconds * 1e6)
+    );
+    return true;
+}
+
+/** Number of days between 1970-01-01 and the given date
+ *
+ * See http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+ */
+static int64_t daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t year_of_era = year - era * 400;
+    int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t day_of_era = year_of_era * 365 + year_of_era / 4 -
+        year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+bool nmea::parseDate(Field const& field, base::Time& value)
+{
+    int day, month, year;
+    if (field.size != 6 ||
+        !parseTwoDigits(field.data, day) ||
+        !parseTwoDigits(field.data + 2, month) ||
+        !parseTwoDigits(field.data + 4, year)) {
+        return false;
+    }
+    if (day < 1 || day > 31 || month < 1 || month > 12) {
+        return false;
+    }
+
+    // Two-digit years are interpreted within 1980-2079
+    year += year < 80 ? 2000 : 1900;
+    value = base::Time::fromSeconds(daysFromCivil(year, month, day) * 86400);
+    return true;
+}
+
+bool nmea::parseAngleDMS(
+    Field const& value, Field const& hemisphere,
+    char negative, base::Angle& angle
+)
+{
+    double ddmm;
+    if (hemisphere.size != 1 || !parseDouble(value, ddmm) || ddmm < 0) {
+        return false;
+    }
+
+    double degrees = floor(ddmm / 100);
+    double minutes = ddmm - degrees * 100;
+    double deg = degrees + minutes / 60;
+    angle = base::Angle::fromDeg(hemisphere.data[0] == negative ? -deg : deg);
+    return true;
+}
+
+/** Parse an optional decimal field, leaving the value unchanged if empty */
+static bool parseOptionalDouble(nmea::Field const& field, double& value)
+{
+    return field.empty() || nmea::parseDouble(field, value);
+}
+
+/** Parse an optional NMEA heading field (degrees, positive towards east)
+ * into Rock's convention, leaving the angle unchanged if empty
+ */
+static bool parseOptionalHeading(nmea::Field const& field, base::Angle& angle)
+{
+    if (field.empty()) {
+        return true;
+    }
+
+    double deg;
+    if (!nmea::parseDouble(field, deg)) {
+        return false;
+    }
+    angle = base::Angle::fromDeg(-deg);
+    return true;
+}
+
+bool nmea::parseRMC(char const* sentence, size_t length, RMCData& data)
+{
+    if (!isSentenceType(sentence, length, "RMC")) {
+        return false;
+    }
+
+    FieldReader reader(sentence, length);
+    Field time = reader.next();
+    Field status = reader.next();
+    Field latitude = reader.next();
+    Field north_south = reader.next();
+    Field longitude = reader.next();
+    Field east_west = reader.next();
+    Field speed = reader.next();
+    Field track = reader.next();
+    Field date = reader.next();
+    Field variation = reader.next();
+    Field variation_direction = reader.next();
+
+    base::Time time_of_day, midnight;
+    if (!parseTimeOfDay(time, time_of_day) || !parseDate(date, midnight)) {
+        return false;
+    }
+
+    RMCData result;
+    result.time = midnight + time_of_day;
+    result.valid = (status.size == 1 && status.data[0] == 'A');
+    if (!latitude.empty() &&
+        !parseAngleDMS(latitude, north_south, 'S', result.latitude)) {
+        return false;
+    }
+    if (!longitude.empty() &&
+        !parseAngleDMS(longitude, east_west, 'W', result.longitude)) {
+        return false;
+    }
+
+    double speed_knots = base::unknown<double>();
+    if (!parseOptionalDouble(speed, speed_knots) ||
+        !parseOptionalHeading(track, result.track)) {
+        return false;
+    }
+    result.speed_over_ground = speed_knots * KNOT_TO_MS;
+
+    if (!variation.empty()) {
+        double variation_deg;
+        if (variation_direction.size != 1 ||
+            !parseDouble(variation, variation_deg)) {
+            return false;
+        }
+        if (variation_direction.data[0] == 'W') {
+            variation_deg = -variation_deg;
+        }
+        result.magnetic_variation = base::Angle::fromDeg(variation_deg);
+    }
+
+    data = result;
+    return true;
+}
+
+bool nmea::parseVTG(char const* sentence, size_t length, VTGData& data)
+{
+    if (!isSentenceType(sentence, length, "VTG")) {
+        return false;
+    }
+
+    FieldReader reader(sentence, length);
+    Field track_true_north = reader.next();
+    reader.next();
+    Field track_magnetic = reader.next();
+    reader.next();
+    Field speed_knots = reader.next();
+    reader.next();
+    Field speed_kmh = reader.next();
+
+    VTGData result;
+    if (!parseOptionalHeading(track_true_north, result.track_true_north) ||
+        !parseOptionalHeading(track_magnetic, result.track_magnetic)) {
+        return false;
+    }
+
+    double speed;
+    if (!speed_kmh.empty()) {
+        if (!parseDouble(speed_kmh, speed)) {
+            return false;
+        }
+        result.speed = speed / 3.6;
+    }
+    else if (!speed_knots.empty()) {
+        if (!parseDouble(speed_knots, speed)) {
+            return false;
+        }
+        result.speed = speed * KNOT_TO_MS;
+    }
+
+    data = result;
+    return true;
+}
+
+bool nmea::parseHDT(char const* sentence, size_t length, base::Angle& heading)
+{
+    if (!isSentenceType(sentence, length, "HDT")) {
+        return false;
+    }
+
+    FieldReader reader(sentence, length);
+    Field field = reader.next();
+    double deg;
+    if (!parseDouble(field, deg)) {
+        return false;
+    }
+    heading = base::Angle::fromDeg(-deg);
+    return true;
+}
+
+bool nmea::parseGGA(char const* sentence, size_t length, GGAData& data)
+{
+    if (!isSentenceType(sentence, length, "GGA")) {
+        return false;
+    }
+
+    FieldReader reader(sentence, length);
+    Field time = reader.next();
+    Field latitude = reader.next();
+    Field north_south = reader.next();
+    Field longitude = reader.next();
+    Field east_west = reader.next();
+    Field quality = reader.next();
+    Field satellites = reader.next();
+    Field hdop = reader.next();
+    Field altitude = reader.next();
+    reader.next(); // altitude unit, always M
+    Field separation = reader.next();
+
+    GGAData result;
+    uint64_t quality_value = 0;
+    uint64_t satellites_value = 0;
+    if (!parseTimeOfDay(time, result.time_of_day) ||
+        !parseUInt(quality, quality_value)) {
+        return false;
+    }
+    if (!satellites.empty() && !parseUInt(satellites, satellites_value)) {
+        return false;
+    }
+    result.quality = quality_value;
+    result.satellites = satellites_value;
+
+    if (!latitude.empty() &&
+        !parseAngleDMS(latitude, north_south, 'S', result.latitude)) {
+        return false;
+    }
+    if (!longitude.empty() &&
+        !parseAngleDMS(longitude, east_west, 'W', result.longitude)) {
+        return false;
+    }
+    if (!parseOptionalDouble(hdop, result.hdop) ||
+        !parseOptionalDouble(altitude, result.altitude) ||
+        !parseOptionalDouble(separation, result.geoidal_separation)) {
+        return false;
+    }
+
+    data = result;
+    return true;
+}
+
+bool nmea::parseVDM(char const* sentence, size_t length, VDMFragment& fragment)
+{
+    if (sentence[0] != '!' ||
+        (!isSentenceType(sentence, length, "VDM") &&
+         !isSentenceType(sentence, length, "VDO"))) {
+        return false;
+    }
+
+    FieldReader reader(sentence, length);
+    Field count = reader.next();
+    Field number = reader.next();
+    Field sequence_id = reader.next();
+    Field channel = reader.next();
+    Field payload = reader.next();
+    Field fill_bits = reader.next();
+
+    uint64_t count_value, number_value, fill_bits_value;
+    uint64_t sequence_id_value = 0;
+    if (!parseUInt(count, count_value) ||
+        !parseUInt(number, number_value) ||
+        !parseUInt(fill_bits, fill_bits_value)) {
+        return false;
+    }
+    if (!sequence_id.empty() && !parseUInt(sequence_id, sequence_id_value)) {
+        return false;
+    }
+    if (number_value < 1 || number_value > count_value || fill_bits_value > 5) {
+        return false;
+    }
+
+    VDMFragment result;
+    result.count = count_value;
+    result.number = number_value;
+    result.sequence_id = sequence_id.empty() ? -1 : sequence_id_value;
+    result.channel = channel.empty() ? 0 : channel.data[0];
+    result.payload = payload;
+    result.fill_bits = fill_bits_value;
+    fragment = result;
+    return true;
+}
@@ -0,0 +1,186 @@
+#ifndef SEABOTS_PI_NMEAPARSER_HPP
+#define SEABOTS_PI_NMEAPARSER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <base/Angle.hpp>
+#include <base/Float.hpp>
+#include <base/Time.hpp>
+
+namespace seabots_pi {
+    namespace nmea {
+        /** Remove the trailing CR/LF and spaces of a sentence
+         *
+         * @return the length of the sentence without them
+         */
+        size_t trimSentence(char const* sentence, size_t length);
+
+        /** Check the framing and checksum of a sentence
+         *
+         * The sentence must start with '$' or '!' and end with '*' and two
+         * hexadecimal digits, without CR/LF. The checksum is computed eight
+         * bytes at a time
+         */
+        bool validateChecksum(char const* sentence, size_t length);
+
+        /** Whether a sentence has the given three-letter type, e.g. "RMC",
+         * regardless of its talker
+         */
+        bool isSentenceType(char const* sentence, size_t length, char const* type);
+
+        /** Whether a sentence has the given two-letter talker, e.g. "SB" */
+        bool isTalker(char const* sentence, size_t length, char const* talker);
+
+        /** A field of a sentence, pointing into the sentence itself */
+        struct Field
+        {
+            char const* data = nullptr;
+            size_t size = 0;
+
+            Field() {}
+            Field(char const* data, size_t size)
+                : data(data), size(size) {}
+
+            bool empty() const { return size == 0; }
+        };
+
+        /** Splits the body of a sentence into fields
+         *
+         * The address field is skipped, and the checksum is excluded. It
+         * does not copy nor allocate
+         */
+        class FieldReader
+        {
+        public:
+            FieldReader(char const* sentence, size_t length);
+
+            /** Read the next field
+             *
+             * @return false if there are no more fields
+             */
+            bool next(Field& field);
+
+            /** Read the next field, or an empty field if there are none */
+            Field next();
+
+        private:
+            char const* mCurrent;
+            char const* mEnd;
+            bool mDone = false;
+        };
+
+        /** Parse an unsigned integer field */
+        bool parseUInt(Field const& field, uint64_t& value);
+
+        /** Parse a decimal number field, independently of the locale */
+        bool parseDouble(Field const& field, double& value);
+
+        /** Parse a hhmmss.ss field into a time since midnight */
+        bool parseTimeOfDay(Field const& field, base::Time& value);
+
+        /** Parse a ddmmyy field into the UTC time of that day's midnight */
+        bool parseDate(Field const& field, base::Time& value);
+
+        /** Parse a ddmm.mmm field and its hemisphere field
+         *
+         * @param negative the hemisphere for which the angle is negative,
+         *   i.e. 'S' or 'W'
+         */
+        bool parseAngleDMS(
+            Field const& value, Field const& hemisphere,
+            char negative, base::Angle& angle
+        );
+
+        /** Recommended minimum navigation information */
+        struct RMCData
+        {
+            base::Time time;
+            /** Whether the receiver reported the data as valid (A) */
+            bool valid = false;
+            base::Angle latitude;
+            base::Angle longitude;
+            /** Speed over ground in m/s, unknown if empty */
+            double speed_over_ground = base::unknown<double>();
+            /** Course over ground in Rock's convention, unknown if empty */
+            base::Angle track;
+            /** Magnetic variation, positive towards east, unknown if empty */
+            base::Angle magnetic_variation;
+        };
+
+        /** Parse a RMC sentence of any talker
+         *
+         * The sentence must have been validated with validateChecksum first
+         */
+        bool parseRMC(char const* sentence, size_t length, RMCData& data);
+
+        /** Track and speed over ground */
+        struct VTGData
+        {
+            /** True track in Rock's convention, unknown if empty */
+            base::Angle track_true_north;
+            /** Magnetic track in Rock's convention, unknown if empty */
+            base::Angle track_magnetic;
+            /** Speed over ground in m/s, unknown if empty */
+            double speed = base::unknown<double>();
+        };
+
+        /** Parse a VTG sentence of any talker
+         *
+         * The speed is read from the km/h field, which is the most
+         * precise, and from the knots field if it is empty.
+         *
+         * The sentence must have been validated with validateChecksum first
+         */
+        bool parseVTG(char const* sentence, size_t length, VTGData& data);
+
+        /** Parse a HDT sentence of any talker
+         *
+         * @param heading the true heading, in Rock's convention
+         *
+         * The sentence must have been validated with validateChecksum first
+         */
+        bool parseHDT(char const* sentence, size_t length, base::Angle& heading);
+
+        /** Global positioning system fix data */
+        struct GGAData
+        {
+            /** Time since midnight UTC, GGA does not have the date */
+            base::Time time_of_day;
+            base::Angle latitude;
+            base::Angle longitude;
+            int quality = 0;
+            int satellites = 0;
+            double hdop = base::unknown<double>();
+            /** Altitude above the geoid in meters */
+            double altitude = base::unknown<double>();
+            double geoidal_separation = base::unknown<double>();
+        };
+
+        /** Parse a GGA sentence of any talker
+         *
+         * The sentence must have been validated with validateChecksum first
+         */
+        bool parseGGA(char const* sentence, size_t length, GGAData& data);
+
+        /** A fragment of an AIS message (VDM or VDO sentence) */
+        struct VDMFragment
+        {
+            int count = 0;
+            int number = 0;
+            /** Sequential message ID of multi-fragment messages, -1 if empty */
+            int sequence_id = -1;
+            char channel = 0;
+            /** The armored payload, pointing into the sentence */
+            Field payload;
+            int fill_bits = 0;
+        };
+
+        /** Parse a VDM or VDO sentence
+         *
+         * The sentence must have been validated with validateChecksum first
+         */
+        bool parseVDM(char const* sentence, size_t length, VDMFragment& fragment);
+    }
+}
+
+#endif
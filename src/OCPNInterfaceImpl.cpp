@@ -1,51 +1,155 @@
-#include <marnav/ais/message_01.hpp>
-#include <marnav/ais/message_05.hpp>
-#include <marnav/ais/ais.hpp>
-#include <marnav/nmea/ais_helper.hpp>
-
 #include "OCPNInterfaceImpl.hpp"
 #include <wx/wx.h>
 #include "ocpn_plugin.h"
 #include "NMEA.hpp"
+#include "NMEAIngest.hpp"
 
 using namespace std;
 using base::Angle;
 using namespace seabots_pi;
-using namespace marnav;
 
-static const int RAD2DEG = 180.0 / M_PI;
 static const double SI2KNOTS = 1.94384;
 
 void OCPNInterfaceImpl::setUTMConversionParameters(
     gps_base::UTMConversionParameters const& parameters
 )
 {
-    currentPlanningResult = SampledPlanningResult();
-    mLatLonConverter.setParameters(parameters);
+    {
+        lock_guard<mutex> lock(mLatLonConverterMutex);
+        mUTMParameters = parameters;
+        mLatLonConverter.setParameters(parameters);
+
+        base::samples::RigidBodyState origin;
+        origin.position = Eigen::Vector3d::Zero();
+        auto latlon = mLatLonConverter.convertNWUToGPS(origin);
+        mMercatorOrigin = mercator::Origin(latlon.latitude, latlon.longitude);
+    }
+
+    // This also discards the results being sampled with the old parameters
+    auto empty = make_shared<SampledPlanningResult>();
+    empty->revision = ++lastPlanningResultRevision;
+    empty->origin = mMercatorOrigin;
+    publishPlanningResult(empty);
+}
+
+void OCPNInterfaceImpl::setPoseSentences(int sentences)
+{
+    mPoseSentences = sentences;
+}
+
+void OCPNInterfaceImpl::setPosePublicationConfiguration(
+    PosePublicationPolicy::Configuration const& configuration
+)
+{
+    mPosePublicationPolicy.setConfiguration(configuration);
+}
+
+uint64_t OCPNInterfaceImpl::getPoseRateSuppressedCount() const
+{
+    return mPosePublicationPolicy.getRateSuppressedCount();
+}
+
+uint64_t OCPNInterfaceImpl::getPoseDeadbandSuppressedCount() const
+{
+    return mPosePublicationPolicy.getDeadbandSuppressedCount();
+}
+
+void OCPNInterfaceImpl::setAISTargetTableConfiguration(
+    AISTargetTable::Configuration const& configuration
+)
+{
+    mAISTargets.setConfiguration(configuration);
+}
+
+void OCPNInterfaceImpl::setAISSchedulerConfiguration(
+    AISScheduler::Configuration const& configuration
+)
+{
+    mAISScheduler.setConfiguration(configuration);
+}
+
+AISTargetTable const& OCPNInterfaceImpl::getAISTargetTable() const
+{
+    return mAISTargets;
+}
+
+void OCPNInterfaceImpl::setContactRouting(int nmea_classes, int overlay_classes)
+{
+    mNMEAClasses = nmea_classes;
+    mOverlayClasses = overlay_classes;
+}
+
+void OCPNInterfaceImpl::setContactBufferConfiguration(
+    ContactBuffer::Configuration const& configuration
+)
+{
+    mContacts.setConfiguration(configuration);
+}
+
+ContactBuffer const& OCPNInterfaceImpl::getContacts() const
+{
+    return mContacts;
+}
+
+bool OCPNInterfaceImpl::pruneContacts(base::Time const& now)
+{
+    return mContacts.prune(now);
 }
 
 void OCPNInterfaceImpl::updateSystemPose(base::samples::RigidBodyState const& rbs)
 {
-    auto gps = mLatLonConverter.convertNWUToGPS(rbs);
+    if (!mPosePublicationPolicy.update(rbs)) {
+        return;
+    }
+
+    gps_base::Solution gps;
+    {
+        lock_guard<mutex> lock(mLatLonConverterMutex);
+        gps = mLatLonConverter.convertNWUToGPS(rbs);
+    }
     float velocity_over_ground = rbs.velocity.norm();
 
-    base::Angle track;
+    nmea::Pose pose;
+    pose.time = rbs.time;
+    pose.latitude = Angle::fromDeg(gps.latitude);
+    pose.longitude = Angle::fromDeg(gps.longitude);
+    pose.altitude = gps.altitude;
+    pose.speed_over_ground = velocity_over_ground;
+    pose.heading = Angle::fromRad(base::getYaw(rbs.orientation));
     if (velocity_over_ground > 0.1)
-        track = Angle::fromRad(atan2(rbs.velocity.y(), rbs.velocity.x()));
+        pose.track = Angle::fromRad(atan2(rbs.velocity.y(), rbs.velocity.x()));
     else
-        track = Angle::fromRad(base::getYaw(rbs.orientation));
+        pose.track = pose.heading;
+
+    // The AIS targets are timed with the reception time, not their sample
+    // time, so do the same for ownship
+    AISScheduler::Ownship ownship;
+    ownship.time = base::Time::now();
+    ownship.latitude = pose.latitude;
+    ownship.longitude = pose.longitude;
+    ownship.speed_over_ground = pose.speed_over_ground;
+    ownship.course_over_ground = pose.track;
+    mAISScheduler.updateOwnship(ownship);
+
+    int sentences = mPoseSentences;
+    if (rbs.hasValidAngularVelocity()) {
+        pose.yaw_rate = rbs.angular_velocity.z();
+    }
+    else {
+        sentences &= ~nmea::POSE_ROT;
+    }
 
-    string rmc = nmea::createRMC(
-        rbs.time,
-        Angle::fromDeg(gps.latitude), Angle::fromDeg(gps.longitude),
-        velocity_over_ground, track,
-        base::Angle::fromRad(0));
-    PushNMEABuffer(rmc);
+    string burst;
+    nmea::encodePoseBurst(burst, pose, sentences);
+    if (!burst.empty()) {
+        pushNMEA(NMEACoalescingQueue::Key(NMEA_KEY_POSE, 0), move(burst));
+    }
 }
 
 /** Send an OpenCPN route to the Rock system */
 void OCPNInterfaceImpl::pushRoute(PlugIn_Route const& route)
 {
+    lock_guard<mutex> lock(mLatLonConverterMutex);
     std::vector<Waypoint> rock_wps;
     for (auto const& waypoint_ptr : *route.pWaypointList) {
         auto const& wp = *waypoint_ptr;
@@ -79,46 +183,132 @@ void OCPNInterfaceImpl::pushRoute(PlugIn_Route const& route)
     pushPlanningRequest(request);
 }
 
+/** State shared by the background jobs that sample a planning result */
+struct OCPNInterfaceImpl::SamplingJob
+{
+    std::shared_ptr<SampledPlanningResult> result;
+    gps_base::UTMConversionParameters parameters;
+    base::Time dt;
+    /** Number of batches not yet sampled */
+    std::atomic<size_t> remaining { 0 };
+};
+
 void OCPNInterfaceImpl::updatePlanningResult(PlanningResult const& result, base::Time dt)
 {
-    std::vector<SampledTrajectory> sampled;
-    sampled.reserve(result.trajectories.size());
-    for (auto const& rockTrajectory : result.trajectories) {
-        sampled.push_back(sampleTrajectory(rockTrajectory, dt));
+    auto sampled = make_shared<SampledPlanningResult>();
+    sampled->revision = ++lastPlanningResultRevision;
+    sampled->id = result.id;
+    sampled->success = result.success;
+    sampled->invalid_waypoint = result.invalid_waypoint;
+    sampled->error_message = result.error_message;
+    sampled->origin = mMercatorOrigin;
+    sampled->trajectories = result.trajectories;
+    sampled->sampled.resize(result.trajectories.size());
+    atomic_store(&mReceivedPlanningResult,
+        shared_ptr<PlanningResult const>(sampled));
+
+    // Split the trajectories in one batch per thread, so that a single
+    // converter is created per thread
+    size_t batchCount = min(mSamplingPool.getSize(), result.trajectories.size());
+    if (batchCount == 0) {
+        publishPlanningResult(sampled);
+    }
+    else {
+        auto job = make_shared<SamplingJob>();
+        job->result = sampled;
+        {
+            lock_guard<mutex> lock(mLatLonConverterMutex);
+            job->parameters = mUTMParameters;
+        }
+        job->dt = dt;
+        job->remaining = batchCount;
+        for (size_t i = 0; i < batchCount; ++i) {
+            mSamplingPool.push([this, job, i, batchCount] {
+                sampleBatch(*job, i, batchCount);
+            });
+        }
+    }
+
+    if (!result.success) {
+        showMessage("Planning route failed: " + result.error_message);
+    }
+}
+
+void OCPNInterfaceImpl::sampleBatch(
+    SamplingJob& job, size_t batch, size_t batchCount
+)
+{
+    auto& result = *job.result;
+    // Do not bother sampling if a newer result has been received
+    if (result.revision == lastPlanningResultRevision) {
+        gps_base::UTMConverter converter(job.parameters);
+        for (size_t i = batch; i < result.trajectories.size(); i += batchCount) {
+            result.sampled[i] = sampleTrajectory(
+                result.trajectories[i], converter, result.origin, job.dt
+            );
+        }
+    }
+
+    if (--job.remaining != 0) {
+        return;
+    }
+
+    // Last batch, finalize and publish
+    if (result.revision == lastPlanningResultRevision) {
+        for (auto const& trajectory : result.sampled) {
+            result.geometry.addTrajectory(trajectory.points);
+        }
+        result.geometry.buildLevelsOfDetail();
+        publishPlanningResult(job.result);
     }
-    currentPlanningResult.id = result.id;
-    currentPlanningResult.success = result.success;
-    currentPlanningResult.invalid_waypoint = result.invalid_waypoint;
-    currentPlanningResult.error_message = result.error_message;
-    currentPlanningResult.trajectories = result.trajectories;
-    currentPlanningResult.sampled = std::move(sampled);
+}
 
-    if (!currentPlanningResult.success) {
-        wxMessageBox("Planning route failed: " + currentPlanningResult.error_message);
+void OCPNInterfaceImpl::publishPlanningResult(
+    std::shared_ptr<SampledPlanningResult const> result
+)
+{
+    // Replace the current result only if it is older, retrying if another
+    // thread published in between
+    auto current = atomic_load(&mCurrentPlanningResult);
+    while (current->revision < result->revision) {
+        if (atomic_compare_exchange_weak(&mCurrentPlanningResult, &current, result)) {
+            return;
+        }
     }
 }
 
 bool OCPNInterfaceImpl::hasValidPlanningResultForRoute(std::string guid) const {
     return lastPlannedRouteGUID == guid &&
-           lastPlanningRequestID == currentPlanningResult.id;
+           lastPlanningRequestID == atomic_load(&mReceivedPlanningResult)->id;
 }
 
 bool OCPNInterfaceImpl::executeCurrentTrajectories(std::string guid) {
-    if (!hasValidPlanningResultForRoute(guid))
+    // Use a single snapshot for both the check and the execution
+    auto received = atomic_load(&mReceivedPlanningResult);
+    if (lastPlannedRouteGUID != guid || lastPlanningRequestID != received->id)
         return false;
-    pushTrajectoriesForExecution(currentPlanningResult.trajectories);
+    pushTrajectoriesForExecution(received->trajectories);
     return true;
 }
 
-OCPNInterfaceImpl::SampledPlanningResult const&
+std::shared_ptr<OCPNInterfaceImpl::SampledPlanningResult const>
     OCPNInterfaceImpl::getCurrentPlanningResult() const
 {
-    return currentPlanningResult;
+    return atomic_load(&mCurrentPlanningResult);
 }
 
-
 OCPNInterfaceImpl::SampledTrajectory OCPNInterfaceImpl::sampleTrajectory(
     usv_control::Trajectory const& trajectory, base::Time dt)
+{
+    lock_guard<mutex> lock(mLatLonConverterMutex);
+    return sampleTrajectory(trajectory, mLatLonConverter, mMercatorOrigin, dt);
+}
+
+OCPNInterfaceImpl::SampledTrajectory OCPNInterfaceImpl::sampleTrajectory(
+    usv_control::Trajectory const& trajectory,
+    gps_base::UTMConverter const& converter,
+    mercator::Origin const& origin,
+    base::Time dt)
 {
     auto startTime = trajectory.getStartTime();
     auto endTime   = trajectory.getEndTime();
@@ -134,12 +324,15 @@ OCPNInterfaceImpl::SampledTrajectory OCPNInterfaceImpl::sampleTrajectory(
 
         base::samples::RigidBodyState rbs;
         rbs.position = Eigen::Vector3d(p.x(), p.y(), 0);
-        auto latlon = mLatLonConverter.convertNWUToGPS(rbs);
+        auto latlon = converter.convertNWUToGPS(rbs);
 
         TrajectoryPoint ocpnPoint;
         ocpnPoint.latitude_deg  = latlon.latitude;
         ocpnPoint.longitude_deg = latlon.longitude;
         ocpnPoint.velocity = v.norm();
+        auto local = origin.toLocal(latlon.latitude, latlon.longitude);
+        ocpnPoint.x = local.x();
+        ocpnPoint.y = local.y();
         sampledPoints.push_back(ocpnPoint);
     }
 
@@ -148,101 +341,199 @@ OCPNInterfaceImpl::SampledTrajectory OCPNInterfaceImpl::sampleTrajectory(
     return sampledTrajectory;
 }
 
-void OCPNInterfaceImpl::pushNMEA(string nmea)
+void OCPNInterfaceImpl::deferGUIRequests(
+    size_t queueSize, std::function<void()> notifier
+)
 {
-    wxString wxnmea(nmea);
-    PushNMEABuffer(wxnmea);
+    mGUIRequests.reset(new SPSCQueue<GUIRequest>(queueSize));
+    mGUIRequestNotifier = notifier;
 }
 
-template <typename T>
-utils::optional<T> marnav_from_rock(T value) {
-    if (base::isUnknown(value)) {
-        return utils::make_optional<T>();
-    }
-    else {
-        return utils::make_optional<T>(value);
+bool OCPNInterfaceImpl::processGUIRequests()
+{
+    GUIRequest request;
+    while (mGUIRequests && mGUIRequests->pop(request)) {
+        switch (request.type) {
+            case GUIRequest::PUSH_NMEA:
+                mNMEAQueue.push(request.key, move(request.text));
+                break;
+            case GUIRequest::MESSAGE_BOX:
+                wxMessageBox(request.text);
+                break;
+        }
     }
+
+    mNMEAQueue.flush(mNMEABudget, [this](string const& sentences) {
+        mNMEAOutput.push(sentences.data(), sentences.size());
+    });
+    return !mNMEAQueue.empty();
 }
 
-ais::rate_of_turn rot_marnav_from_rock(double value) {
-    if (base::isUnknown(value)) {
-        return ais::rate_of_turn();
+void OCPNInterfaceImpl::setNMEABudget(size_t budget)
+{
+    mNMEABudget = budget;
+}
+
+void OCPNInterfaceImpl::setNMEAIngest(NMEAIngest* ingest)
+{
+    mNMEAIngest = ingest;
+}
+
+uint64_t OCPNInterfaceImpl::getNMEACoalescedCount() const
+{
+    return mNMEAQueue.getCoalescedCount();
+}
+
+uint64_t OCPNInterfaceImpl::getGUIQueueHighWaterMark() const
+{
+    return mGUIRequests ? mGUIRequests->getHighWaterMark() : 0;
+}
+
+uint64_t OCPNInterfaceImpl::getGUIQueueDropCount() const
+{
+    return mGUIRequests ? mGUIRequests->getDropCount() : 0;
+}
+
+void OCPNInterfaceImpl::pushNMEA(NMEACoalescingQueue::Key const& key, string nmea)
+{
+    if (mGUIRequests) {
+        GUIRequest request;
+        request.type = GUIRequest::PUSH_NMEA;
+        request.text = move(nmea);
+        request.key = key;
+        mGUIRequests->push(move(request));
+        mGUIRequestNotifier();
+        return;
     }
-    else {
-        return ais::rate_of_turn(value * RAD2DEG * 60);
+
+    mNMEAQueue.push(key, move(nmea));
+}
+
+void OCPNInterfaceImpl::showMessage(string message)
+{
+    if (mGUIRequests) {
+        GUIRequest request;
+        request.type = GUIRequest::MESSAGE_BOX;
+        request.text = move(message);
+        mGUIRequests->push(move(request));
+        mGUIRequestNotifier();
+        return;
     }
+
+    wxMessageBox(message);
 }
 
-template<typename Ret>
-utils::optional<Ret> marnav_from_rock(base::Angle value) {
-    double deg = value.getDeg();
-    if (base::isUnknown(deg)) {
-        return utils::optional<Ret>();
+/** Send an AIS position message to OpenCPN */
+void OCPNInterfaceImpl::updateAIS(ais_base::Position const& position)
+{
+    base::Time now = base::Time::now();
+    auto target_class = AISEncoder::getTargetClass(position);
+    if (mOverlayClasses & (1 << target_class)) {
+        mContacts.updatePosition(position, now);
     }
-    else if (deg < 0) {
-        return utils::make_optional<Ret>(-deg);
+    if (!(mNMEAClasses & (1 << target_class))) {
+        return;
     }
-    else {
-        return utils::make_optional<Ret>(360 - deg);
+
+    auto decision = mAISScheduler.schedule(position, now);
+    bool has_budget = mAISScheduler.hasBudget(decision, now);
+    if (!mAISTargets.updatePosition(position, now, decision.interval, has_budget)) {
+        return;
+    }
+
+    mAISEncoder.clear();
+    mAISEncoder.setPosition(position);
+    if (target_class == AISEncoder::AID_TO_NAVIGATION) {
+        // Message 21 has both the position and the static data, which is
+        // sent along with each position
+        if (mAISTargets.getStatic(position.mmsi, mAISStatic)) {
+            mAISEncoder.setVessel(mAISStatic);
+        }
+        mAISEncoder.encode(AISEncoder::MESSAGE_21);
+        mAISScheduler.consume(mAISEncoder.getFragmentCount());
+        pushAIS(AIS_AID_TO_NAVIGATION_REPORT, position.mmsi, mAISEncoder.str());
+        return;
     }
-}
 
-template<typename Ret>
-utils::optional<Ret> latlon_marnav_from_rock(base::Angle value) {
-    double deg = value.getDeg();
-    if (base::isUnknown(deg)) {
-        return utils::optional<Ret>();
+    if (target_class == AISEncoder::CLASS_B) {
+        mAISEncoder.encode(AISEncoder::MESSAGE_18);
+        mAISScheduler.consume(mAISEncoder.getFragmentCount());
+        pushAIS(AIS_CLASS_B_POSITION_REPORT, position.mmsi, mAISEncoder.str());
     }
     else {
-        return utils::make_optional<Ret>(deg);
+        mAISEncoder.encode(AISEncoder::MESSAGE_1);
+        mAISScheduler.consume(mAISEncoder.getFragmentCount());
+        pushAIS(AIS_POSITION_REPORT, position.mmsi, mAISEncoder.str());
     }
-}
 
-/** Send an AIS position message to OpenCPN */
-void OCPNInterfaceImpl::updateAIS(ais_base::Position const& position)
-{
-    ais::message_01 ais_position;
-    ais_position.set_mmsi(utils::mmsi(position.mmsi));
-    ais_position.set_nav_status(
-        static_cast<ais::navigation_status>(position.status)
-    );
-    ais_position.set_rot(rot_marnav_from_rock(position.yaw_velocity));
-    ais_position.set_sog(marnav_from_rock(position.speed_over_ground * SI2KNOTS));
-    ais_position.set_position_accuracy(position.high_accuracy_position);
-    ais_position.set_cog(marnav_from_rock<double>(position.course_over_ground));
-    ais_position.set_hdg(marnav_from_rock<uint32_t>(position.yaw));
-    ais_position.set_longitude(
-        latlon_marnav_from_rock<geo::longitude>(position.longitude)
-    );
-    ais_position.set_latitude(
-        latlon_marnav_from_rock<geo::latitude>(position.latitude)
-    );
-    pushAIS(ais_position);
+    // Re-send the static data at the cadence of a real transponder, even
+    // if Rock does not publish it again
+    if (mAISTargets.takeDueStatic(position.mmsi, now, mAISStatic)) {
+        pushAISStatic(target_class, mAISStatic);
+    }
 }
 
 /** Send an AIS vessel message to OpenCPN */
 void OCPNInterfaceImpl::updateAIS(ais_base::VesselInformation const& vessel)
 {
-    ais::message_05 ais_vessel;
-    ais_vessel.set_mmsi(utils::mmsi(vessel.mmsi));
-    ais_vessel.set_imo_number(vessel.imo);
-    ais_vessel.set_callsign(vessel.call_sign);
-    ais_vessel.set_shipname(vessel.name);
-    ais_vessel.set_shiptype(ais::ship_type(vessel.ship_type));
-    ais_vessel.set_to_bow(vessel.length / 2);
-    ais_vessel.set_to_stern(vessel.length / 2);
-    ais_vessel.set_to_port(vessel.width / 2);
-    ais_vessel.set_to_starboard(vessel.width / 2);
-    ais_vessel.set_draught(vessel.draft);
-    pushAIS(ais_vessel);
+    base::Time now = base::Time::now();
+    if (mOverlayClasses) {
+        mContacts.updateStatic(vessel, now);
+    }
+
+    // The contact overlay knows the class of the targets that are not sent
+    // as NMEA, the target table does not
+    AISEncoder::TargetClass target_class;
+    if (!mContacts.getTargetClass(vessel.mmsi, target_class)) {
+        target_class = mAISTargets.getTargetClass(vessel.mmsi);
+    }
+    if (!(mNMEAClasses & (1 << target_class))) {
+        return;
+    }
+    if (!mAISTargets.updateStatic(vessel, now)) {
+        return;
+    }
+
+    if (target_class == AISEncoder::AID_TO_NAVIGATION) {
+        // Sent with the next position, in message 21
+        return;
+    }
+    pushAISStatic(target_class, vessel);
 }
 
-template <typename T>
-void OCPNInterfaceImpl::pushAIS(T const& message)
+void OCPNInterfaceImpl::pushAISStatic(
+    AISEncoder::TargetClass target_class,
+    ais_base::VesselInformation const& vessel
+)
+{
+    mAISEncoder.clear();
+    mAISEncoder.setVessel(vessel);
+    if (target_class == AISEncoder::CLASS_B) {
+        // Both parts are sent as a single entry, so that they are not
+        // coalesced separately
+        mAISEncoder.encode(AISEncoder::MESSAGE_24A);
+        mAISScheduler.consume(mAISEncoder.getFragmentCount());
+        string nmea = mAISEncoder.str();
+        nmea += '\n';
+        mAISEncoder.encode(AISEncoder::MESSAGE_24B);
+        mAISScheduler.consume(mAISEncoder.getFragmentCount());
+        nmea.append(mAISEncoder.data(), mAISEncoder.size());
+        pushAIS(AIS_CLASS_B_STATIC_DATA, vessel.mmsi, move(nmea));
+    }
+    else {
+        mAISEncoder.encode(AISEncoder::MESSAGE_5);
+        mAISScheduler.consume(mAISEncoder.getFragmentCount());
+        pushAIS(AIS_STATIC_DATA, vessel.mmsi, mAISEncoder.str());
+    }
+}
+
+void OCPNInterfaceImpl::pushAIS(uint32_t type, uint32_t mmsi, string nmea)
 {
-    auto payload = ais::encode_message(message);
-    auto sentences = marnav::nmea::make_vdms(payload);
-    for (auto const& s : sentences) {
-        pushNMEA(marnav::nmea::to_string(*s));
+    if (mNMEAIngest) {
+        // OpenCPN forwards our own AIS messages back to the plugin
+        mNMEAIngest->ignoreAISTarget(mmsi, base::Time::now());
     }
+
+    NMEACoalescingQueue::Key key(NMEA_KEY_AIS + type, mmsi);
+    pushNMEA(key, move(nmea));
 }
@@ -4,13 +4,31 @@
 #include <wx/wx.h>
 #include "ocpn_plugin.h"
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <seabots_pi/OCPNInterface.hpp> // Provided by gui/orogen/seabots_pi
 #include <base/samples/RigidBodyState.hpp>
 #include <gps_base/UTMConverter.hpp>
 #include <usv_control/Trajectory.hpp>
+#include "AISEncoder.hpp"
+#include "AISScheduler.hpp"
+#include "AISTargetTable.hpp"
+#include "ContactBuffer.hpp"
+#include "Mercator.hpp"
+#include "NMEA.hpp"
+#include "NMEAOutput.hpp"
+#include "NMEACoalescingQueue.hpp"
+#include "PosePublicationPolicy.hpp"
+#include "TrajectoryGeometry.hpp"
+#include "WorkerPool.hpp"
+#include "SPSCQueue.hpp"
 
 namespace seabots_pi {
+    class NMEAIngest;
+
     /**
      *
      */
@@ -23,6 +41,11 @@ namespace seabots_pi {
             float latitude_deg = base::unknown<double>();
             float longitude_deg = base::unknown<double>();
             float velocity = base::unknown<double>();
+            /** Mercator coordinates in meters, relative to the planning
+             * result's origin
+             */
+            float x = base::unknown<double>();
+            float y = base::unknown<double>();
         };
 
         struct SampledTrajectory
@@ -34,54 +57,380 @@ namespace seabots_pi {
 
         struct SampledPlanningResult : PlanningResult
         {
+            /** Counter incremented each time the sampled result changes
+             *
+             * Unlike the planning result ID, it is unique for each
+             * sampling, which makes it usable as a cache key by the
+             * renderer
+             */
+            uint64_t revision = 0;
+            /** Origin of the points' mercator coordinates */
+            mercator::Origin origin;
             std::vector<SampledTrajectory> sampled;
+            /** The mercator coordinates of all sampled trajectories, packed
+             * for rendering, with their levels of detail
+             */
+            TrajectoryGeometry geometry;
+        };
+
+        /** A call to wx or OpenCPN deferred to the GUI thread */
+        struct GUIRequest
+        {
+            enum Type
+            {
+                PUSH_NMEA,
+                MESSAGE_BOX
+            };
+
+            Type type = PUSH_NMEA;
+            std::string text;
+            /** Coalescing key of PUSH_NMEA requests */
+            NMEACoalescingQueue::Key key;
+        };
+
+        /** Types of the keys under which the NMEA sentences are coalesced
+         *
+         * AIS messages are keyed by NMEA_KEY_AIS plus the message ID, and
+         * the MMSI
+         */
+        enum NMEAKeyType
+        {
+            NMEA_KEY_POSE = 0,
+            NMEA_KEY_AIS = 0x100
         };
 
+        /** Defer all calls to wx and OpenCPN to the GUI thread
+         *
+         * This is needed when the task runs in its own thread. It must be
+         * called before the task is started. The calls are queued and
+         * executed by processGUIRequests. The notifier is called from the
+         * task's thread after each queued request, to wake the GUI thread up.
+         * The queue has a single producer, so once enabled the methods that
+         * call wx or OpenCPN must all be called from the task's thread
+         *
+         * @param queueSize maximum number of pending requests. Requests
+         *   queued while the queue is full are dropped
+         */
+        void deferGUIRequests(
+            size_t queueSize, std::function<void()> notifier
+        );
+
+        /** Execute the deferred GUI requests, and send the pending NMEA
+         * sentences to OpenCPN within the per-call budget
+         *
+         * Must be called from the GUI thread
+         *
+         * @return true if NMEA sentences are still pending because of the
+         *   budget
+         */
+        bool processGUIRequests();
+
+        /** Set the maximum number of NMEA sentences sent to OpenCPN per call
+         * to processGUIRequests, zero for no limit
+         */
+        void setNMEABudget(size_t budget);
+
+        /** Number of NMEA sentences dropped because newer ones for the same
+         * stream were queued before they were sent
+         *
+         * Must be called from the GUI thread
+         */
+        uint64_t getNMEACoalescedCount() const;
+
+        /** Set the ingest path of OpenCPN's sentences, so that it ignores
+         * the AIS targets sent by this interface
+         *
+         * The ingest object must outlive this interface, or be reset to
+         * null first
+         */
+        void setNMEAIngest(NMEAIngest* ingest);
+
+        /** Maximum number of GUI requests that were pending at the same time
+         */
+        uint64_t getGUIQueueHighWaterMark() const;
+
+        /** Number of GUI requests dropped because the queue was full */
+        uint64_t getGUIQueueDropCount() const;
+
         /** Configure the UTM-to-LatLon converter */
         void setUTMConversionParameters(
             gps_base::UTMConversionParameters const& parameters
         );
 
-        /** Send the system pose to OpenCPN */
+        /** Select the sentences sent by updateSystemPose
+         *
+         * @param sentences set of nmea::PoseSentences flags
+         */
+        void setPoseSentences(int sentences);
+
+        /** Configure the rate limit and dead-band of updateSystemPose */
+        void setPosePublicationConfiguration(
+            PosePublicationPolicy::Configuration const& configuration
+        );
+
+        /** Number of system poses not sent because of the rate limit */
+        uint64_t getPoseRateSuppressedCount() const;
+
+        /** Number of system poses not sent because they were within the
+         * dead-band of the last sent pose
+         */
+        uint64_t getPoseDeadbandSuppressedCount() const;
+
+        /** Configure the change detection and static data cadence of
+         * updateAIS
+         */
+        void setAISTargetTableConfiguration(
+            AISTargetTable::Configuration const& configuration
+        );
+
+        /** Configure the range- and risk-based rates of updateAIS, and its
+         * budget
+         */
+        void setAISSchedulerConfiguration(
+            AISScheduler::Configuration const& configuration
+        );
+
+        /** The state of the AIS targets sent to OpenCPN
+         *
+         * Its statistics may be read from any thread
+         */
+        AISTargetTable const& getAISTargetTable() const;
+
+        /** Select, per AIS target class, whether the targets are sent to
+         * OpenCPN as NMEA and whether they are drawn by the plugin's own
+         * contact overlay
+         *
+         * Drawing dense traffic in the overlay instead of going through
+         * OpenCPN's AIS decoder avoids its per-target cost. It must be
+         * called before the task is started
+         *
+         * @param nmea_classes set of (1 << AISEncoder::TargetClass) flags
+         *   of the targets sent as NMEA
+         * @param overlay_classes set of (1 << AISEncoder::TargetClass) flags
+         *   of the targets added to the contact overlay
+         */
+        void setContactRouting(int nmea_classes, int overlay_classes);
+
+        /** Configure the timeout of the contact overlay */
+        void setContactBufferConfiguration(
+            ContactBuffer::Configuration const& configuration
+        );
+
+        /** The contacts drawn by the overlay
+         *
+         * Its snapshots may be taken from any thread
+         */
+        ContactBuffer const& getContacts() const;
+
+        /** Remove the contacts that timed out from the contact overlay
+         *
+         * It may be called from any thread
+         *
+         * @return true if contacts were removed
+         */
+        bool pruneContacts(base::Time const& now);
+
+        /** Send the system pose to OpenCPN
+         *
+         * Poses are filtered by the pose publication policy first.
+         *
+         * All the selected sentences are generated from the same conversion
+         * to lat/lon and pushed as a single batch. ROT is skipped if the
+         * pose has no valid angular velocity
+         *
+         * The published poses are also the ownship fix of the AIS scheduler
+         */
         void updateSystemPose(base::samples::RigidBodyState const& rbs);
 
         /** Send an OpenCPN route to the Rock system */
         void pushRoute(PlugIn_Route const& route);
 
-        /** Send an AIS position message to OpenCPN */
+        /** Send an AIS position message to OpenCPN
+         *
+         * Depending on the contact routing, the target is also, or only,
+         * added to the contact overlay. The rest applies to the targets
+         * sent as NMEA.
+         *
+         * The message depends on the target's class, see
+         * AISEncoder::getTargetClass: message 1 for class A, 18 for class B
+         * and 21 for aids to navigation.
+         *
+         * Positions identical to the last one sent for the same target are
+         * skipped, see AISTargetTable. Positions are also decimated based on
+         * the target's range and risk, within a global budget, see
+         * AISScheduler. The target's last static data is re-sent along with
+         * it when due
+         */
         void updateAIS(ais_base::Position const& position);
 
-        /** Send an AIS vessel message to OpenCPN */
+        /** Send an AIS vessel message to OpenCPN
+         *
+         * It is sent as a message 5 for class A targets, and messages 24A
+         * and 24B for class B targets. The class is the one of the target's
+         * last position. The static data of aids to navigation is sent with
+         * their next position.
+         *
+         * It is skipped if it did not change since the last one sent for
+         * the same target, see AISTargetTable, or if the target is not sent
+         * as NMEA. The length of the target is updated in the contact
+         * overlay
+         */
         void updateAIS(ais_base::VesselInformation const& vessel);
 
-        /** Check if we have a valid planning result for the given route */
+        /** Check if we have a valid planning result for the given route
+         *
+         * It is the last received result, even if its sampling for
+         * visualization is not finished yet
+         */
         bool hasValidPlanningResultForRoute(std::string guid) const;
 
-        /** Execute the current planning result for the given route */
+        /** Execute the last received planning result for the given route */
         bool executeCurrentTrajectories(std::string guid);
 
-        /** Visualize the trajectory planned by the seabots system */
+        /** Visualize the trajectory planned by the seabots system
+         *
+         * The trajectories are sampled in background threads. The result
+         * becomes visible through getCurrentPlanningResult once all of them
+         * are sampled, unless a newer result has been received in the
+         * meantime
+         */
         virtual void updatePlanningResult(
             PlanningResult const& result,
             base::Time dt = base::Time::fromSeconds(5)
         );
 
-        SampledPlanningResult const& getCurrentPlanningResult() const;
+        /** The last planning result whose sampling is finished
+         *
+         * The returned snapshot is immutable and stays valid even if a newer
+         * result gets published. It can be called from any thread
+         */
+        std::shared_ptr<SampledPlanningResult const>
+            getCurrentPlanningResult() const;
 
         SampledTrajectory sampleTrajectory(
             usv_control::Trajectory const& trajectory,
             base::Time dt = base::Time::fromSeconds(5)
         );
 
+        /** Sample a trajectory using the given converter
+         *
+         * Converters cannot be shared between threads, this is the
+         * overload used by the background threads
+         */
+        static SampledTrajectory sampleTrajectory(
+            usv_control::Trajectory const& trajectory,
+            gps_base::UTMConverter const& converter,
+            mercator::Origin const& origin,
+            base::Time dt
+        );
+
     private:
-        template<typename T> void pushAIS(T const& msg);
-        void pushNMEA(std::string nmea);
+        struct SamplingJob;
+        void sampleBatch(SamplingJob& job, size_t batch, size_t batchCount);
+        void publishPlanningResult(
+            std::shared_ptr<SampledPlanningResult const> result
+        );
+
+        /** The AIS message types sent to OpenCPN */
+        enum AISMessageType {
+            AIS_POSITION_REPORT = 1,
+            AIS_STATIC_DATA = 5,
+            AIS_CLASS_B_POSITION_REPORT = 18,
+            AIS_AID_TO_NAVIGATION_REPORT = 21,
+            AIS_CLASS_B_STATIC_DATA = 24
+        };
+        /** Queue the sentences of an AIS message of the given type */
+        void pushAIS(uint32_t type, uint32_t mmsi, std::string nmea);
+        /** Queue the static data of a class A or class B target */
+        void pushAISStatic(
+            AISEncoder::TargetClass target_class,
+            ais_base::VesselInformation const& vessel
+        );
+        /** Queue NMEA sentences for OpenCPN
+         *
+         * The string may contain several newline-separated sentences, which
+         * are then handled as a single entry. They replace the sentences of
+         * the same key that have not been sent yet
+         */
+        void pushNMEA(NMEACoalescingQueue::Key const& key, std::string nmea);
+        void showMessage(std::string message);
+
+        /** Pending GUI requests, if they are deferred */
+        std::unique_ptr<SPSCQueue<GUIRequest>> mGUIRequests;
+        std::function<void()> mGUIRequestNotifier;
+
+        /** Conversion of the NMEA sentences to OpenCPN's wxString, used
+         * from the GUI thread only
+         */
+        NMEAOutput mNMEAOutput { PushNMEABuffer };
+        /** NMEA sentences waiting to be sent to OpenCPN, used from the GUI
+         * thread only
+         */
+        NMEACoalescingQueue mNMEAQueue;
+        size_t mNMEABudget = 0;
+        NMEAIngest* mNMEAIngest = nullptr;
 
+        int mPoseSentences = nmea::POSE_ALL;
+        PosePublicationPolicy mPosePublicationPolicy;
+        AISTargetTable mAISTargets;
+        /** Used from the task thread only */
+        AISScheduler mAISScheduler;
+        /** Used from the task thread only */
+        AISEncoder mAISEncoder;
+        /** Static data read from the target table, kept so that its
+         * strings' storage is reused. Used from the task thread only
+         */
+        ais_base::VesselInformation mAISStatic;
+
+        int mNMEAClasses = AISEncoder::ALL_TARGET_CLASSES;
+        int mOverlayClasses = 0;
+        ContactBuffer mContacts;
+
+        /** Protects the converter and its parameters
+         *
+         * The converter is used by both the task and the GUI threads when
+         * the task has its own thread
+         */
+        mutable std::mutex mLatLonConverterMutex;
+        gps_base::UTMConversionParameters mUTMParameters;
         gps_base::UTMConverter mLatLonConverter;
+        /** Origin of the mercator coordinates of the sampled trajectories
+         *
+         * It is the lat/lon of the NWU frame origin
+         */
+        mercator::Origin mMercatorOrigin;
 
         uint64_t lastPlanningRequestID;
         std::string lastPlannedRouteGUID;
-        SampledPlanningResult currentPlanningResult;
+        std::atomic<uint64_t> lastPlanningResultRevision { 0 };
+
+        /** The current planning result
+         *
+         * Published snapshots are never modified. It must only be accessed
+         * through the std::atomic_* shared_ptr functions, so that the
+         * renderer, the execution path and the sampling threads can read and
+         * replace it concurrently without locking
+         */
+        std::shared_ptr<SampledPlanningResult const> mCurrentPlanningResult =
+            std::make_shared<SampledPlanningResult>();
+
+        /** The last received planning result, used by the execution path
+         *
+         * It is published as soon as the result is received, before its
+         * sampling is finished. Only the PlanningResult fields are read
+         * through it, the sampling threads only write the other ones. It
+         * must only be accessed through the std::atomic_* shared_ptr
+         * functions
+         */
+        std::shared_ptr<PlanningResult const> mReceivedPlanningResult =
+            std::make_shared<PlanningResult>();
+
+        /** Threads used to sample the planning results
+         *
+         * It must be the last member, so that the threads are stopped
+         * before the state they use is destroyed
+         */
+        WorkerPool mSamplingPool;
     };
 }
 
@@ -1,10 +1,13 @@
 #include "Plugin.hpp"
 #include "OCPNInterfaceImpl.hpp"
 #include "Paths.hpp"
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 #include <wx/filename.h>
 #include <wx/file.h>
+#include <wx/fileconf.h>
 #include <GL/gl.h>
 #include <GL/glext.h>
 
@@ -41,6 +44,7 @@
 #include <logger/transports/mqueue/TransportPlugin.hpp>
 
 #include <rtt/Activity.hpp>
+#include <rtt/OutputPort.hpp>
 #include <rtt/TaskContext.hpp>
 #include <rtt/base/ActivityInterface.hpp>
 #include <rtt/extras/SlaveActivity.hpp>
@@ -69,14 +73,53 @@ void Plugin::orogenTaskTimer::Notify()
     plugin.executeTasks();
 }
 
+Plugin::orogenTaskEventHandler::orogenTaskEventHandler(Plugin& plugin)
+    : plugin(plugin)
+{
+    Bind(wxEVT_THREAD, &orogenTaskEventHandler::onExecuteTasks, this,
+         EXECUTE_TASKS);
+    Bind(wxEVT_THREAD, &orogenTaskEventHandler::onProcessGUIRequests, this,
+         PROCESS_GUI_REQUESTS);
+}
+void Plugin::orogenTaskEventHandler::onExecuteTasks(wxThreadEvent& event)
+{
+    plugin.executeTasks();
+}
+void Plugin::orogenTaskEventHandler::onProcessGUIRequests(wxThreadEvent& event)
+{
+    plugin.processGUIRequests();
+}
+
+struct Plugin::orogenTaskActivity : public RTT::extras::SlaveActivity
+{
+    Plugin& plugin;
+    orogenTaskActivity(Plugin& plugin, RTT::ExecutionEngine* engine)
+        : RTT::extras::SlaveActivity(engine)
+        , plugin(plugin) {}
+
+    bool trigger()
+    {
+        plugin.queueTaskExecution();
+        return true;
+    }
+
+    bool timeout()
+    {
+        plugin.queueTaskExecution();
+        return true;
+    }
+};
+
 Plugin::Plugin(void* pptr)
     : opencpn_plugin_116(pptr)
     , mTimer(*this)
+    , mTaskEventHandler(*this)
 {
 }
 
 int Plugin::Init() {
     loadSVGs();
+    loadConfiguration();
 
     static char const* argv[] = { "seabots_pi" };
     RTT::corba::ApplicationServer::InitOrb(1, const_cast<char**>(argv));
@@ -124,17 +167,289 @@ int Plugin::Init() {
     Task* main_task = new Task("seabots_pi");
     mInterface = new OCPNInterfaceImpl(*main_task);
     main_task->setOCPNInterface(mInterface);
-    setupTaskActivity(main_task);
+    mInterface->setPoseSentences(mPoseSentences);
+    mInterface->setPosePublicationConfiguration(mPosePublication);
+    mInterface->setNMEABudget(std::max(mNMEABudget, 0));
+    mInterface->setAISTargetTableConfiguration(mAISTargets);
+    mInterface->setAISSchedulerConfiguration(mAISScheduler);
+    mInterface->setContactRouting(mAISNMEAClasses, mContactOverlayClasses);
+    mInterface->setContactBufferConfiguration(mContactBuffer);
+    mTaskExecutionLatencyPort =
+        new RTT::OutputPort<base::Time>("execution_latency");
+    main_task->ports()->addPort(*mTaskExecutionLatencyPort).doc(
+        "time between the arrival of new data and the task execution"
+    );
+    mGUIQueueHighWaterMarkPort =
+        new RTT::OutputPort<uint64_t>("gui_queue_high_water_mark");
+    main_task->ports()->addPort(*mGUIQueueHighWaterMarkPort).doc(
+        "maximum number of calls to the GUI that were pending at the same time"
+    );
+    mGUIQueueDropCountPort =
+        new RTT::OutputPort<uint64_t>("gui_queue_drop_count");
+    main_task->ports()->addPort(*mGUIQueueDropCountPort).doc(
+        "number of calls to the GUI dropped because the queue was full"
+    );
+    mNMEACoalescedCountPort =
+        new RTT::OutputPort<uint64_t>("nmea_coalesced_count");
+    main_task->ports()->addPort(*mNMEACoalescedCountPort).doc(
+        "number of NMEA sentences not sent to OpenCPN because newer ones "
+        "for the same stream superseded them"
+    );
+    mPoseRateSuppressedCountPort =
+        new RTT::OutputPort<uint64_t>("pose_rate_suppressed_count");
+    main_task->ports()->addPort(*mPoseRateSuppressedCountPort).doc(
+        "number of system poses not sent to OpenCPN because of the rate limit"
+    );
+    mPoseDeadbandSuppressedCountPort =
+        new RTT::OutputPort<uint64_t>("pose_deadband_suppressed_count");
+    main_task->ports()->addPort(*mPoseDeadbandSuppressedCountPort).doc(
+        "number of system poses not sent to OpenCPN because they did not "
+        "change enough"
+    );
+    mAISPositionSuppressedCountPort =
+        new RTT::OutputPort<uint64_t>("ais_position_suppressed_count");
+    main_task->ports()->addPort(*mAISPositionSuppressedCountPort).doc(
+        "number of AIS positions not sent to OpenCPN because they were "
+        "identical to the last one of the same target"
+    );
+    mAISPositionDecimatedCountPort =
+        new RTT::OutputPort<uint64_t>("ais_position_decimated_count");
+    main_task->ports()->addPort(*mAISPositionDecimatedCountPort).doc(
+        "number of AIS positions not sent to OpenCPN because of the rate "
+        "given to the target by its range and collision risk"
+    );
+    mAISPositionOverBudgetCountPort =
+        new RTT::OutputPort<uint64_t>("ais_position_over_budget_count");
+    main_task->ports()->addPort(*mAISPositionOverBudgetCountPort).doc(
+        "number of AIS positions not sent to OpenCPN because the AIS "
+        "sentence budget was exhausted"
+    );
+    mAISStaticSuppressedCountPort =
+        new RTT::OutputPort<uint64_t>("ais_static_suppressed_count");
+    main_task->ports()->addPort(*mAISStaticSuppressedCountPort).doc(
+        "number of AIS static data not sent to OpenCPN because they did not "
+        "change"
+    );
+    setupNMEAIngest(main_task);
+    setupTaskActivity(main_task, createMainTaskActivity(main_task));
 
     setupToolbar();
 
-    // Start timer
-    mTimer.Start(UPDATE_PERIOD_MS, wxTIMER_CONTINUOUS);
-    return (
+    // Start the fallback timer
+    if (mMaxUpdatePeriod > 0) {
+        mTimer.Start(std::max<int>(mMaxUpdatePeriod * 1000, 1), wxTIMER_CONTINUOUS);
+    }
+    int flags = (
         WANTS_TOOLBAR_CALLBACK |
         WANTS_DYNAMIC_OPENGL_OVERLAY_CALLBACK | WANTS_OPENGL_OVERLAY_CALLBACK | WANTS_OVERLAY_CALLBACK |
         INSTALLS_TOOLBAR_TOOL
     );
+    // Only receive the sentences if they are forwarded to Rock
+    if (mNMEAIngestConfiguration.enabled) {
+        flags |= WANTS_NMEA_SENTENCES | WANTS_AIS_SENTENCES;
+    }
+    return flags;
+}
+
+void Plugin::loadConfiguration()
+{
+    wxFileConfig* config = GetOCPNConfigObject();
+    if (!config) {
+        return;
+    }
+
+    auto& thread = mTaskThreadConfiguration;
+    config->SetPath(_T("/PlugIns/seabots_pi"));
+    config->Read(_T("TaskThread"), &thread.enabled, thread.enabled);
+    config->Read(_T("TaskThreadPriority"), &thread.priority, thread.priority);
+    long cpuAffinity;
+    config->Read(_T("TaskThreadCPUAffinity"), &cpuAffinity, thread.cpuAffinity);
+    thread.cpuAffinity = cpuAffinity;
+    config->Read(_T("TaskThreadPeriod"), &thread.period, thread.period);
+    config->Read(_T("GUIQueueSize"), &thread.guiQueueSize, thread.guiQueueSize);
+    config->Read(_T("MaxUpdatePeriod"), &mMaxUpdatePeriod, mMaxUpdatePeriod);
+
+    config->Read(_T("NMEABudget"), &mNMEABudget, mNMEABudget);
+
+    auto& ingest = mNMEAIngestConfiguration;
+    config->Read(_T("NMEAIngest"), &ingest.enabled, ingest.enabled);
+    config->Read(_T("NMEAIngestQueueSize"), &ingest.queueSize, ingest.queueSize);
+
+    auto& pose = mPosePublication;
+    double minPeriod = pose.min_period.toSeconds();
+    config->Read(_T("PoseMinPeriod"), &minPeriod, minPeriod);
+    pose.min_period = base::Time::fromSeconds(minPeriod);
+    double heartbeatPeriod = pose.heartbeat_period.toSeconds();
+    config->Read(_T("PoseHeartbeatPeriod"), &heartbeatPeriod, heartbeatPeriod);
+    pose.heartbeat_period = base::Time::fromSeconds(heartbeatPeriod);
+    config->Read(_T("PosePositionDeadband"),
+        &pose.position_deadband, pose.position_deadband);
+    double angleDeadband = base::Angle::rad2Deg(pose.angle_deadband);
+    config->Read(_T("PoseAngleDeadband"), &angleDeadband, angleDeadband);
+    pose.angle_deadband = base::Angle::deg2Rad(angleDeadband);
+    config->Read(_T("PoseSpeedDeadband"),
+        &pose.speed_deadband, pose.speed_deadband);
+
+    auto& ais = mAISTargets;
+    double staticPeriod = ais.static_period.toSeconds();
+    config->Read(_T("AISStaticPeriod"), &staticPeriod, staticPeriod);
+    ais.static_period = base::Time::fromSeconds(staticPeriod);
+    double positionRepeatPeriod = ais.position_repeat_period.toSeconds();
+    config->Read(_T("AISPositionRepeatPeriod"),
+        &positionRepeatPeriod, positionRepeatPeriod);
+    ais.position_repeat_period = base::Time::fromSeconds(positionRepeatPeriod);
+
+    auto& scheduler = mAISScheduler;
+    config->Read(_T("AISNearRange"), &scheduler.near_range, scheduler.near_range);
+    config->Read(_T("AISFarRange"), &scheduler.far_range, scheduler.far_range);
+    config->Read(_T("AISCPAThreshold"),
+        &scheduler.cpa_threshold, scheduler.cpa_threshold);
+    double tcpaThreshold = scheduler.tcpa_threshold.toSeconds();
+    config->Read(_T("AISTCPAThreshold"), &tcpaThreshold, tcpaThreshold);
+    scheduler.tcpa_threshold = base::Time::fromSeconds(tcpaThreshold);
+    config->Read(_T("AISSentencesPerSecond"),
+        &scheduler.sentences_per_second, scheduler.sentences_per_second);
+
+    double contactTimeout = mContactBuffer.timeout.toSeconds();
+    config->Read(_T("ContactTimeout"), &contactTimeout, contactTimeout);
+    mContactBuffer.timeout = base::Time::fromSeconds(contactTimeout);
+    config->Read(_T("ContactMinSize"), &mContactMinSize, mContactMinSize);
+
+    wxString nmeaClasses;
+    if (config->Read(_T("AISNMEAClasses"), &nmeaClasses)) {
+        try {
+            mAISNMEAClasses = AISEncoder::parseTargetClasses(nmeaClasses.ToStdString());
+        }
+        catch (std::invalid_argument const& e) {
+            cerr << "ignoring invalid AISNMEAClasses setting: " << e.what() << endl;
+        }
+    }
+    wxString overlayClasses;
+    if (config->Read(_T("ContactOverlayClasses"), &overlayClasses)) {
+        try {
+            mContactOverlayClasses =
+                AISEncoder::parseTargetClasses(overlayClasses.ToStdString());
+        }
+        catch (std::invalid_argument const& e) {
+            cerr << "ignoring invalid ContactOverlayClasses setting: " << e.what() << endl;
+        }
+    }
+
+    wxString poseSentences;
+    if (config->Read(_T("PoseSentences"), &poseSentences)) {
+        try {
+            mPoseSentences = nmea::parsePoseSentences(poseSentences.ToStdString());
+        }
+        catch (std::invalid_argument const& e) {
+            cerr << "ignoring invalid PoseSentences setting: " << e.what() << endl;
+        }
+    }
+}
+
+RTT::base::ActivityInterface* Plugin::createMainTaskActivity(RTT::TaskContext* task)
+{
+    auto const& thread = mTaskThreadConfiguration;
+    if (!thread.enabled) {
+        return new orogenTaskActivity(*this, task->engine());
+    }
+
+    mInterface->deferGUIRequests(
+        std::max(thread.guiQueueSize, 1), [this] { queueGUIRequestProcessing(); }
+    );
+    int scheduler = thread.priority > 0 ? ORO_SCHED_RT : ORO_SCHED_OTHER;
+    int priority = thread.priority > 0 ? thread.priority : RTT::os::LowestPriority;
+    unsigned int cpuAffinity = thread.cpuAffinity ? thread.cpuAffinity : ~0u;
+    return new RTT::Activity(
+        scheduler, priority, thread.period, cpuAffinity,
+        task->engine(), "seabots_pi"
+    );
+}
+
+void Plugin::setupNMEAIngest(RTT::TaskContext* task)
+{
+    auto const& configuration = mNMEAIngestConfiguration;
+    if (!configuration.enabled) {
+        return;
+    }
+
+    mNMEASolutionPort =
+        new RTT::OutputPort<gps_base::Solution>("nmea_gps_solution");
+    task->ports()->addPort(*mNMEASolutionPort).doc(
+        "GPS solutions parsed from the RMC and GGA sentences received by OpenCPN"
+    );
+    mNMEAAISPositionPort =
+        new RTT::OutputPort<ais_base::Position>("nmea_ais_positions");
+    task->ports()->addPort(*mNMEAAISPositionPort).doc(
+        "AIS position reports received by OpenCPN"
+    );
+    mNMEAAISVesselPort =
+        new RTT::OutputPort<ais_base::VesselInformation>("nmea_ais_vessels");
+    task->ports()->addPort(*mNMEAAISVesselPort).doc(
+        "AIS static and voyage data received by OpenCPN"
+    );
+    mNMEAIngestDropCountPort =
+        new RTT::OutputPort<uint64_t>("nmea_ingest_drop_count");
+    task->ports()->addPort(*mNMEAIngestDropCountPort).doc(
+        "number of sentences received from OpenCPN and dropped because "
+        "the ingest queue was full"
+    );
+    mNMEAIngestRejectedCountPort =
+        new RTT::OutputPort<uint64_t>("nmea_ingest_rejected_count");
+    task->ports()->addPort(*mNMEAIngestRejectedCountPort).doc(
+        "number of sentences received from OpenCPN with an invalid checksum "
+        "or content"
+    );
+
+    // The outputs are called from the ingest thread, writing on RTT ports
+    // is thread-safe
+    NMEAIngest::Outputs outputs;
+    outputs.solution = [this](gps_base::Solution const& solution) {
+        mNMEASolutionPort->write(solution);
+    };
+    outputs.position = [this](ais_base::Position const& position) {
+        mNMEAAISPositionPort->write(position);
+    };
+    outputs.vessel = [this](ais_base::VesselInformation const& vessel) {
+        mNMEAAISVesselPort->write(vessel);
+    };
+    mNMEAIngest.reset(new NMEAIngest(
+        std::max(configuration.queueSize, 1), outputs
+    ));
+    // Own targets are ignored for as long as the target table keeps them
+    mNMEAIngest->setIgnoredAISTargetTimeout(mAISTargets.target_timeout);
+    mInterface->setNMEAIngest(mNMEAIngest.get());
+    mNMEAIngest->start();
+}
+
+void Plugin::pushReceivedSentence(wxString const& sentence)
+{
+    if (!mNMEAIngest) {
+        return;
+    }
+
+    // Sentences are ASCII. Longer ones than a nmea::Sentence are truncated
+    // to one more character, so that the ingest rejects them
+    char buffer[nmea::Sentence::CAPACITY + 1];
+    size_t length = std::min<size_t>(sentence.length(), sizeof(buffer));
+    auto it = sentence.begin();
+    for (size_t i = 0; i < length; ++i, ++it) {
+        buffer[i] = static_cast<char>(*it);
+    }
+    mNMEAIngest->push(base::Time::now(), buffer, length);
+}
+
+void Plugin::SetNMEASentence(wxString& sentence)
+{
+    // OpenCPN passes the AIS sentences here as well as to SetAISSentence
+    if (sentence.StartsWith("!")) {
+        return;
+    }
+    pushReceivedSentence(sentence);
+}
+
+void Plugin::SetAISSentence(wxString& sentence)
+{
+    pushReceivedSentence(sentence);
 }
 
 void Plugin::setupToolbar()
@@ -149,39 +464,154 @@ void Plugin::setupToolbar()
         _("Execute Route"), _T( "" ), NULL, TOOL_EXECUTE_ROOT_POSITION, 0, this);
 }
 
-void Plugin::glAllocateTrajectoryArrays(int neededSize) {
-    int currentSize = mPlannedTrajectoryVBOs.size();
-    if (currentSize >= neededSize)
+void Plugin::glAllocateTrajectoryBuffer(TrajectoryCanvasCache& cache) {
+    if (cache.VAO)
         return;
 
-    mPlannedTrajectoryVAOs.resize(neededSize, 0);
-    mPlannedTrajectoryVBOs.resize(neededSize, 0);
-    glGenVertexArrays(neededSize - currentSize, &mPlannedTrajectoryVAOs[currentSize]);
-    glGenBuffers(neededSize - currentSize, &mPlannedTrajectoryVBOs[currentSize]);
+    glGenVertexArrays(1, &cache.VAO);
+    glGenBuffers(1, &cache.VBO);
+    glBindVertexArray(cache.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, cache.VBO);
+    glVertexAttribPointer(mTrajectoryPointPositionAttribute, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(mTrajectoryPointPositionAttribute);
+}
+
+void Plugin::glUpdateTrajectoryCanvasCache(
+    TrajectoryCanvasCache& cache,
+    OCPNInterfaceImpl::SampledPlanningResult const& result)
+{
+    if (cache.planningResultRevision == result.revision) {
+        return;
+    }
+
+    auto const& vertices = result.geometry.vertices;
+    glAllocateTrajectoryBuffer(cache);
+    glNamedBufferData(cache.VBO,
+        sizeof(vertices[0]) * vertices.size(),
+        vertices.data(), GL_STATIC_DRAW);
+    GL_CHECK_ERRORS();
+
+    cache.planningResultRevision = result.revision;
+}
+
+/** Extract the projection parameters from an OpenCPN viewport
+ *
+ * Only the mercator projection (OpenCPN's default) is supported. As in
+ * OpenCPN's own projection, the chart skew is added to the rotation, which
+ * matches the default settings (no skew compensation)
+ */
+static mercator::Viewport toMercatorViewport(PlugIn_ViewPort const& vp)
+{
+    mercator::Viewport viewport;
+    viewport.center_latitude_deg = vp.clat;
+    viewport.center_longitude_deg = vp.clon;
+    viewport.scale = vp.view_scale_ppm;
+    viewport.rotation_rad = vp.rotation + vp.skew;
+    viewport.width = vp.pix_width;
+    viewport.height = vp.pix_height;
+    return viewport;
+}
+
+void Plugin::glSetProjection(
+    GLProjectionUniforms const& uniforms,
+    mercator::Origin const& origin, PlugIn_ViewPort* vp)
+{
+    auto viewport = toMercatorViewport(*vp);
+    // Computed in double precision on the CPU, so that the shader only
+    // manipulates values relative to the viewport
+    Eigen::Vector2d offset = mercator::getOriginOffset(origin, viewport);
+
+    float viewTransform[16] = {
+        2.0f / vp->pix_width, 0, 0, -1,
+        0, -2.0f / vp->pix_height, 0, 1,
+        0, 0, 1, 0,
+        0, 0, 0, 1
+    };
+    glUniformMatrix4fv(uniforms.viewTransform, 1, true, viewTransform);
+    glUniform2f(uniforms.originOffset, offset.x(), offset.y());
+    glUniform1f(uniforms.scale, viewport.scale);
+    glUniform2f(uniforms.rotation,
+        cos(viewport.rotation_rad), sin(viewport.rotation_rad));
+    glUniform2f(uniforms.viewportSize, viewport.width, viewport.height);
+}
 
-    for (int i = currentSize; i < neededSize; ++i) {
-        glBindVertexArray(mPlannedTrajectoryVAOs[i]);
-        glBindBuffer(GL_ARRAY_BUFFER, mPlannedTrajectoryVBOs[i]);
-        glVertexAttribPointer(mTrajectoryPointPositionAttribute, 2, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(mTrajectoryPointPositionAttribute);
+/** Shape of the contact glyphs, as two triangles
+ *
+ * It is an arrow pointing north with a notch at its back, in a unit square
+ * centered on the contact. It is scaled to the contact's length in
+ * contacts.vert
+ */
+static const float CONTACT_GLYPH[] = {
+    0, 0.5f, -0.3f, -0.5f, 0, -0.25f,
+    0, 0.5f, 0, -0.25f, 0.3f, -0.5f
+};
+
+void Plugin::glAllocateContactBuffers(ContactCanvasCache& cache) {
+    if (cache.VAO)
+        return;
+
+    glGenVertexArrays(1, &cache.VAO);
+    glGenBuffers(1, &cache.glyphVBO);
+    glGenBuffers(1, &cache.instanceVBO);
+    glBindVertexArray(cache.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, cache.glyphVBO);
+    glBufferData(GL_ARRAY_BUFFER,
+        sizeof(CONTACT_GLYPH), CONTACT_GLYPH, GL_STATIC_DRAW);
+    glVertexAttribPointer(mContactVertexAttribute, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(mContactVertexAttribute);
+
+    GLint instanceAttributes[] = {
+        mContactPositionAttribute, mContactHeadingAttribute,
+        mContactLengthAttribute, mContactClassAttribute
+    };
+    for (GLint attribute : instanceAttributes) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
     }
 }
 
-void Plugin::glUploadSampledTrajectory(
-    int index, OCPNInterfaceImpl::SampledTrajectory const& trajectory, PlugIn_ViewPort* vp)
+void Plugin::glUpdateContactCanvasCache(
+    ContactCanvasCache& cache, ContactBuffer::Snapshot const& snapshot)
 {
-    std::vector<float> coords;
-    coords.reserve(trajectory.points.size() * 2);
-    for (auto ll : trajectory.points) {
-        wxPoint pp;
-        GetCanvasPixLL(vp, &pp, ll.latitude_deg, ll.longitude_deg);
-        coords.push_back(pp.x);
-        coords.push_back(pp.y);
+    if (cache.revision == snapshot.revision) {
+        return;
     }
 
-    glNamedBufferData(mPlannedTrajectoryVBOs[index],
-        sizeof(coords[0]) * coords.size(),
-        coords.data(), GL_STATIC_DRAW);
+    glAllocateContactBuffers(cache);
+
+    // The arrays are stored one after the other. Their offsets depend on
+    // the number of contacts, so the attribute pointers are set at each
+    // upload
+    size_t count = snapshot.size();
+    size_t positionsSize = sizeof(float) * 2 * count;
+    size_t arraySize = sizeof(float) * count;
+    size_t headingsOffset = positionsSize;
+    size_t lengthsOffset = headingsOffset + arraySize;
+    size_t classesOffset = lengthsOffset + arraySize;
+    glNamedBufferData(cache.instanceVBO,
+        classesOffset + arraySize, nullptr, GL_STREAM_DRAW);
+    glNamedBufferSubData(cache.instanceVBO, 0,
+        positionsSize, snapshot.positions.data());
+    glNamedBufferSubData(cache.instanceVBO, headingsOffset,
+        arraySize, snapshot.headings.data());
+    glNamedBufferSubData(cache.instanceVBO, lengthsOffset,
+        arraySize, snapshot.lengths.data());
+    glNamedBufferSubData(cache.instanceVBO, classesOffset,
+        arraySize, snapshot.classes.data());
+
+    glBindVertexArray(cache.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, cache.instanceVBO);
+    glVertexAttribPointer(mContactPositionAttribute, 2, GL_FLOAT, GL_FALSE, 0,
+        reinterpret_cast<void*>(0));
+    glVertexAttribPointer(mContactHeadingAttribute, 1, GL_FLOAT, GL_FALSE, 0,
+        reinterpret_cast<void*>(headingsOffset));
+    glVertexAttribPointer(mContactLengthAttribute, 1, GL_FLOAT, GL_FALSE, 0,
+        reinterpret_cast<void*>(lengthsOffset));
+    glVertexAttribPointer(mContactClassAttribute, 1, GL_FLOAT, GL_FALSE, 0,
+        reinterpret_cast<void*>(classesOffset));
+    GL_CHECK_ERRORS();
+
+    cache.revision = snapshot.revision;
 }
 
 struct GLStatePush
@@ -207,33 +637,47 @@ bool Plugin::RenderGLOverlayMultiCanvas(wxGLContext *pcontext, PlugIn_ViewPort *
     glLoadPrograms();
 
     GLStatePush state;
-    float viewTransform[16] = {
-        2.0f / vp->pix_width, 0, 0, -1,
-        0, -2.0f / vp->pix_height, 0, 1,
-        0, 0, 1, 0,
-        0, 0, 0, 1
-    };
 
-    auto const& current = mInterface->getCurrentPlanningResult();
-    auto const& trajectories = current.sampled;
-    if (!trajectories.empty()) {
-        glAllocateTrajectoryArrays(trajectories.size());
-        for (unsigned int i = 0; i < trajectories.size(); ++i)
-        {
-            glUploadSampledTrajectory(i, trajectories[i], vp);
-            GL_CHECK_ERRORS();
-        }
+    auto current = mInterface->getCurrentPlanningResult();
+    auto const& geometry = current->geometry;
+    if (geometry.getStripCount() != 0) {
+        auto& cache = mTrajectoryCanvasCaches[canvasIndex];
+        glUpdateTrajectoryCanvasCache(cache, *current);
 
         glUseProgram(mTrajectoryGLProgramID);
-        glUniformMatrix4fv(mTrajectoryViewTransformUniform, 1, true, viewTransform);
-
-        for (unsigned int i = 0; i < trajectories.size(); ++i) {
-            glBindVertexArray(mPlannedTrajectoryVAOs[i]);
-            glDrawArrays(GL_LINE_STRIP, 0, trajectories[i].points.size());
+        glSetProjection(mTrajectoryProjectionUniforms, current->origin, vp);
+
+        auto const& level = geometry.selectLevel(vp->view_scale_ppm);
+        Eigen::AlignedBox2f view = current->origin.toLocal(
+            vp->lat_min, vp->lat_max, vp->lon_min, vp->lon_max
+        ).cast<float>();
+        level.cull(view, mVisibleTrajectoryFirsts, mVisibleTrajectoryCounts);
+
+        if (!mVisibleTrajectoryFirsts.empty()) {
+            glBindVertexArray(cache.VAO);
+            glMultiDrawArrays(GL_LINE_STRIP,
+                mVisibleTrajectoryFirsts.data(), mVisibleTrajectoryCounts.data(),
+                mVisibleTrajectoryFirsts.size());
             GL_CHECK_ERRORS();
         }
     }
 
+    // Contacts are drawn over the trajectories. They are all drawn, the
+    // vertex shader being cheap enough that culling them on the CPU would
+    // cost more than it saves
+    mInterface->getContacts().updateSnapshot(mContactSnapshot);
+    if (mContactSnapshot.size() != 0) {
+        auto& cache = mContactCanvasCaches[canvasIndex];
+        glUpdateContactCanvasCache(cache, mContactSnapshot);
+
+        glUseProgram(mContactsGLProgramID);
+        glSetProjection(mContactsProjectionUniforms, mContactSnapshot.origin, vp);
+        glUniform1f(mContactsMinSizeUniform, mContactMinSize);
+        glBindVertexArray(cache.VAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, mContactSnapshot.size());
+        GL_CHECK_ERRORS();
+    }
+
     return true;
 }
 
@@ -252,14 +696,41 @@ wxString Plugin::readDataFile(wxString const& name)
     return contents;
 }
 
+void Plugin::glGetProjectionUniforms(
+    GLuint program, GLProjectionUniforms& uniforms)
+{
+    uniforms.viewTransform = glGetUniformLocation(program, "viewTransform");
+    uniforms.originOffset = glGetUniformLocation(program, "originOffset");
+    uniforms.scale = glGetUniformLocation(program, "scale");
+    uniforms.rotation = glGetUniformLocation(program, "rotation");
+    uniforms.viewportSize = glGetUniformLocation(program, "viewportSize");
+}
+
 void Plugin::glLoadPrograms()
 {
     if (!mTrajectoryGLProgramID) {
         mTrajectoryGLProgramID = glLoadProgram("trajectory");
         mTrajectoryPointPositionAttribute =
             glGetAttribLocation(mTrajectoryGLProgramID, "position");
-        mTrajectoryViewTransformUniform =
-            glGetUniformLocation(mTrajectoryGLProgramID, "viewTransform");
+        glGetProjectionUniforms(
+            mTrajectoryGLProgramID, mTrajectoryProjectionUniforms);
+    }
+    if (!mContactsGLProgramID) {
+        mContactsGLProgramID = glLoadProgram("contacts");
+        mContactVertexAttribute =
+            glGetAttribLocation(mContactsGLProgramID, "vertex");
+        mContactPositionAttribute =
+            glGetAttribLocation(mContactsGLProgramID, "position");
+        mContactHeadingAttribute =
+            glGetAttribLocation(mContactsGLProgramID, "heading");
+        mContactLengthAttribute =
+            glGetAttribLocation(mContactsGLProgramID, "contactLength");
+        mContactClassAttribute =
+            glGetAttribLocation(mContactsGLProgramID, "targetClass");
+        glGetProjectionUniforms(
+            mContactsGLProgramID, mContactsProjectionUniforms);
+        mContactsMinSizeUniform =
+            glGetUniformLocation(mContactsGLProgramID, "minSize");
     }
 }
 
@@ -361,11 +832,141 @@ void Plugin::setupTaskActivity(
     tasks.push_back(task);
 }
 
+void Plugin::queueTaskExecution()
+{
+    if (mTaskExecutionQueued.exchange(true)) {
+        return;
+    }
+
+    mTaskTriggerTime = base::Time::now().toMicroseconds();
+    mTaskEventHandler.QueueEvent(new wxThreadEvent(
+        wxEVT_THREAD, orogenTaskEventHandler::EXECUTE_TASKS
+    ));
+}
+
+void Plugin::queueGUIRequestProcessing()
+{
+    if (mGUIRequestProcessingQueued.exchange(true)) {
+        return;
+    }
+
+    mTaskEventHandler.QueueEvent(new wxThreadEvent(
+        wxEVT_THREAD, orogenTaskEventHandler::PROCESS_GUI_REQUESTS
+    ));
+}
+
 void Plugin::executeTasks()
 {
+    // Reset the flag before executing, so that data arriving during the
+    // execution queues a new one
+    if (mTaskExecutionQueued.exchange(false)) {
+        mTaskExecutionLatency = base::Time::now() -
+            base::Time::fromMicroseconds(mTaskTriggerTime);
+        mTaskExecutionLatencyPort->write(mTaskExecutionLatency);
+    }
+
     for (auto& task : tasks) {
         task->getActivity()->execute();
     }
+    processGUIRequests();
+    // Pruned here rather than on updates, so that contacts disappear even
+    // if no more AIS data arrives
+    if (mInterface->pruneContacts(base::Time::now())) {
+        RequestRefresh(GetOCPNCanvasWindow());
+    }
+    writePosePublicationStatistics();
+    writeAISStatistics();
+    writeNMEAIngestStatistics();
+}
+
+void Plugin::writeAISStatistics()
+{
+    auto const& targets = mInterface->getAISTargetTable();
+    uint64_t positionSuppressed = targets.getPositionSuppressedCount();
+    if (positionSuppressed != mAISPositionSuppressedCount) {
+        mAISPositionSuppressedCount = positionSuppressed;
+        mAISPositionSuppressedCountPort->write(positionSuppressed);
+    }
+    uint64_t positionDecimated = targets.getPositionDecimatedCount();
+    if (positionDecimated != mAISPositionDecimatedCount) {
+        mAISPositionDecimatedCount = positionDecimated;
+        mAISPositionDecimatedCountPort->write(positionDecimated);
+    }
+    uint64_t positionOverBudget = targets.getPositionOverBudgetCount();
+    if (positionOverBudget != mAISPositionOverBudgetCount) {
+        mAISPositionOverBudgetCount = positionOverBudget;
+        mAISPositionOverBudgetCountPort->write(positionOverBudget);
+    }
+    uint64_t staticSuppressed = targets.getStaticSuppressedCount();
+    if (staticSuppressed != mAISStaticSuppressedCount) {
+        mAISStaticSuppressedCount = staticSuppressed;
+        mAISStaticSuppressedCountPort->write(staticSuppressed);
+    }
+}
+
+void Plugin::writeNMEAIngestStatistics()
+{
+    if (!mNMEAIngest) {
+        return;
+    }
+
+    uint64_t dropCount = mNMEAIngest->getDropCount();
+    if (dropCount != mNMEAIngestDropCount) {
+        mNMEAIngestDropCount = dropCount;
+        mNMEAIngestDropCountPort->write(dropCount);
+    }
+    uint64_t rejectedCount = mNMEAIngest->getRejectedCount();
+    if (rejectedCount != mNMEAIngestRejectedCount) {
+        mNMEAIngestRejectedCount = rejectedCount;
+        mNMEAIngestRejectedCountPort->write(rejectedCount);
+    }
+}
+
+void Plugin::writePosePublicationStatistics()
+{
+    uint64_t rateSuppressed = mInterface->getPoseRateSuppressedCount();
+    if (rateSuppressed != mPoseRateSuppressedCount) {
+        mPoseRateSuppressedCount = rateSuppressed;
+        mPoseRateSuppressedCountPort->write(rateSuppressed);
+    }
+    uint64_t deadbandSuppressed = mInterface->getPoseDeadbandSuppressedCount();
+    if (deadbandSuppressed != mPoseDeadbandSuppressedCount) {
+        mPoseDeadbandSuppressedCount = deadbandSuppressed;
+        mPoseDeadbandSuppressedCountPort->write(deadbandSuppressed);
+    }
+}
+
+void Plugin::processGUIRequests()
+{
+    // Reset the flag before processing, so that requests arriving during
+    // the processing queue a new one
+    mGUIRequestProcessingQueued = false;
+    if (mInterface->processGUIRequests()) {
+        // Sentences left over because of the budget are sent by a
+        // processing queued right away, without executing the tasks again
+        queueGUIRequestProcessing();
+    }
+
+    uint64_t highWaterMark = mInterface->getGUIQueueHighWaterMark();
+    if (highWaterMark != mGUIQueueHighWaterMark) {
+        mGUIQueueHighWaterMark = highWaterMark;
+        mGUIQueueHighWaterMarkPort->write(highWaterMark);
+    }
+    uint64_t dropCount = mInterface->getGUIQueueDropCount();
+    if (dropCount != mGUIQueueDropCount) {
+        mGUIQueueDropCount = dropCount;
+        mGUIQueueDropCountPort->write(dropCount);
+    }
+    uint64_t coalescedCount = mInterface->getNMEACoalescedCount();
+    if (coalescedCount != mNMEACoalescedCount) {
+        mNMEACoalescedCount = coalescedCount;
+        mNMEACoalescedCountPort->write(coalescedCount);
+    }
+}
+
+base::Time Plugin::getTaskExecutionLatency() const
+{
+    return mTaskExecutionLatency;
 }
 
 int Plugin::GetToolbarToolCount(void)
@@ -411,6 +1012,14 @@ bool Plugin::executeCurrentTrajectories()
 
 bool Plugin::DeInit() {
     mTimer.Stop();
+    mTaskEventHandler.Unbind(
+        wxEVT_THREAD, &orogenTaskEventHandler::onExecuteTasks, &mTaskEventHandler,
+        orogenTaskEventHandler::EXECUTE_TASKS
+    );
+    mTaskEventHandler.Unbind(
+        wxEVT_THREAD, &orogenTaskEventHandler::onProcessGUIRequests,
+        &mTaskEventHandler, orogenTaskEventHandler::PROCESS_GUI_REQUESTS
+    );
 
     // Deregister the CORBA stuff
     RTT::corba::TaskContextServer::CleanupServers();
@@ -424,6 +1033,10 @@ bool Plugin::DeInit() {
     }
     activities.clear();
 
+    // Stop the ingest thread before deleting the ports it writes to
+    mInterface->setNMEAIngest(nullptr);
+    mNMEAIngest.reset();
+
     // Delete pointers to tasks
     for(Tasks::iterator task_it = tasks.begin();
             task_it != tasks.end(); ++task_it)
@@ -431,6 +1044,36 @@ bool Plugin::DeInit() {
         delete *task_it;
     }
     tasks.clear();
+    delete mTaskExecutionLatencyPort;
+    mTaskExecutionLatencyPort = nullptr;
+    delete mGUIQueueHighWaterMarkPort;
+    mGUIQueueHighWaterMarkPort = nullptr;
+    delete mGUIQueueDropCountPort;
+    mGUIQueueDropCountPort = nullptr;
+    delete mNMEACoalescedCountPort;
+    mNMEACoalescedCountPort = nullptr;
+    delete mPoseRateSuppressedCountPort;
+    mPoseRateSuppressedCountPort = nullptr;
+    delete mPoseDeadbandSuppressedCountPort;
+    mPoseDeadbandSuppressedCountPort = nullptr;
+    delete mAISPositionSuppressedCountPort;
+    mAISPositionSuppressedCountPort = nullptr;
+    delete mAISPositionDecimatedCountPort;
+    mAISPositionDecimatedCountPort = nullptr;
+    delete mAISPositionOverBudgetCountPort;
+    mAISPositionOverBudgetCountPort = nullptr;
+    delete mAISStaticSuppressedCountPort;
+    mAISStaticSuppressedCountPort = nullptr;
+    delete mNMEASolutionPort;
+    mNMEASolutionPort = nullptr;
+    delete mNMEAAISPositionPort;
+    mNMEAAISPositionPort = nullptr;
+    delete mNMEAAISVesselPort;
+    mNMEAAISVesselPort = nullptr;
+    delete mNMEAIngestDropCountPort;
+    mNMEAIngestDropCountPort = nullptr;
+    delete mNMEAIngestRejectedCountPort;
+    mNMEAIngestRejectedCountPort = nullptr;
 
     RTT::corba::TaskContextServer::ShutdownOrb();
     RTT::corba::TaskContextServer::DestroyOrb();
@@ -3,12 +3,19 @@
 
 #include <wx/wx.h>
 #include "OCPNInterfaceImpl.hpp"
+#include "NMEAIngest.hpp"
 #include "ocpn_plugin.h"
 
 #include <GL/gl.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <base/Time.hpp>
 
 namespace RTT {
     class TaskContext;
+    class ExecutionEngine;
+    template<typename T> class OutputPort;
     namespace base {
         class ActivityInterface;
     }
@@ -19,6 +26,8 @@ namespace seabots_pi {
 
     class Plugin : public opencpn_plugin_116 {
         friend class orogenTaskTimer;
+        friend class orogenTaskEventHandler;
+        friend class orogenTaskActivity;
 
         struct orogenTaskTimer : public wxTimer
         {
@@ -27,13 +36,39 @@ namespace seabots_pi {
             void Notify();
         };
 
+        /** Receives the task execution requests queued by orogenTaskActivity
+         * and executes the tasks on the GUI thread
+         *
+         * It also receives the requests to only process the deferred GUI
+         * requests, which do not execute the tasks
+         */
+        struct orogenTaskEventHandler : public wxEvtHandler
+        {
+            /** IDs of the events */
+            enum
+            {
+                EXECUTE_TASKS = 1,
+                PROCESS_GUI_REQUESTS
+            };
+
+            Plugin& plugin;
+            orogenTaskEventHandler(Plugin& plugin);
+            void onExecuteTasks(wxThreadEvent& event);
+            void onProcessGUIRequests(wxThreadEvent& event);
+        };
+
+        /** Activity that queues an execution of the tasks on the GUI thread
+         * when triggered, e.g. by new data on an event port
+         *
+         * It is defined in Plugin.cpp to avoid including RTT headers here
+         */
+        struct orogenTaskActivity;
+
         static const int REQUIRED_API_VERSION_MAJOR = 1;
         static const int REQUIRED_API_VERSION_MINOR = 16;
         static const int PLUGIN_VERSION_MAJOR = 0;
         static const int PLUGIN_VERSION_MINOR = 1;
 
-        static const int UPDATE_PERIOD_MS = 100;
-
         static const char* NAME;
         static const char* DESCRIPTION_SHORT;
         static const char* DESCRIPTION_LONG;
@@ -54,8 +89,200 @@ namespace seabots_pi {
         OCPNInterfaceImpl* mInterface;
 
         orogenTaskTimer mTimer;
+        orogenTaskEventHandler mTaskEventHandler;
         void executeTasks();
 
+        /** Whether an execution has been queued on mTaskEventHandler and not
+         * yet processed
+         */
+        std::atomic<bool> mTaskExecutionQueued { false };
+        /** Time of the trigger that queued the pending execution, in
+         * microseconds
+         */
+        std::atomic<int64_t> mTaskTriggerTime { 0 };
+        /** Time between the trigger of the last execution and the execution */
+        base::Time mTaskExecutionLatency;
+        /** Port on which the main task's execution latency is published */
+        RTT::OutputPort<base::Time>* mTaskExecutionLatencyPort = nullptr;
+
+        /** Configuration of the main task's thread
+         *
+         * By default, the main task is executed in the GUI thread. When
+         * enabled, it gets its own thread and all its calls to wx and
+         * OpenCPN are deferred to the GUI thread through a bounded queue.
+         *
+         * It is read from the PlugIns/seabots_pi section of OpenCPN's
+         * configuration file
+         */
+        struct TaskThreadConfiguration
+        {
+            bool enabled = false;
+            /** Real-time priority of the thread, zero for a normal thread */
+            int priority = 0;
+            /** CPU affinity mask, zero for no affinity */
+            unsigned int cpuAffinity = 0;
+            /** Period of the activity in seconds, zero to execute only when
+             * triggered
+             */
+            double period = 0.1;
+            /** Size of the queue of calls deferred to the GUI thread */
+            int guiQueueSize = 1024;
+        };
+        TaskThreadConfiguration mTaskThreadConfiguration;
+        /** Maximum period between two executions of the tasks, in seconds
+         *
+         * Tasks are executed when triggered (e.g. by data on event ports),
+         * this is a fallback for the ports that are not event ports. Set to
+         * zero to disable it.
+         *
+         * It is read from the MaxUpdatePeriod setting
+         */
+        double mMaxUpdatePeriod = 0.1;
+        /** Sentences sent to OpenCPN for each system pose, as a set of
+         * nmea::PoseSentences flags
+         *
+         * It is read from the PoseSentences setting, a comma-separated list
+         * of sentence names (e.g. RMC,HDT,VTG)
+         */
+        int mPoseSentences = nmea::POSE_ALL;
+        /** Maximum number of NMEA sentences sent to OpenCPN per task
+         * execution, zero for no limit
+         *
+         * It is read from the NMEABudget setting
+         */
+        int mNMEABudget = 0;
+        /** Rate limit and dead-band of the system poses sent to OpenCPN
+         *
+         * It is read from the PoseMinPeriod and PoseHeartbeatPeriod (in
+         * seconds), PosePositionDeadband (meters), PoseAngleDeadband
+         * (degrees) and PoseSpeedDeadband (m/s) settings
+         */
+        PosePublicationPolicy::Configuration mPosePublication;
+        /** Change detection and static data cadence of the AIS targets sent
+         * to OpenCPN
+         *
+         * It is read from the AISStaticPeriod and AISPositionRepeatPeriod
+         * settings, in seconds
+         */
+        AISTargetTable::Configuration mAISTargets;
+        /** Range- and risk-based rates of the AIS targets sent to OpenCPN
+         *
+         * It is read from the AISNearRange, AISFarRange and
+         * AISCPAThreshold (meters), AISTCPAThreshold (seconds) and
+         * AISSentencesPerSecond settings
+         */
+        AISScheduler::Configuration mAISScheduler;
+        /** AIS target classes sent to OpenCPN as NMEA, and drawn by the
+         * plugin's contact overlay, as sets of (1 << AISEncoder::TargetClass)
+         * flags
+         *
+         * They are read from the AISNMEAClasses and ContactOverlayClasses
+         * settings, comma-separated lists of class names (A, B, AtoN). The
+         * overlay is disabled by default
+         */
+        int mAISNMEAClasses = AISEncoder::ALL_TARGET_CLASSES;
+        int mContactOverlayClasses = 0;
+        /** Timeout of the contact overlay
+         *
+         * It is read from the ContactTimeout setting, in seconds
+         */
+        ContactBuffer::Configuration mContactBuffer;
+        /** Minimum size of the contact glyphs in pixels
+         *
+         * It is read from the ContactMinSize setting
+         */
+        double mContactMinSize = 12;
+        /** Configuration of the forwarding of OpenCPN's NMEA and AIS
+         * sentences to Rock
+         *
+         * It is read from the NMEAIngest and NMEAIngestQueueSize settings.
+         * It is disabled by default, OpenCPN then does not pass the
+         * sentences to the plugin at all
+         */
+        struct NMEAIngestConfiguration
+        {
+            bool enabled = false;
+            /** Number of received sentences that may wait to be parsed */
+            int queueSize = 1024;
+        };
+        NMEAIngestConfiguration mNMEAIngestConfiguration;
+        void loadConfiguration();
+        RTT::base::ActivityInterface* createMainTaskActivity(RTT::TaskContext* task);
+
+        /** Ports on which the statistics of the deferred GUI calls queue
+         * are published
+         */
+        RTT::OutputPort<uint64_t>* mGUIQueueHighWaterMarkPort = nullptr;
+        RTT::OutputPort<uint64_t>* mGUIQueueDropCountPort = nullptr;
+        uint64_t mGUIQueueHighWaterMark = 0;
+        uint64_t mGUIQueueDropCount = 0;
+        /** Port on which the number of superseded NMEA sentences is
+         * published
+         */
+        RTT::OutputPort<uint64_t>* mNMEACoalescedCountPort = nullptr;
+        uint64_t mNMEACoalescedCount = 0;
+        void processGUIRequests();
+        /** Whether a processing of the GUI requests has been queued on
+         * mTaskEventHandler and not yet done
+         */
+        std::atomic<bool> mGUIRequestProcessingQueued { false };
+
+        /** Ports on which the number of system poses not sent to OpenCPN are
+         * published
+         */
+        RTT::OutputPort<uint64_t>* mPoseRateSuppressedCountPort = nullptr;
+        RTT::OutputPort<uint64_t>* mPoseDeadbandSuppressedCountPort = nullptr;
+        uint64_t mPoseRateSuppressedCount = 0;
+        uint64_t mPoseDeadbandSuppressedCount = 0;
+        void writePosePublicationStatistics();
+
+        /** Ports on which the number of AIS messages not sent to OpenCPN
+         * because they did not change, were decimated or were over budget
+         * are published
+         */
+        RTT::OutputPort<uint64_t>* mAISPositionSuppressedCountPort = nullptr;
+        RTT::OutputPort<uint64_t>* mAISPositionDecimatedCountPort = nullptr;
+        RTT::OutputPort<uint64_t>* mAISPositionOverBudgetCountPort = nullptr;
+        RTT::OutputPort<uint64_t>* mAISStaticSuppressedCountPort = nullptr;
+        uint64_t mAISPositionSuppressedCount = 0;
+        uint64_t mAISPositionDecimatedCount = 0;
+        uint64_t mAISPositionOverBudgetCount = 0;
+        uint64_t mAISStaticSuppressedCount = 0;
+        void writeAISStatistics();
+
+        /** Parses the sentences received from OpenCPN, null if disabled */
+        std::unique_ptr<NMEAIngest> mNMEAIngest;
+        /** Ports on which the samples parsed from OpenCPN's sentences are
+         * published
+         */
+        RTT::OutputPort<gps_base::Solution>* mNMEASolutionPort = nullptr;
+        RTT::OutputPort<ais_base::Position>* mNMEAAISPositionPort = nullptr;
+        RTT::OutputPort<ais_base::VesselInformation>* mNMEAAISVesselPort = nullptr;
+        /** Ports on which the statistics of the ingest path are published */
+        RTT::OutputPort<uint64_t>* mNMEAIngestDropCountPort = nullptr;
+        RTT::OutputPort<uint64_t>* mNMEAIngestRejectedCountPort = nullptr;
+        uint64_t mNMEAIngestDropCount = 0;
+        uint64_t mNMEAIngestRejectedCount = 0;
+        void setupNMEAIngest(RTT::TaskContext* task);
+        void writeNMEAIngestStatistics();
+        void pushReceivedSentence(wxString const& sentence);
+
+        /** Queue an execution of the tasks on the GUI thread
+         *
+         * It is thread-safe. Calls made while an execution is already queued
+         * are coalesced into it
+         */
+        void queueTaskExecution();
+
+        /** Queue a processing of the deferred GUI requests and of the
+         * pending NMEA sentences on the GUI thread, without executing the
+         * tasks
+         *
+         * It is thread-safe. Calls made while a processing is already
+         * queued are coalesced into it
+         */
+        void queueGUIRequestProcessing();
+
         void loadSVGs();
         wxString readDataFile(wxString const& name);
         void setupToolbar();
@@ -72,23 +299,93 @@ namespace seabots_pi {
         int GetToolbarToolCount(void);
         void OnToolbarToolCallback(int id);
 
+        /** Uniforms of the mercator projection shared by the programs */
+        struct GLProjectionUniforms
+        {
+            GLint viewTransform = 0;
+            GLint originOffset = 0;
+            GLint scale = 0;
+            GLint rotation = 0;
+            GLint viewportSize = 0;
+        };
+
         GLuint mTrajectoryGLProgramID = 0;
         GLint mTrajectoryPointPositionAttribute = 0;
-        GLint mTrajectoryViewTransformUniform = 0;
+        GLProjectionUniforms mTrajectoryProjectionUniforms;
+
+        GLuint mContactsGLProgramID = 0;
+        GLint mContactVertexAttribute = 0;
+        GLint mContactPositionAttribute = 0;
+        GLint mContactHeadingAttribute = 0;
+        GLint mContactLengthAttribute = 0;
+        GLint mContactClassAttribute = 0;
+        GLProjectionUniforms mContactsProjectionUniforms;
+        GLint mContactsMinSizeUniform = 0;
+
+        /** Per-canvas GPU copy of the current planning result
+         *
+         * The uploaded points are mercator coordinates relative to the
+         * planning result's origin, the projection on the canvas being done
+         * in trajectory.vert. The cache is therefore valid as long as the
+         * planning result does not change
+         *
+         * All trajectories are stored in a single buffer, in the layout
+         * of the planning result's TrajectoryGeometry
+         */
+        struct TrajectoryCanvasCache
+        {
+            uint64_t planningResultRevision = 0;
+            uint VAO = 0;
+            uint VBO = 0;
+        };
+        /** Trajectory caches, indexed by canvas index */
+        std::map<int, TrajectoryCanvasCache> mTrajectoryCanvasCaches;
+        /** The chunks of the trajectory geometry visible in the canvas being
+         * rendered
+         *
+         * They are members only to avoid reallocating them for each frame
+         */
+        std::vector<int> mVisibleTrajectoryFirsts;
+        std::vector<int> mVisibleTrajectoryCounts;
 
-        uint mPlannedTrajectoryID = 0;
-        uint mPlannedTrajectoryCount = 0;
-        std::vector<uint> mPlannedTrajectoryVAOs;
-        std::vector<uint> mPlannedTrajectoryVBOs;
+        /** Per-canvas GPU copy of the contact overlay
+         *
+         * The glyph buffer holds the shape shared by all contacts. The
+         * instance buffer holds the arrays of the contact snapshot one after
+         * the other, which are per-instance attributes of contacts.vert, so
+         * that all contacts are drawn by a single instanced call
+         */
+        struct ContactCanvasCache
+        {
+            uint64_t revision = 0;
+            uint VAO = 0;
+            uint glyphVBO = 0;
+            uint instanceVBO = 0;
+        };
+        /** Contact caches, indexed by canvas index */
+        std::map<int, ContactCanvasCache> mContactCanvasCaches;
+        /** Last copy of the contacts, shared by all canvases */
+        ContactBuffer::Snapshot mContactSnapshot;
 
         void glCheckErrors(const char *file, int line, bool throwOnError);
         void glLoadPrograms();
         GLuint glLoadProgram(wxString name);
         GLuint glLoadShader(wxString name, GLenum shaderType);
-        void glAllocateTrajectoryArrays(int neededSize);
-        void glUploadSampledTrajectory(
-            int i, OCPNInterfaceImpl::SampledTrajectory const&,
-            PlugIn_ViewPort* vp
+        void glAllocateTrajectoryBuffer(TrajectoryCanvasCache& cache);
+        void glUpdateTrajectoryCanvasCache(
+            TrajectoryCanvasCache& cache,
+            OCPNInterfaceImpl::SampledPlanningResult const& result
+        );
+        void glAllocateContactBuffers(ContactCanvasCache& cache);
+        void glUpdateContactCanvasCache(
+            ContactCanvasCache& cache, ContactBuffer::Snapshot const& snapshot
+        );
+        static void glGetProjectionUniforms(
+            GLuint program, GLProjectionUniforms& uniforms
+        );
+        void glSetProjection(
+            GLProjectionUniforms const& uniforms,
+            mercator::Origin const& origin, PlugIn_ViewPort* vp
         );
 
     public:
@@ -105,6 +402,16 @@ namespace seabots_pi {
 
         virtual bool RenderGLOverlayMultiCanvas(wxGLContext *pcontext, PlugIn_ViewPort *vp, int index);
 
+        /** Receives the NMEA sentences of OpenCPN's inputs */
+        virtual void SetNMEASentence(wxString& sentence);
+        /** Receives the AIS sentences of OpenCPN's inputs */
+        virtual void SetAISSentence(wxString& sentence);
+
+        /** Time between the trigger of the last execution of the tasks and
+         * the execution itself
+         */
+        base::Time getTaskExecutionLatency() const;
+
         bool planCurrentRoute();
         bool executeCurrentTrajectories();
 
@@ -0,0 +1,115 @@
+#include "PosePublicationPolicy.hpp"
+#include <cmath>
+
+using namespace std;
+using namespace seabots_pi;
+
+/** Absolute difference between two angles, in [0, pi] */
+static double angleDifference(double a, double b)
+{
+    return fabs(remainder(a - b, 2 * M_PI));
+}
+
+/** Speed and course over ground of a pose */
+static pair<double, double> getSpeedAndCourse(
+    base::samples::RigidBodyState const& rbs
+)
+{
+    if (!rbs.hasValidVelocity()) {
+        return make_pair(0.0, 0.0);
+    }
+    double speed = rbs.velocity.head<2>().norm();
+    return make_pair(speed, atan2(rbs.velocity.y(), rbs.velocity.x()));
+}
+
+PosePublicationPolicy::PosePublicationPolicy()
+{
+}
+
+PosePublicationPolicy::PosePublicationPolicy(Configuration const& configuration)
+    : mConfiguration(configuration)
+{
+}
+
+void PosePublicationPolicy::setConfiguration(Configuration const& configuration)
+{
+    mConfiguration = configuration;
+}
+
+PosePublicationPolicy::Configuration PosePublicationPolicy::getConfiguration() const
+{
+    return mConfiguration;
+}
+
+void PosePublicationPolicy::reset()
+{
+    mHasLast = false;
+}
+
+bool PosePublicationPolicy::update(base::samples::RigidBodyState const& rbs)
+{
+    if (mHasLast && rbs.time >= mLastTime) {
+        base::Time elapsed = rbs.time - mLastTime;
+        if (elapsed < mConfiguration.min_period) {
+            ++mRateSuppressedCount;
+            return false;
+        }
+        else if (elapsed < mConfiguration.heartbeat_period &&
+                 !isOutOfDeadband(rbs)) {
+            ++mDeadbandSuppressedCount;
+            return false;
+        }
+    }
+
+    auto speedAndCourse = getSpeedAndCourse(rbs);
+    mHasLast = true;
+    mLastTime = rbs.time;
+    mLastPosition = rbs.position;
+    mLastHeading = base::getYaw(rbs.orientation);
+    mLastSpeed = speedAndCourse.first;
+    mLastCourse = speedAndCourse.second;
+    ++mPublishedCount;
+    return true;
+}
+
+bool PosePublicationPolicy::isOutOfDeadband(
+    base::samples::RigidBodyState const& rbs
+) const
+{
+    auto const& config = mConfiguration;
+    if ((rbs.position - mLastPosition).head<2>().norm() > config.position_deadband) {
+        return true;
+    }
+    if (angleDifference(base::getYaw(rbs.orientation), mLastHeading) >
+        config.angle_deadband) {
+        return true;
+    }
+
+    auto speedAndCourse = getSpeedAndCourse(rbs);
+    double speed = speedAndCourse.first;
+    if (fabs(speed - mLastSpeed) > config.speed_deadband) {
+        return true;
+    }
+    bool hasCourse = speed > config.min_course_speed;
+    bool hadCourse = mLastSpeed > config.min_course_speed;
+    if (hasCourse != hadCourse) {
+        return true;
+    }
+    return hasCourse &&
+        angleDifference(speedAndCourse.second, mLastCourse) > config.angle_deadband;
+}
+
+uint64_t PosePublicationPolicy::getPublishedCount() const
+{
+    return mPublishedCount.load();
+}
+
+uint64_t PosePublicationPolicy::getRateSuppressedCount() const
+{
+    return mRateSuppressedCount.load();
+}
+
+uint64_t PosePublicationPolicy::getDeadbandSuppressedCount() const
+{
+    return mDeadbandSuppressedCount.load();
+}
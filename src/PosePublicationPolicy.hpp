@@ -0,0 +1,92 @@
+#ifndef SEABOTS_PI_POSEPUBLICATIONPOLICY_HPP
+#define SEABOTS_PI_POSEPUBLICATIONPOLICY_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <base/Time.hpp>
+#include <base/samples/RigidBodyState.hpp>
+
+namespace seabots_pi {
+    /** Decides which system poses are worth sending to OpenCPN
+     *
+     * Each pose sent to OpenCPN is parsed by its NMEA multiplexer on the GUI
+     * thread, which is wasteful at the rate of a pose estimator. A pose is
+     * sent only if:
+     * - at least the minimum period elapsed since the last sent pose, and
+     * - it moved out of the dead-band of the last sent pose, or the
+     *   heartbeat period elapsed
+     *
+     * Times are the poses' own timestamps. A pose older than the last sent
+     * one resets the policy.
+     *
+     * update() must be called from a single thread, the counters may be read
+     * from any thread
+     */
+    class PosePublicationPolicy
+    {
+    public:
+        struct Configuration
+        {
+            /** Minimum time between two published poses */
+            base::Time min_period = base::Time::fromMilliseconds(200);
+            /** Maximum time between two published poses, even if nothing
+             * changed
+             */
+            base::Time heartbeat_period = base::Time::fromSeconds(2);
+            /** Minimum position change in meters */
+            double position_deadband = 1;
+            /** Minimum heading or course change in radians */
+            double angle_deadband = 0.5 * M_PI / 180;
+            /** Minimum speed change in m/s */
+            double speed_deadband = 0.05;
+            /** Speed under which the course is not considered, as it is then
+             * replaced by the heading
+             */
+            double min_course_speed = 0.1;
+        };
+
+        PosePublicationPolicy();
+        explicit PosePublicationPolicy(Configuration const& configuration);
+
+        void setConfiguration(Configuration const& configuration);
+        Configuration getConfiguration() const;
+
+        /** Whether this pose should be published
+         *
+         * A pose for which it returns true becomes the reference for the
+         * next decisions
+         */
+        bool update(base::samples::RigidBodyState const& rbs);
+
+        /** Forget the last published pose, so that the next one is published
+         */
+        void reset();
+
+        /** Number of poses that were published */
+        uint64_t getPublishedCount() const;
+        /** Number of poses suppressed because they arrived within the minimum
+         * period
+         */
+        uint64_t getRateSuppressedCount() const;
+        /** Number of poses suppressed because they were in the dead-band */
+        uint64_t getDeadbandSuppressedCount() const;
+
+    private:
+        bool isOutOfDeadband(base::samples::RigidBodyState const& rbs) const;
+
+        Configuration mConfiguration;
+
+        bool mHasLast = false;
+        base::Time mLastTime;
+        Eigen::Vector3d mLastPosition;
+        double mLastHeading = 0;
+        double mLastCourse = 0;
+        double mLastSpeed = 0;
+
+        std::atomic<uint64_t> mPublishedCount { 0 };
+        std::atomic<uint64_t> mRateSuppressedCount { 0 };
+        std::atomic<uint64_t> mDeadbandSuppressedCount { 0 };
+    };
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef SEABOTS_PI_SPSCQUEUE_HPP
+#define SEABOTS_PI_SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace seabots_pi {
+    /** Bounded lock-free queue with a single producer and a single consumer
+     *
+     * Elements pushed while the queue is full are dropped, and counted. The
+     * queue also tracks the maximum number of elements it contained
+     * (high-water mark), to help sizing it.
+     *
+     * push() must only be called from the producer thread and pop() from the
+     * consumer thread. The statistics can be read from any thread.
+     */
+    template<typename T>
+    class SPSCQueue
+    {
+    public:
+        explicit SPSCQueue(size_t capacity)
+            : mBuffer(capacity) {}
+
+        /** Push an element, called from the producer thread
+         *
+         * @return false if the queue was full and the element was dropped
+         */
+        bool push(T value)
+        {
+            size_t tail = mTail.load(std::memory_order_relaxed);
+            size_t head = mHead.load(std::memory_order_acquire);
+            if (tail - head == mBuffer.size()) {
+                mDropCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            mBuffer[tail % mBuffer.size()] = std::move(value);
+            mTail.store(tail + 1, std::memory_order_release);
+
+            size_t size = tail + 1 - head;
+            if (size > mHighWaterMark.load(std::memory_order_relaxed)) {
+                mHighWaterMark.store(size, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        /** Pop the oldest element, called from the consumer thread
+         *
+         * @return false if the queue was empty
+         */
+        bool pop(T& value)
+        {
+            size_t head = mHead.load(std::memory_order_relaxed);
+            size_t tail = mTail.load(std::memory_order_acquire);
+            if (head == tail) {
+                return false;
+            }
+
+            value = std::move(mBuffer[head % mBuffer.size()]);
+            mHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Maximum number of elements in the queue */
+        size_t getCapacity() const { return mBuffer.size(); }
+
+        /** Maximum number of elements the queue contained so far */
+        size_t getHighWaterMark() const { return mHighWaterMark.load(); }
+
+        /** Number of elements dropped because the queue was full */
+        uint64_t getDropCount() const { return mDropCount.load(); }
+
+    private:
+        std::vector<T> mBuffer;
+        /** Number of elements popped so far. Written by the consumer */
+        std::atomic<size_t> mHead { 0 };
+        /** Number of elements pushed so far. Written by the producer */
+        std::atomic<size_t> mTail { 0 };
+        std::atomic<size_t> mHighWaterMark { 0 };
+        std::atomic<uint64_t> mDropCount { 0 };
+    };
+}
+
+#endif
@@ -0,0 +1,207 @@
+#include "TrajectoryGeometry.hpp"
+#include <cmath>
+#include <tuple>
+
+using namespace std;
+using namespace seabots_pi;
+
+const int TrajectoryGeometry::CHUNK_SIZE = 256;
+const double TrajectoryGeometry::LOD_MIN_TOLERANCE = 1;
+const double TrajectoryGeometry::LOD_TOLERANCE_FACTOR = 4;
+const size_t TrajectoryGeometry::LOD_MAX_LEVELS = 12;
+
+size_t TrajectoryGeometry::Level::getStripCount() const
+{
+    return counts.size();
+}
+
+size_t TrajectoryGeometry::Level::getVertexCount() const
+{
+    size_t total = 0;
+    for (auto const& range : trajectories) {
+        total += range.count;
+    }
+    return total;
+}
+
+void TrajectoryGeometry::Level::cull(
+    Eigen::AlignedBox2f const& view,
+    vector<int>& firsts, vector<int>& counts
+) const
+{
+    firsts.clear();
+    counts.clear();
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        if (bounds[i].intersects(view)) {
+            firsts.push_back(this->firsts[i]);
+            counts.push_back(this->counts[i]);
+        }
+    }
+}
+
+TrajectoryGeometry::TrajectoryGeometry()
+    : levels(1)
+{
+}
+
+size_t TrajectoryGeometry::getVertexCount() const
+{
+    return vertices.size() / 2;
+}
+
+size_t TrajectoryGeometry::getStripCount() const
+{
+    return levels.front().getStripCount();
+}
+
+void TrajectoryGeometry::addRange(Level& level, size_t first, size_t count) const
+{
+    // A strip with a single point draws nothing
+    if (count < 2) {
+        return;
+    }
+
+    Range range;
+    range.first = first;
+    range.count = count;
+    level.trajectories.push_back(range);
+
+    int end = first + count;
+    for (int chunk_first = first; chunk_first < end - 1;
+         chunk_first += CHUNK_SIZE - 1) {
+        int chunk_count = min(CHUNK_SIZE, end - chunk_first);
+
+        Eigen::AlignedBox2f box;
+        for (int i = chunk_first; i < chunk_first + chunk_count; ++i) {
+            box.extend(Eigen::Vector2f(vertices[i * 2], vertices[i * 2 + 1]));
+        }
+        level.firsts.push_back(chunk_first);
+        level.counts.push_back(chunk_count);
+        level.bounds.push_back(box);
+    }
+}
+
+/** Squared distance between the point i and the segment [a, b] */
+static double squaredSegmentDistance(float const* xy, int i, int a, int b)
+{
+    double px = xy[i * 2], py = xy[i * 2 + 1];
+    double ax = xy[a * 2], ay = xy[a * 2 + 1];
+    double dx = xy[b * 2] - ax, dy = xy[b * 2 + 1] - ay;
+
+    double length2 = dx * dx + dy * dy;
+    double t = 0;
+    if (length2 > 0) {
+        t = ((px - ax) * dx + (py - ay) * dy) / length2;
+        t = min(1.0, max(0.0, t));
+    }
+    double ex = ax + t * dx - px;
+    double ey = ay + t * dy - py;
+    return ex * ex + ey * ey;
+}
+
+/** Douglas-Peucker simplification of a strip
+ *
+ * Sets keep[i - first] for each kept vertex
+ */
+static void simplifyStrip(
+    float const* xy, int first, int count, double tolerance,
+    vector<bool>& keep
+)
+{
+    keep.assign(count, false);
+    keep[0] = true;
+    keep[count - 1] = true;
+
+    double tolerance2 = tolerance * tolerance;
+    vector<pair<int, int>> stack;
+    stack.emplace_back(first, first + count - 1);
+    while (!stack.empty()) {
+        int a, b;
+        tie(a, b) = stack.back();
+        stack.pop_back();
+
+        double max_distance2 = 0;
+        int max_i = -1;
+        for (int i = a + 1; i < b; ++i) {
+            double d2 = squaredSegmentDistance(xy, i, a, b);
+            if (d2 > max_distance2) {
+                max_distance2 = d2;
+                max_i = i;
+            }
+        }
+
+        if (max_distance2 > tolerance2) {
+            keep[max_i - first] = true;
+            stack.emplace_back(a, max_i);
+            stack.emplace_back(max_i, b);
+        }
+    }
+}
+
+void TrajectoryGeometry::buildLevelsOfDetail(
+    double min_tolerance, double factor, size_t max_levels
+)
+{
+    levels.resize(1);
+
+    vector<bool> keep;
+    vector<float> simplified;
+    vector<Range> ranges;
+    double tolerance = min_tolerance;
+    for (size_t n = 1; n < max_levels; ++n, tolerance *= factor) {
+        Level const& previous = levels.back();
+        size_t previous_count = previous.getVertexCount();
+        if (previous_count == previous.trajectories.size() * 2) {
+            break;
+        }
+
+        simplified.clear();
+        ranges.clear();
+        size_t first = getVertexCount();
+        for (auto const& trajectory : previous.trajectories) {
+            simplifyStrip(vertices.data(), trajectory.first, trajectory.count,
+                tolerance, keep);
+
+            Range range;
+            range.first = first;
+            for (int i = 0; i < trajectory.count; ++i) {
+                if (keep[i]) {
+                    int vertex = trajectory.first + i;
+                    simplified.push_back(vertices[vertex * 2]);
+                    simplified.push_back(vertices[vertex * 2 + 1]);
+                    ++range.count;
+                }
+            }
+            ranges.push_back(range);
+            first += range.count;
+        }
+
+        if (simplified.size() / 2 == previous_count) {
+            // Nothing removed at this tolerance, no need for a new level
+            continue;
+        }
+
+        vertices.insert(vertices.end(), simplified.begin(), simplified.end());
+        Level level;
+        level.tolerance = tolerance;
+        for (auto const& range : ranges) {
+            addRange(level, range.first, range.count);
+        }
+        levels.push_back(move(level));
+    }
+}
+
+TrajectoryGeometry::Level const& TrajectoryGeometry::selectLevel(
+    double scale, double pixel_tolerance
+) const
+{
+    double tolerance = pixel_tolerance / scale;
+    size_t selected = 0;
+    for (size_t i = 1; i < levels.size(); ++i) {
+        if (levels[i].tolerance > tolerance) {
+            break;
+        }
+        selected = i;
+    }
+    return levels[selected];
+}
@@ -0,0 +1,132 @@
+#ifndef SEABOTS_PI_TRAJECTORYGEOMETRY_HPP
+#define SEABOTS_PI_TRAJECTORYGEOMETRY_HPP
+
+#include <vector>
+#include <cstddef>
+#include <Eigen/Geometry>
+
+namespace seabots_pi {
+    /** All trajectories of a planning result packed in a single vertex array
+     *
+     * This is the layout expected by glMultiDrawArrays: one vertex buffer and
+     * a table of first vertex index and vertex count per line strip
+     *
+     * Each trajectory is split into line strips of at most CHUNK_SIZE
+     * vertices (chunks), whose bounding boxes are used to draw only the
+     * chunks visible in a given view.
+     *
+     * The geometry also holds simplified versions of the trajectories (levels
+     * of detail), whose vertices are stored in the same array. Level 0 is
+     * the full resolution geometry.
+     */
+    struct TrajectoryGeometry
+    {
+        /** Range of vertices of a trajectory within the vertex array */
+        struct Range
+        {
+            int first = 0;
+            int count = 0;
+        };
+
+        struct Level
+        {
+            /** Maximum distance, in the units of the vertices, between the
+             * strips of this level and the full resolution strips
+             */
+            double tolerance = 0;
+            /** Vertices of each trajectory */
+            std::vector<Range> trajectories;
+            /** Index of the first vertex of each chunk */
+            std::vector<int> firsts;
+            /** Number of vertices of each chunk */
+            std::vector<int> counts;
+            /** Bounding box of each chunk */
+            std::vector<Eigen::AlignedBox2f> bounds;
+
+            /** Number of chunks */
+            size_t getStripCount() const;
+
+            /** Total number of vertices of the trajectories in this level */
+            size_t getVertexCount() const;
+
+            /** Get the chunks that intersect a bounding box
+             *
+             * The output vectors are cleared first, and filled in the layout
+             * expected by glMultiDrawArrays
+             */
+            void cull(
+                Eigen::AlignedBox2f const& view,
+                std::vector<int>& firsts, std::vector<int>& counts
+            ) const;
+        };
+
+        /** Maximum number of vertices in a chunk
+         *
+         * Consecutive chunks of a trajectory share one vertex
+         */
+        static const int CHUNK_SIZE;
+
+        /** Smallest tolerance of the simplified levels, in meters */
+        static const double LOD_MIN_TOLERANCE;
+        /** Ratio between the tolerances of two consecutive levels */
+        static const double LOD_TOLERANCE_FACTOR;
+        /** Maximum number of levels, including the full resolution level */
+        static const size_t LOD_MAX_LEVELS;
+
+        /** Interleaved x and y coordinates of all vertices */
+        std::vector<float> vertices;
+        /** The levels of details, from the most to the least detailed */
+        std::vector<Level> levels;
+
+        TrajectoryGeometry();
+
+        /** Add a trajectory to the full resolution level
+         *
+         * Points are any type with x and y fields. All trajectories must be
+         * added before calling buildLevelsOfDetail
+         */
+        template<typename Point>
+        void addTrajectory(std::vector<Point> const& points)
+        {
+            size_t first = getVertexCount();
+            vertices.reserve(vertices.size() + points.size() * 2);
+            for (auto const& p : points) {
+                vertices.push_back(p.x);
+                vertices.push_back(p.y);
+            }
+            addRange(levels.front(), first, points.size());
+        }
+
+        /** Build the simplified levels from the full resolution level
+         *
+         * Each level is a Douglas-Peucker simplification of the previous one,
+         * with a tolerance \c factor times bigger. Tolerances that would not
+         * remove any vertex do not generate a level. Since each
+         * level is simplified from the previous one, the actual error is
+         * bounded by \c factor / (\c factor - 1) times the level's tolerance.
+         */
+        void buildLevelsOfDetail(
+            double min_tolerance = LOD_MIN_TOLERANCE,
+            double factor = LOD_TOLERANCE_FACTOR,
+            size_t max_levels = LOD_MAX_LEVELS
+        );
+
+        /** The least detailed level whose error is below the given tolerance
+         *
+         * @param scale the scale of the view, in pixels per vertex unit
+         * @param pixel_tolerance the acceptable error, in pixels
+         */
+        Level const& selectLevel(double scale, double pixel_tolerance = 0.5) const;
+
+        /** Number of vertices in the array */
+        size_t getVertexCount() const;
+
+        /** Number of chunks in the full resolution level */
+        size_t getStripCount() const;
+
+    private:
+        void addRange(Level& level, size_t first, size_t count) const;
+    };
+}
+
+#endif
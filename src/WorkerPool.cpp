@@ -0,0 +1,60 @@
+#include "WorkerPool.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+WorkerPool::WorkerPool(size_t size)
+{
+    if (size == 0) {
+        size_t cores = thread::hardware_concurrency();
+        size = cores > 1 ? cores - 1 : 1;
+    }
+
+    for (size_t i = 0; i < size; ++i) {
+        mThreads.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        lock_guard<mutex> lock(mMutex);
+        mStopping = true;
+        mJobs.clear();
+    }
+    mCondition.notify_all();
+    for (auto& t : mThreads) {
+        t.join();
+    }
+}
+
+size_t WorkerPool::getSize() const
+{
+    return mThreads.size();
+}
+
+void WorkerPool::push(Job job)
+{
+    {
+        lock_guard<mutex> lock(mMutex);
+        mJobs.push_back(move(job));
+    }
+    mCondition.notify_one();
+}
+
+void WorkerPool::run()
+{
+    while (true) {
+        Job job;
+        {
+            unique_lock<mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+            if (mStopping) {
+                return;
+            }
+            job = move(mJobs.front());
+            mJobs.pop_front();
+        }
+        job();
+    }
+}
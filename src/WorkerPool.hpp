@@ -0,0 +1,53 @@
+#ifndef SEABOTS_PI_WORKERPOOL_HPP
+#define SEABOTS_PI_WORKERPOOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace seabots_pi {
+    /** A fixed set of threads executing jobs in FIFO order
+     *
+     * It is used to do expensive computations outside of the GUI thread.
+     * Jobs are responsible for publishing their own results.
+     */
+    class WorkerPool
+    {
+    public:
+        typedef std::function<void()> Job;
+
+        /** Create the pool
+         *
+         * @param size the number of threads. Zero means one thread less than
+         *   the number of cores, with a minimum of one
+         */
+        explicit WorkerPool(size_t size = 0);
+
+        /** Stops the pool
+         *
+         * Jobs that are being executed are finished, queued jobs are
+         * discarded
+         */
+        ~WorkerPool();
+
+        /** Number of worker threads */
+        size_t getSize() const;
+
+        /** Queue a job for execution. It never blocks */
+        void push(Job job);
+
+    private:
+        void run();
+
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::deque<Job> mJobs;
+        bool mStopping = false;
+        std::vector<std::thread> mThreads;
+    };
+}
+
+#endif
@@ -0,0 +1,15 @@
+#version 130
+
+flat in int glyphClass;
+out vec4 outColor;
+
+// Indexed by AISEncoder::TargetClass
+const vec4 CLASS_COLORS[3] = vec4[3](
+    vec4(0.0, 0.6, 0.0, 1),
+    vec4(0.8, 0.6, 0.0, 1),
+    vec4(0.6, 0.0, 0.6, 1)
+);
+
+void main() {
+    outColor = CLASS_COLORS[clamp(glyphClass, 0, 2)];
+}
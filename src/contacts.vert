@@ -0,0 +1,46 @@
+#version 130
+
+// Corner of the contact glyph, in a unit square pointing north
+in vec2 vertex;
+
+// Per-contact attributes
+// Mercator coordinates in meters, relative to the contact buffer's origin
+in vec2 position;
+// Radians, counter-clockwise from north
+in float heading;
+// Length in mercator meters, zero if unknown
+in float contactLength;
+// AISEncoder::TargetClass
+in float targetClass;
+
+uniform mat4 viewTransform;
+
+// Offset from the viewport center to the origin, in meters
+uniform vec2 originOffset;
+// Pixels per meter
+uniform float scale;
+// Cosine and sine of the view rotation
+uniform vec2 rotation;
+uniform vec2 viewportSize;
+// Minimum size of the glyphs, in pixels
+uniform float minSize;
+
+flat out int glyphClass;
+
+void main() {
+    float size = max(contactLength * scale, minSize);
+    vec2 shape = vertex * size;
+    vec2 glyph = vec2(
+        shape.x * cos(heading) - shape.y * sin(heading),
+        shape.x * sin(heading) + shape.y * cos(heading)
+    );
+
+    vec2 p = (position + originOffset) * scale + glyph;
+    vec2 rotated = vec2(
+        p.x * rotation.x + p.y * rotation.y,
+        p.y * rotation.x - p.x * rotation.y
+    );
+    vec2 pixel = vec2(viewportSize.x / 2 + rotated.x, viewportSize.y / 2 - rotated.y);
+    gl_Position = viewTransform * vec4(pixel, 1, 1);
+    glyphClass = int(targetClass);
+}
@@ -1,8 +1,23 @@
 #version 130
 
+// Mercator coordinates in meters, relative to the planning result's origin
 in vec2 position;
 uniform mat4 viewTransform;
 
+// Offset from the viewport center to the origin, in meters
+uniform vec2 originOffset;
+// Pixels per meter
+uniform float scale;
+// Cosine and sine of the view rotation
+uniform vec2 rotation;
+uniform vec2 viewportSize;
+
 void main() {
-    gl_Position = viewTransform * vec4(position, 1, 1);
+    vec2 p = (position + originOffset) * scale;
+    vec2 rotated = vec2(
+        p.x * rotation.x + p.y * rotation.y,
+        p.y * rotation.x - p.x * rotation.y
+    );
+    vec2 pixel = vec2(viewportSize.x / 2 + rotated.x, viewportSize.y / 2 - rotated.y);
+    gl_Position = viewTransform * vec4(pixel, 1, 1);
 }
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "../src/AISDecoder.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+struct AISDecoderTest : public ::testing::Test {
+    AISDecoder decoder;
+
+    bool push(string const& sentence) {
+        nmea::VDMFragment fragment;
+        if (!nmea::parseVDM(sentence.data(), sentence.size(), fragment)) {
+            throw std::invalid_argument("invalid VDM sentence: " + sentence);
+        }
+        return decoder.push(fragment);
+    }
+};
+
+TEST_F(AISDecoderTest, it_decodes_a_position_report) {
+    ASSERT_TRUE(push("!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C"));
+    ASSERT_EQ(1, decoder.getMessageType());
+    ASSERT_EQ(477553000u, decoder.getMMSI());
+    ASSERT_EQ(168u, decoder.getBitCount());
+
+    ais_base::Position position;
+    ASSERT_TRUE(decoder.decode(position));
+    ASSERT_EQ(477553000, position.mmsi);
+    ASSERT_EQ(5, position.status);
+    ASSERT_DOUBLE_EQ(0, position.speed_over_ground);
+    ASSERT_NEAR(-73407500 / 600000.0, position.longitude.getDeg(), 1e-9);
+    ASSERT_NEAR(47.582833, position.latitude.getDeg(), 1e-5);
+    ASSERT_NEAR(-51, position.course_over_ground.getDeg(), 1e-6);
+    ASSERT_NEAR(179, position.yaw.getDeg(), 1e-6);
+}
+
+TEST_F(AISDecoderTest, it_does_not_decode_a_position_report_as_static_data) {
+    ASSERT_TRUE(push("!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C"));
+    ais_base::VesselInformation vessel;
+    ASSERT_FALSE(decoder.decode(vessel));
+}
+
+TEST_F(AISDecoderTest, it_reassembles_and_decodes_static_data) {
+    ASSERT_FALSE(push("!AIVDM,2,1,1,A,55?MbV02;H;s<HtKR20EHE:0@T4@Dn2222222216L961O5Gf0NSQEp6ClRp8,0*1C"));
+    ASSERT_TRUE(push("!AIVDM,2,2,1,A,88888888880,2*25"));
+    ASSERT_EQ(5, decoder.getMessageType());
+    ASSERT_EQ(424u, decoder.getBitCount());
+
+    ais_base::VesselInformation vessel;
+    ASSERT_TRUE(decoder.decode(vessel));
+    ASSERT_EQ(351759000, vessel.mmsi);
+    ASSERT_EQ(9134270, vessel.imo);
+    ASSERT_EQ("3FOF8", vessel.call_sign);
+    ASSERT_EQ("EVER DIADEM", vessel.name);
+    ASSERT_EQ(70, vessel.ship_type);
+    ASSERT_DOUBLE_EQ(295, vessel.length);
+    ASSERT_DOUBLE_EQ(32, vessel.width);
+    ASSERT_DOUBLE_EQ(12.2, vessel.draft);
+}
+
+TEST_F(AISDecoderTest, it_aborts_a_message_whose_fragments_are_out_of_order) {
+    ASSERT_FALSE(push("!AIVDM,2,2,1,A,88888888880,2*25"));
+    ASSERT_FALSE(push("!AIVDM,2,1,1,A,55?MbV02;H;s<HtKR20EHE:0@T4@Dn2222222216L961O5Gf0NSQEp6ClRp8,0*1C"));
+    ASSERT_TRUE(push("!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C"));
+    ASSERT_EQ(1, decoder.getMessageType());
+}
+
+TEST_F(AISDecoderTest, it_reads_signed_fields) {
+    ASSERT_TRUE(push("!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C"));
+    // Longitude field, in 1/10000 minutes
+    ASSERT_EQ(-73407500, decoder.getInt(61, 28));
+}
@@ -0,0 +1,418 @@
+#include <gtest/gtest.h>
+#include "../src/AISEncoder.hpp"
+#include "../src/AISDecoder.hpp"
+
+#include <random>
+
+using namespace std;
+using namespace seabots_pi;
+
+struct AISEncoderTest : public ::testing::Test {
+    AISEncoder encoder;
+    AISDecoder decoder;
+    std::mt19937 rng { 42 };
+
+    /** Parse and decode the sentences of the encoder */
+    void decode() {
+        string sentences = encoder.str();
+        size_t start = 0;
+        bool complete = false;
+        while (start < sentences.size()) {
+            size_t end = sentences.find('\n', start);
+            if (end == string::npos) {
+                end = sentences.size();
+            }
+            string sentence = sentences.substr(start, end - start);
+            ASSERT_TRUE(nmea::validateChecksum(sentence.data(), sentence.size()))
+                << sentence;
+            nmea::VDMFragment fragment;
+            ASSERT_TRUE(nmea::parseVDM(sentence.data(), sentence.size(), fragment))
+                << sentence;
+            complete = decoder.push(fragment);
+            start = end + 1;
+        }
+        ASSERT_TRUE(complete);
+    }
+
+    void push(string const& sentence) {
+        nmea::VDMFragment fragment;
+        nmea::parseVDM(sentence.data(), sentence.size(), fragment);
+        decoder.push(fragment);
+    }
+
+    double uniform(double min, double max) {
+        return std::uniform_real_distribution<double>(min, max)(rng);
+    }
+
+    ais_base::Position makePosition() {
+        ais_base::Position position;
+        position.mmsi = 227006760;
+        position.status = static_cast<decltype(position.status)>(0);
+        position.yaw_velocity = 0;
+        position.speed_over_ground = 3;
+        position.high_accuracy_position = true;
+        position.course_over_ground = base::Angle::fromDeg(-45);
+        position.yaw = base::Angle::fromDeg(-40);
+        position.latitude = base::Angle::fromDeg(48.38);
+        position.longitude = base::Angle::fromDeg(-4.49);
+        return position;
+    }
+
+    ais_base::VesselInformation makeVessel() {
+        ais_base::VesselInformation vessel;
+        vessel.mmsi = 227006760;
+        vessel.imo = 9134270;
+        vessel.call_sign = "SB01";
+        vessel.name = "SEABOT ONE";
+        vessel.ship_type = static_cast<decltype(vessel.ship_type)>(37);
+        vessel.length = 12;
+        vessel.width = 4;
+        vessel.draft = 1.5;
+        return vessel;
+    }
+};
+
+TEST_F(AISEncoderTest, it_frames_a_position_report_in_a_single_sentence) {
+    encoder.encode(makePosition());
+    ASSERT_EQ(1u, encoder.getFragmentCount());
+    ASSERT_EQ(28u, encoder.getPayloadSize());
+    ASSERT_EQ(0, encoder.getFillBits());
+
+    string sentence = encoder.str();
+    ASSERT_EQ("!AIVDM,1,1,,B,", sentence.substr(0, 14));
+    ASSERT_EQ(string(encoder.getPayload(), 28), sentence.substr(14, 28));
+    ASSERT_EQ(",0*", sentence.substr(42, 3));
+    ASSERT_EQ(47u, sentence.size());
+}
+
+TEST_F(AISEncoderTest, it_frames_static_data_in_two_sentences) {
+    encoder.encode(makeVessel());
+    ASSERT_EQ(2u, encoder.getFragmentCount());
+    ASSERT_EQ(71u, encoder.getPayloadSize());
+    ASSERT_EQ(2, encoder.getFillBits());
+
+    string sentences = encoder.str();
+    size_t newline = sentences.find('\n');
+    ASSERT_NE(string::npos, newline);
+    string first = sentences.substr(0, newline);
+    string second = sentences.substr(newline + 1);
+    ASSERT_EQ("!AIVDM,2,1,,B," + string(encoder.getPayload(), 60) + ",0",
+              first.substr(0, first.size() - 3));
+    ASSERT_EQ("!AIVDM,2,2,,B," + string(encoder.getPayload() + 60, 11) + ",2",
+              second.substr(0, second.size() - 3));
+}
+
+TEST_F(AISEncoderTest, it_encodes_the_fields_of_a_position_report) {
+    auto position = makePosition();
+    encoder.encode(position);
+    decode();
+
+    ASSERT_EQ(1, decoder.getMessageType());
+    ASSERT_EQ(168u, decoder.getBitCount());
+    ASSERT_EQ(0u, decoder.getUInt(6, 2));
+    ASSERT_EQ(227006760u, decoder.getMMSI());
+    ASSERT_EQ(0, decoder.getInt(42, 8));
+    ASSERT_EQ(58u, decoder.getUInt(50, 10));
+    ASSERT_EQ(1u, decoder.getUInt(60, 1));
+    ASSERT_EQ(-2694000, decoder.getInt(61, 28));
+    ASSERT_EQ(29028000, decoder.getInt(89, 27));
+    ASSERT_EQ(450u, decoder.getUInt(116, 12));
+    ASSERT_EQ(40u, decoder.getUInt(128, 9));
+    // Time stamp not available
+    ASSERT_EQ(60u, decoder.getUInt(137, 6));
+}
+
+TEST_F(AISEncoderTest, it_encodes_unknown_position_fields_as_not_available) {
+    ais_base::Position position;
+    position.mmsi = 227006760;
+    encoder.encode(position);
+    decode();
+
+    ASSERT_EQ(-128, decoder.getInt(42, 8));
+    ASSERT_EQ(1023u, decoder.getUInt(50, 10));
+    ASSERT_EQ(181 * 600000, decoder.getInt(61, 28));
+    ASSERT_EQ(91 * 600000, decoder.getInt(89, 27));
+    ASSERT_EQ(3600u, decoder.getUInt(116, 12));
+    ASSERT_EQ(511u, decoder.getUInt(128, 9));
+}
+
+TEST_F(AISEncoderTest, it_encodes_north_as_zero) {
+    auto position = makePosition();
+    position.course_over_ground = base::Angle::fromDeg(0);
+    position.yaw = base::Angle::fromDeg(0.2);
+    encoder.encode(position);
+    decode();
+    ASSERT_EQ(0u, decoder.getUInt(116, 12));
+    ASSERT_EQ(0u, decoder.getUInt(128, 9));
+}
+
+TEST_F(AISEncoderTest, it_encodes_the_rate_of_turn) {
+    auto position = makePosition();
+    // 4.733 * sqrt(36 deg/min) = 28.398
+    position.yaw_velocity = 36.0 / 60 * M_PI / 180;
+    encoder.encode(position);
+    decode();
+    ASSERT_EQ(28, decoder.getInt(42, 8));
+
+    position.yaw_velocity = -36.0 / 60 * M_PI / 180;
+    encoder.encode(position);
+    decode();
+    ASSERT_EQ(-28, decoder.getInt(42, 8));
+
+    // More than 708 deg/min
+    position.yaw_velocity = 800.0 / 60 * M_PI / 180;
+    encoder.encode(position);
+    decode();
+    ASSERT_EQ(127, decoder.getInt(42, 8));
+}
+
+TEST_F(AISEncoderTest, it_round_trips_random_position_reports) {
+    for (int i = 0; i < 1000; ++i) {
+        ais_base::Position position;
+        position.mmsi = std::uniform_int_distribution<int>(0, 999999999)(rng);
+        position.status = static_cast<decltype(position.status)>(
+            std::uniform_int_distribution<int>(0, 15)(rng)
+        );
+        position.speed_over_ground = uniform(0, 50);
+        position.high_accuracy_position = (i % 2) == 0;
+        position.course_over_ground = base::Angle::fromDeg(uniform(-180, 180));
+        position.yaw = base::Angle::fromDeg(uniform(-180, 180));
+        position.latitude = base::Angle::fromDeg(uniform(-90, 90));
+        position.longitude = base::Angle::fromDeg(uniform(-180, 180));
+        encoder.encode(position);
+        decode();
+
+        ais_base::Position decoded;
+        ASSERT_TRUE(decoder.decode(decoded));
+        ASSERT_EQ(position.mmsi, decoded.mmsi);
+        ASSERT_EQ(position.status, decoded.status);
+        ASSERT_NEAR(position.speed_over_ground, decoded.speed_over_ground,
+                    0.05 * 1852 / 3600 + 1e-9);
+        ASSERT_EQ(position.high_accuracy_position, decoded.high_accuracy_position);
+        ASSERT_TRUE(position.course_over_ground.isApprox(
+            decoded.course_over_ground, base::Angle::deg2Rad(0.05 + 1e-9)
+        ));
+        ASSERT_TRUE(position.yaw.isApprox(
+            decoded.yaw, base::Angle::deg2Rad(0.5 + 1e-9)
+        ));
+        ASSERT_NEAR(position.latitude.getDeg(), decoded.latitude.getDeg(),
+                    0.5 / 600000 + 1e-12);
+        ASSERT_NEAR(position.longitude.getDeg(), decoded.longitude.getDeg(),
+                    0.5 / 600000 + 1e-12);
+    }
+}
+
+TEST_F(AISEncoderTest, it_round_trips_static_data) {
+    encoder.encode(makeVessel());
+    decode();
+
+    ais_base::VesselInformation decoded;
+    ASSERT_TRUE(decoder.decode(decoded));
+    ASSERT_EQ(227006760, decoded.mmsi);
+    ASSERT_EQ(9134270, decoded.imo);
+    ASSERT_EQ("SB01", decoded.call_sign);
+    ASSERT_EQ("SEABOT ONE", decoded.name);
+    ASSERT_EQ(37, decoded.ship_type);
+    ASSERT_DOUBLE_EQ(12, decoded.length);
+    ASSERT_DOUBLE_EQ(4, decoded.width);
+    ASSERT_DOUBLE_EQ(1.5, decoded.draft);
+    // ETA not available, DTE not ready
+    ASSERT_EQ(0u, decoder.getUInt(274, 4));
+    ASSERT_EQ(0u, decoder.getUInt(278, 5));
+    ASSERT_EQ(24u, decoder.getUInt(283, 5));
+    ASSERT_EQ(60u, decoder.getUInt(288, 6));
+    ASSERT_EQ(1u, decoder.getUInt(422, 1));
+}
+
+TEST_F(AISEncoderTest, it_keeps_the_total_of_odd_dimensions) {
+    auto vessel = makeVessel();
+    vessel.length = 11;
+    vessel.width = 3;
+    encoder.encode(vessel);
+    decode();
+    ASSERT_EQ(5u, decoder.getUInt(240, 9));
+    ASSERT_EQ(6u, decoder.getUInt(249, 9));
+    ASSERT_EQ(1u, decoder.getUInt(258, 6));
+    ASSERT_EQ(2u, decoder.getUInt(264, 6));
+}
+
+TEST_F(AISEncoderTest, it_uppercases_text_and_truncates_it_to_the_field_size) {
+    auto vessel = makeVessel();
+    vessel.call_sign = "sb01abcdef";
+    vessel.name = "a name that is longer than twenty characters";
+    encoder.encode(vessel);
+    decode();
+
+    ais_base::VesselInformation decoded;
+    decoder.decode(decoded);
+    ASSERT_EQ("SB01ABC", decoded.call_sign);
+    ASSERT_EQ("A NAME THAT IS LONGE", decoded.name);
+}
+
+TEST_F(AISEncoderTest, it_reencodes_a_reference_position_report_bit_for_bit) {
+    // The position report of the decoder tests. The fields not
+    // available in Rock (time stamp and following) are not compared
+    push("!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C");
+    ASSERT_EQ(1, decoder.getMessageType());
+    ais_base::Position position;
+    decoder.decode(position);
+    vector<uint32_t> expected;
+    for (size_t i = 0; i < 137; ++i) {
+        expected.push_back(decoder.getUInt(i, 1));
+    }
+
+    encoder.encode(position);
+    decode();
+    for (size_t i = 0; i < 137; ++i) {
+        ASSERT_EQ(expected[i], decoder.getUInt(i, 1)) << "bit " << i;
+    }
+}
+
+TEST_F(AISEncoderTest, it_has_the_standard_message_sizes) {
+    ASSERT_EQ(168u, AISEncoder::getMessageBits(AISEncoder::MESSAGE_1));
+    ASSERT_EQ(424u, AISEncoder::getMessageBits(AISEncoder::MESSAGE_5));
+    ASSERT_EQ(168u, AISEncoder::getMessageBits(AISEncoder::MESSAGE_18));
+    ASSERT_EQ(312u, AISEncoder::getMessageBits(AISEncoder::MESSAGE_19));
+    ASSERT_EQ(272u, AISEncoder::getMessageBits(AISEncoder::MESSAGE_21));
+    ASSERT_EQ(168u, AISEncoder::getMessageBits(AISEncoder::MESSAGE_24A));
+    ASSERT_EQ(168u, AISEncoder::getMessageBits(AISEncoder::MESSAGE_24B));
+}
+
+TEST_F(AISEncoderTest, it_classifies_targets) {
+    auto position = makePosition();
+    ASSERT_EQ(AISEncoder::CLASS_A, AISEncoder::getTargetClass(position));
+
+    position.status = ais_base::STATUS_NOT_DEFINED;
+    ASSERT_EQ(AISEncoder::CLASS_A, AISEncoder::getTargetClass(position));
+    position.yaw_velocity = base::unknown<double>();
+    ASSERT_EQ(AISEncoder::CLASS_B, AISEncoder::getTargetClass(position));
+
+    position.mmsi = 992271234;
+    ASSERT_EQ(AISEncoder::AID_TO_NAVIGATION, AISEncoder::getTargetClass(position));
+    ASSERT_FALSE(AISEncoder::isVirtualAidToNavigation(992271234));
+    ASSERT_TRUE(AISEncoder::isVirtualAidToNavigation(992276234));
+    ASSERT_FALSE(AISEncoder::isAidToNavigation(227006760));
+}
+
+TEST_F(AISEncoderTest, it_parses_a_list_of_target_classes) {
+    ASSERT_EQ((1 << AISEncoder::CLASS_B) | (1 << AISEncoder::AID_TO_NAVIGATION),
+        AISEncoder::parseTargetClasses("B,AtoN"));
+    ASSERT_EQ(AISEncoder::ALL_TARGET_CLASSES, AISEncoder::parseTargetClasses("A,B,AtoN"));
+    ASSERT_EQ(0, AISEncoder::parseTargetClasses(""));
+    ASSERT_THROW(AISEncoder::parseTargetClasses("A,C"), std::invalid_argument);
+}
+
+TEST_F(AISEncoderTest, it_encodes_a_class_b_position_report) {
+    encoder.clear();
+    encoder.setPosition(makePosition());
+    encoder.encode(AISEncoder::MESSAGE_18);
+    decode();
+
+    ASSERT_EQ(18, decoder.getMessageType());
+    ASSERT_EQ(168u, decoder.getBitCount());
+    ASSERT_EQ(227006760u, decoder.getMMSI());
+    ASSERT_EQ(58u, decoder.getUInt(46, 10));
+    ASSERT_EQ(1u, decoder.getUInt(56, 1));
+    ASSERT_EQ(-2694000, decoder.getInt(57, 28));
+    ASSERT_EQ(29028000, decoder.getInt(85, 27));
+    ASSERT_EQ(450u, decoder.getUInt(112, 12));
+    ASSERT_EQ(40u, decoder.getUInt(124, 9));
+    ASSERT_EQ(60u, decoder.getUInt(133, 6));
+    // CS unit, using the whole band
+    ASSERT_EQ(1u, decoder.getUInt(141, 1));
+    ASSERT_EQ(1u, decoder.getUInt(144, 1));
+    // Fixed radio status of CS units
+    ASSERT_EQ(1u, decoder.getUInt(148, 1));
+    ASSERT_EQ(0x60006u, decoder.getUInt(149, 19));
+}
+
+TEST_F(AISEncoderTest, it_encodes_an_extended_class_b_position_report) {
+    encoder.clear();
+    encoder.setPosition(makePosition());
+    encoder.setVessel(makeVessel());
+    encoder.encode(AISEncoder::MESSAGE_19);
+    decode();
+
+    ASSERT_EQ(19, decoder.getMessageType());
+    ASSERT_EQ(312u, decoder.getBitCount());
+    ASSERT_EQ(227006760u, decoder.getMMSI());
+    ASSERT_EQ(58u, decoder.getUInt(46, 10));
+    ASSERT_EQ(-2694000, decoder.getInt(57, 28));
+    ASSERT_EQ(29028000, decoder.getInt(85, 27));
+    ASSERT_EQ(450u, decoder.getUInt(112, 12));
+    ASSERT_EQ(40u, decoder.getUInt(124, 9));
+    ASSERT_EQ("SEABOT ONE", decoder.getText(143, 20));
+    ASSERT_EQ(37u, decoder.getUInt(263, 8));
+    ASSERT_EQ(6u, decoder.getUInt(271, 9));
+    ASSERT_EQ(6u, decoder.getUInt(280, 9));
+    ASSERT_EQ(2u, decoder.getUInt(289, 6));
+    ASSERT_EQ(2u, decoder.getUInt(295, 6));
+    // DTE not ready
+    ASSERT_EQ(1u, decoder.getUInt(306, 1));
+}
+
+TEST_F(AISEncoderTest, it_encodes_an_aid_to_navigation_report) {
+    auto position = makePosition();
+    position.mmsi = 992276234;
+    auto vessel = makeVessel();
+    vessel.mmsi = 992276234;
+    vessel.name = "WEST CARDINAL";
+    encoder.clear();
+    encoder.setPosition(position);
+    encoder.setVessel(vessel);
+    encoder.encode(AISEncoder::MESSAGE_21);
+    decode();
+
+    ASSERT_EQ(21, decoder.getMessageType());
+    ASSERT_EQ(272u, decoder.getBitCount());
+    ASSERT_EQ(992276234u, decoder.getMMSI());
+    ASSERT_EQ(0u, decoder.getUInt(38, 5));
+    ASSERT_EQ("WEST CARDINAL", decoder.getText(43, 20));
+    ASSERT_EQ(1u, decoder.getUInt(163, 1));
+    ASSERT_EQ(-2694000, decoder.getInt(164, 28));
+    ASSERT_EQ(29028000, decoder.getInt(192, 27));
+    ASSERT_EQ(6u, decoder.getUInt(219, 9));
+    ASSERT_EQ(6u, decoder.getUInt(228, 9));
+    ASSERT_EQ(2u, decoder.getUInt(237, 6));
+    ASSERT_EQ(2u, decoder.getUInt(243, 6));
+    ASSERT_EQ(60u, decoder.getUInt(253, 6));
+    // Virtual aid
+    ASSERT_EQ(1u, decoder.getUInt(269, 1));
+}
+
+TEST_F(AISEncoderTest, it_encodes_class_b_static_data) {
+    encoder.clear();
+    encoder.setVessel(makeVessel());
+    encoder.encode(AISEncoder::MESSAGE_24A);
+    ASSERT_EQ(1u, encoder.getFragmentCount());
+    decode();
+    ASSERT_EQ(24, decoder.getMessageType());
+    ASSERT_EQ(168u, decoder.getBitCount());
+    ASSERT_EQ(227006760u, decoder.getMMSI());
+    ASSERT_EQ(0u, decoder.getUInt(38, 2));
+    ASSERT_EQ("SEABOT ONE", decoder.getText(40, 20));
+
+    encoder.encode(AISEncoder::MESSAGE_24B);
+    ASSERT_EQ(1u, encoder.getFragmentCount());
+    decode();
+    ASSERT_EQ(24, decoder.getMessageType());
+    ASSERT_EQ(168u, decoder.getBitCount());
+    ASSERT_EQ(1u, decoder.getUInt(38, 2));
+    ASSERT_EQ(37u, decoder.getUInt(40, 8));
+    ASSERT_EQ("SB01", decoder.getText(90, 7));
+    ASSERT_EQ(6u, decoder.getUInt(132, 9));
+    ASSERT_EQ(6u, decoder.getUInt(141, 9));
+    ASSERT_EQ(2u, decoder.getUInt(150, 6));
+    ASSERT_EQ(2u, decoder.getUInt(156, 6));
+}
+
+TEST_F(AISEncoderTest, it_does_not_leak_the_fields_of_a_previous_target) {
+    encoder.encode(makeVessel());
+    ais_base::Position position;
+    position.mmsi = 1;
+    encoder.encode(position);
+    encoder.encode(AISEncoder::MESSAGE_21);
+    decode();
+    ASSERT_EQ("", decoder.getText(43, 20));
+    ASSERT_EQ(0u, decoder.getUInt(219, 9));
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "../src/AISEncoder.hpp"
+#include "../src/AISDecoder.hpp"
+#include "../src/NMEA.hpp"
+
+#include <marnav/ais/ais.hpp>
+#include <marnav/ais/message_01.hpp>
+#include <marnav/ais/message_05.hpp>
+
+using namespace std;
+using namespace seabots_pi;
+
+/** Compares the encoder with marnav, which was used before it
+ *
+ * Inputs are chosen so that both libraries' rounding choices give the same
+ * result. The payloads are de-armored and compared on the fields that the
+ * encoder sets from Rock, as the defaults of the other fields (time stamp,
+ * ETA, destination) differ across marnav versions
+ */
+struct AISEncoderMarnavTest : public ::testing::Test {
+    AISEncoder encoder;
+    AISDecoder expected;
+    AISDecoder actual;
+
+    template<typename Message>
+    void decodeMarnav(Message const& message) {
+        auto payload = marnav::ais::encode_message(message);
+        for (size_t i = 0; i < payload.size(); ++i) {
+            nmea::VDMFragment fragment;
+            fragment.count = payload.size();
+            fragment.number = i + 1;
+            fragment.sequence_id = 1;
+            fragment.channel = 'B';
+            fragment.payload = nmea::Field(
+                payload[i].first.data(), payload[i].first.size()
+            );
+            fragment.fill_bits = payload[i].second;
+            expected.push(fragment);
+        }
+    }
+
+    void decodeEncoder() {
+        nmea::VDMFragment fragment;
+        fragment.count = 1;
+        fragment.number = 1;
+        fragment.channel = 'B';
+        fragment.payload = nmea::Field(
+            encoder.getPayload(), encoder.getPayloadSize()
+        );
+        fragment.fill_bits = encoder.getFillBits();
+        ASSERT_TRUE(actual.push(fragment));
+    }
+
+    void assertBitsEqual(size_t start, size_t end) {
+        for (size_t i = start; i < end; ++i) {
+            ASSERT_EQ(expected.getUInt(i, 1), actual.getUInt(i, 1)) << "bit " << i;
+        }
+    }
+};
+
+TEST_F(AISEncoderMarnavTest, it_encodes_position_reports_as_marnav) {
+    marnav::ais::message_01 message;
+    message.set_mmsi(marnav::utils::mmsi(227006760));
+    message.set_nav_status(static_cast<marnav::ais::navigation_status>(5));
+    message.set_rot(marnav::ais::rate_of_turn());
+    message.set_sog(12.5);
+    message.set_position_accuracy(true);
+    message.set_cog(123.5);
+    message.set_hdg(123u);
+    message.set_longitude(marnav::geo::longitude(-4.25));
+    message.set_latitude(marnav::geo::latitude(48.5));
+    decodeMarnav(message);
+
+    ais_base::Position position;
+    position.mmsi = 227006760;
+    position.status = static_cast<decltype(position.status)>(5);
+    position.speed_over_ground = 12.5 / nmea::MS_TO_KNOT;
+    position.high_accuracy_position = true;
+    position.course_over_ground = base::Angle::fromDeg(-123.5);
+    position.yaw = base::Angle::fromDeg(-123);
+    position.longitude = base::Angle::fromDeg(-4.25);
+    position.latitude = base::Angle::fromDeg(48.5);
+    encoder.encode(position);
+    decodeEncoder();
+
+    ASSERT_EQ(expected.getBitCount(), actual.getBitCount());
+    // Up to and including the heading
+    assertBitsEqual(0, 137);
+}
+
+TEST_F(AISEncoderMarnavTest, it_encodes_static_data_as_marnav) {
+    marnav::ais::message_05 message;
+    message.set_mmsi(marnav::utils::mmsi(227006760));
+    message.set_imo_number(9134270);
+    message.set_callsign("SB01");
+    message.set_shipname("SEABOT ONE");
+    message.set_shiptype(marnav::ais::ship_type(37));
+    message.set_to_bow(6);
+    message.set_to_stern(6);
+    message.set_to_port(2);
+    message.set_to_starboard(2);
+    message.set_draught(2.5);
+    decodeMarnav(message);
+
+    ais_base::VesselInformation vessel;
+    vessel.mmsi = 227006760;
+    vessel.imo = 9134270;
+    vessel.call_sign = "SB01";
+    vessel.name = "SEABOT ONE";
+    vessel.ship_type = static_cast<decltype(vessel.ship_type)>(37);
+    vessel.length = 12;
+    vessel.width = 4;
+    vessel.draft = 2.5;
+    encoder.encode(vessel);
+    // The encoder's payload spans two fragments, push it as a single one
+    decodeEncoder();
+
+    ASSERT_EQ(expected.getBitCount(), actual.getBitCount());
+    // Up to and including the dimensions, and the draught
+    assertBitsEqual(0, 270);
+    assertBitsEqual(294, 302);
+}
@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include "../src/AISScheduler.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+static const double KNOT = 1852.0 / 3600;
+
+struct AISSchedulerTest : public ::testing::Test {
+    AISScheduler scheduler;
+
+    AISSchedulerTest() {
+        AISScheduler::Configuration config;
+        config.near_range = 2 * 1852;
+        config.far_range = 12 * 1852;
+        config.cpa_threshold = 1852;
+        config.tcpa_threshold = base::Time::fromSeconds(20 * 60);
+        config.max_interval = base::Time::fromSeconds(180);
+        config.ownship_timeout = base::Time::fromSeconds(10);
+        config.sentences_per_second = 4;
+        config.priority_reserve = 0.5;
+        scheduler.setConfiguration(config);
+
+        // Ownship heading north at 10 knots
+        AISScheduler::Ownship ownship;
+        ownship.time = at(0);
+        ownship.latitude = base::Angle::fromDeg(48);
+        ownship.longitude = base::Angle::fromDeg(-4);
+        ownship.speed_over_ground = 10 * KNOT;
+        ownship.course_over_ground = base::Angle::fromDeg(0);
+        scheduler.updateOwnship(ownship);
+    }
+
+    static base::Time at(double seconds) {
+        return base::Time::fromSeconds(seconds);
+    }
+
+    /** A target at the given range north and east of ownship, in nautical
+     * miles
+     */
+    ais_base::Position makeTarget(double north, double east) {
+        ais_base::Position position;
+        position.mmsi = 1;
+        position.latitude = base::Angle::fromDeg(48 + north / 60);
+        position.longitude = base::Angle::fromDeg(
+            -4 + east / 60 / cos(48 * M_PI / 180)
+        );
+        position.speed_over_ground = 0;
+        position.course_over_ground = base::Angle::fromDeg(0);
+        return position;
+    }
+};
+
+TEST_F(AISSchedulerTest, it_follows_the_class_a_reporting_intervals) {
+    ASSERT_EQ(at(180), AISScheduler::getReportingInterval(0));
+    ASSERT_EQ(at(180), AISScheduler::getReportingInterval(2.9 * KNOT));
+    ASSERT_EQ(at(10), AISScheduler::getReportingInterval(10 * KNOT));
+    ASSERT_EQ(at(6), AISScheduler::getReportingInterval(20 * KNOT));
+    ASSERT_EQ(at(2), AISScheduler::getReportingInterval(30 * KNOT));
+    ASSERT_EQ(at(10), AISScheduler::getReportingInterval(base::unknown<double>()));
+}
+
+TEST_F(AISSchedulerTest, it_computes_the_range) {
+    auto decision = scheduler.schedule(makeTarget(3, 4), at(1));
+    ASSERT_NEAR(5 * 1852, decision.range, 10);
+}
+
+TEST_F(AISSchedulerTest, it_sends_close_targets_at_full_rate) {
+    auto target = makeTarget(-1, 1);
+    auto decision = scheduler.schedule(target, at(1));
+    ASSERT_TRUE(decision.priority);
+    ASSERT_EQ(base::Time(), decision.interval);
+}
+
+TEST_F(AISSchedulerTest, it_sends_converging_targets_at_full_rate) {
+    // 5 miles ahead, heading south at 10 knots, i.e. CPA in 15 minutes
+    auto target = makeTarget(5, 0.1);
+    target.speed_over_ground = 10 * KNOT;
+    target.course_over_ground = base::Angle::fromDeg(180);
+    auto decision = scheduler.schedule(target, at(1));
+    ASSERT_TRUE(decision.priority);
+    ASSERT_EQ(base::Time(), decision.interval);
+    ASSERT_NEAR(0.1 * 1852, decision.cpa, 10);
+    ASSERT_NEAR(15 * 60, decision.tcpa, 5);
+}
+
+TEST_F(AISSchedulerTest, it_does_not_prioritize_a_target_whose_cpa_is_too_far_in_the_future) {
+    // 10 miles ahead, at anchor, i.e. CPA in an hour
+    auto target = makeTarget(10, 0.1);
+    auto decision = scheduler.schedule(target, at(1));
+    ASSERT_FALSE(decision.priority);
+    ASSERT_NEAR(3600, decision.tcpa, 10);
+}
+
+TEST_F(AISSchedulerTest, it_does_not_prioritize_a_diverging_target) {
+    // 5 miles behind, heading south
+    auto target = makeTarget(-5, 0);
+    target.speed_over_ground = 10 * KNOT;
+    target.course_over_ground = base::Angle::fromDeg(180);
+    auto decision = scheduler.schedule(target, at(1));
+    ASSERT_FALSE(decision.priority);
+    ASSERT_LT(decision.tcpa, 0);
+    ASSERT_EQ(at(10), decision.interval);
+}
+
+TEST_F(AISSchedulerTest, it_uses_the_reporting_interval_between_the_near_and_far_ranges) {
+    auto target = makeTarget(0, 5);
+    target.speed_over_ground = 20 * KNOT;
+    target.course_over_ground = base::Angle::fromDeg(-90);
+    ASSERT_EQ(at(6), scheduler.schedule(target, at(1)).interval);
+}
+
+TEST_F(AISSchedulerTest, it_scales_the_interval_with_the_range_beyond_the_far_range) {
+    auto target = makeTarget(0, 24);
+    target.speed_over_ground = 20 * KNOT;
+    target.course_over_ground = base::Angle::fromDeg(-90);
+    auto interval = scheduler.schedule(target, at(1)).interval;
+    ASSERT_NEAR(12, interval.toSeconds(), 0.1);
+}
+
+TEST_F(AISSchedulerTest, it_caps_the_interval) {
+    auto target = makeTarget(0, 30);
+    auto decision = scheduler.schedule(target, at(1));
+    ASSERT_EQ(at(180), decision.interval);
+}
+
+TEST_F(AISSchedulerTest, it_sends_everything_at_full_rate_without_a_recent_ownship_fix) {
+    auto target = makeTarget(0, 30);
+    auto decision = scheduler.schedule(target, at(11));
+    ASSERT_TRUE(decision.priority);
+    ASSERT_EQ(base::Time(), decision.interval);
+    ASSERT_TRUE(base::isUnknown(decision.range));
+
+    AISScheduler empty;
+    ASSERT_TRUE(empty.schedule(target, at(1)).priority);
+}
+
+TEST_F(AISSchedulerTest, it_reserves_part_of_the_budget_for_priority_targets) {
+    AISScheduler::Decision normal;
+    AISScheduler::Decision priority;
+    priority.priority = true;
+
+    // Bucket of 4 tokens, 2 of them reserved
+    ASSERT_TRUE(scheduler.hasBudget(normal, at(0)));
+    scheduler.consume();
+    ASSERT_TRUE(scheduler.hasBudget(normal, at(0)));
+    scheduler.consume();
+    ASSERT_FALSE(scheduler.hasBudget(normal, at(0)));
+    ASSERT_TRUE(scheduler.hasBudget(priority, at(0)));
+    scheduler.consume();
+    ASSERT_TRUE(scheduler.hasBudget(priority, at(0)));
+    scheduler.consume();
+    ASSERT_FALSE(scheduler.hasBudget(priority, at(0)));
+}
+
+TEST_F(AISSchedulerTest, it_refills_the_budget_over_time) {
+    AISScheduler::Decision priority;
+    priority.priority = true;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(scheduler.hasBudget(priority, at(0)));
+        scheduler.consume();
+    }
+    ASSERT_FALSE(scheduler.hasBudget(priority, at(0)));
+    ASSERT_FALSE(scheduler.hasBudget(priority, at(0.2)));
+    ASSERT_TRUE(scheduler.hasBudget(priority, at(0.25)));
+}
+
+TEST_F(AISSchedulerTest, it_charges_each_sentence_of_a_message) {
+    AISScheduler::Decision priority;
+    priority.priority = true;
+    ASSERT_TRUE(scheduler.hasBudget(priority, at(0)));
+    scheduler.consume(3);
+    ASSERT_TRUE(scheduler.hasBudget(priority, at(0)));
+    scheduler.consume(1);
+    ASSERT_FALSE(scheduler.hasBudget(priority, at(0)));
+}
+
+TEST_F(AISSchedulerTest, it_delays_the_positions_after_sentences_sent_in_debt) {
+    AISScheduler::Decision priority;
+    priority.priority = true;
+    ASSERT_TRUE(scheduler.hasBudget(priority, at(0)));
+    // e.g. static data, which is sent regardless of the budget
+    scheduler.consume(6);
+    ASSERT_FALSE(scheduler.hasBudget(priority, at(0.5)));
+    ASSERT_TRUE(scheduler.hasBudget(priority, at(0.75)));
+}
+
+TEST_F(AISSchedulerTest, it_allows_one_sentence_at_low_rates) {
+    auto config = scheduler.getConfiguration();
+    config.sentences_per_second = 0.5;
+    scheduler.setConfiguration(config);
+
+    AISScheduler::Decision normal;
+    ASSERT_TRUE(scheduler.hasBudget(normal, at(0)));
+    scheduler.consume();
+    ASSERT_FALSE(scheduler.hasBudget(normal, at(1)));
+    ASSERT_TRUE(scheduler.hasBudget(normal, at(2)));
+}
+
+TEST_F(AISSchedulerTest, it_does_not_limit_the_rate_if_the_budget_is_zero) {
+    auto config = scheduler.getConfiguration();
+    config.sentences_per_second = 0;
+    scheduler.setConfiguration(config);
+
+    AISScheduler::Decision normal;
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(scheduler.hasBudget(normal, at(0)));
+        scheduler.consume();
+    }
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include "../src/AISTargetTable.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+struct AISTargetTableTest : public ::testing::Test {
+    AISTargetTable table;
+
+    AISTargetTableTest() {
+        AISTargetTable::Configuration config;
+        config.static_period = base::Time::fromSeconds(360);
+        config.position_repeat_period = base::Time::fromSeconds(180);
+        config.target_timeout = base::Time::fromSeconds(600);
+        table.setConfiguration(config);
+    }
+
+    static base::Time at(int64_t seconds) {
+        return base::Time::fromSeconds(seconds);
+    }
+
+    ais_base::Position makePosition(int mmsi) {
+        ais_base::Position position;
+        position.mmsi = mmsi;
+        position.latitude = base::Angle::fromDeg(48);
+        position.longitude = base::Angle::fromDeg(-4);
+        position.speed_over_ground = 2;
+        return position;
+    }
+
+    ais_base::VesselInformation makeVessel(int mmsi) {
+        ais_base::VesselInformation vessel;
+        vessel.mmsi = mmsi;
+        vessel.name = "SEABOT";
+        vessel.call_sign = "SB01";
+        vessel.length = 12;
+        vessel.width = 4;
+        return vessel;
+    }
+};
+
+TEST_F(AISTargetTableTest, it_ignores_the_sample_time_in_the_hash) {
+    auto vessel = makeVessel(1);
+    uint64_t hash = AISTargetTable::hash(vessel);
+    vessel.time = at(10);
+    ASSERT_EQ(hash, AISTargetTable::hash(vessel));
+    vessel.name = "OTHER";
+    ASSERT_NE(hash, AISTargetTable::hash(vessel));
+}
+
+TEST_F(AISTargetTableTest, it_sends_the_first_static_data_of_a_target) {
+    ASSERT_TRUE(table.updateStatic(makeVessel(1), at(0)));
+    ASSERT_TRUE(table.updateStatic(makeVessel(2), at(0)));
+    ASSERT_EQ(2u, table.size());
+}
+
+TEST_F(AISTargetTableTest, it_skips_unchanged_static_data) {
+    table.updateStatic(makeVessel(1), at(0));
+    ASSERT_FALSE(table.updateStatic(makeVessel(1), at(10)));
+    ASSERT_EQ(1u, table.getStaticSuppressedCount());
+
+    AISTargetTable::TargetStatistics stats;
+    ASSERT_TRUE(table.getStatistics(1, stats));
+    ASSERT_EQ(1u, stats.static_sent);
+    ASSERT_EQ(1u, stats.static_suppressed);
+    ASSERT_EQ(at(10), stats.last_update);
+}
+
+TEST_F(AISTargetTableTest, it_sends_changed_static_data) {
+    table.updateStatic(makeVessel(1), at(0));
+    auto vessel = makeVessel(1);
+    vessel.draft = 2.5;
+    ASSERT_TRUE(table.updateStatic(vessel, at(10)));
+}
+
+TEST_F(AISTargetTableTest, it_sends_unchanged_static_data_after_the_static_period) {
+    table.updateStatic(makeVessel(1), at(0));
+    ASSERT_TRUE(table.updateStatic(makeVessel(1), at(360)));
+}
+
+TEST_F(AISTargetTableTest, it_treats_unknown_values_as_equal) {
+    auto vessel = makeVessel(1);
+    vessel.draft = base::unknown<double>();
+    table.updateStatic(vessel, at(0));
+    ASSERT_FALSE(table.updateStatic(vessel, at(10)));
+}
+
+TEST_F(AISTargetTableTest, it_returns_the_stored_static_data_when_due) {
+    table.updateStatic(makeVessel(1), at(0));
+
+    ais_base::VesselInformation vessel;
+    ASSERT_FALSE(table.takeDueStatic(1, at(359), vessel));
+    ASSERT_TRUE(table.takeDueStatic(1, at(360), vessel));
+    ASSERT_EQ(1, vessel.mmsi);
+    ASSERT_EQ("SEABOT", vessel.name);
+    // And not again until the next period
+    ASSERT_FALSE(table.takeDueStatic(1, at(361), vessel));
+    ASSERT_TRUE(table.takeDueStatic(1, at(720), vessel));
+    ASSERT_EQ(2u, table.getStaticRepeatedCount());
+}
+
+TEST_F(AISTargetTableTest, it_does_not_repeat_static_data_it_never_received) {
+    table.updatePosition(makePosition(1), at(0));
+    ais_base::VesselInformation vessel;
+    ASSERT_FALSE(table.takeDueStatic(1, at(1000), vessel));
+    ASSERT_FALSE(table.takeDueStatic(2, at(1000), vessel));
+    ASSERT_FALSE(table.getStatic(1, vessel));
+}
+
+TEST_F(AISTargetTableTest, it_returns_the_last_sent_static_data) {
+    table.updateStatic(makeVessel(1), at(0));
+    auto vessel = makeVessel(1);
+    vessel.name = "OTHER";
+    table.updateStatic(vessel, at(10));
+
+    ais_base::VesselInformation stored;
+    ASSERT_TRUE(table.getStatic(1, stored));
+    ASSERT_EQ("OTHER", stored.name);
+}
+
+TEST_F(AISTargetTableTest, it_keeps_the_class_given_by_the_last_position) {
+    ASSERT_EQ(AISEncoder::CLASS_A, table.getTargetClass(1));
+    ASSERT_EQ(AISEncoder::AID_TO_NAVIGATION, table.getTargetClass(992271234));
+
+    auto position = makePosition(1);
+    position.status = ais_base::STATUS_NOT_DEFINED;
+    position.yaw_velocity = base::unknown<double>();
+    table.updatePosition(position, at(0));
+    ASSERT_EQ(AISEncoder::CLASS_B, table.getTargetClass(1));
+
+    position.yaw_velocity = 0;
+    table.updatePosition(position, at(1));
+    ASSERT_EQ(AISEncoder::CLASS_A, table.getTargetClass(1));
+}
+
+TEST_F(AISTargetTableTest, it_skips_identical_positions_within_the_repeat_period) {
+    ASSERT_TRUE(table.updatePosition(makePosition(1), at(0)));
+    ASSERT_FALSE(table.updatePosition(makePosition(1), at(10)));
+    ASSERT_TRUE(table.updatePosition(makePosition(1), at(180)));
+    ASSERT_EQ(1u, table.getPositionSuppressedCount());
+}
+
+TEST_F(AISTargetTableTest, it_sends_changed_positions) {
+    table.updatePosition(makePosition(1), at(0));
+    auto position = makePosition(1);
+    position.latitude = base::Angle::fromDeg(48.0001);
+    ASSERT_TRUE(table.updatePosition(position, at(1)));
+    // Other targets are independent
+    ASSERT_TRUE(table.updatePosition(makePosition(2), at(1)));
+}
+
+TEST_F(AISTargetTableTest, it_forgets_targets_that_were_not_updated) {
+    table.updatePosition(makePosition(1), at(0));
+    table.updatePosition(makePosition(2), at(500));
+    table.prune(at(700));
+    ASSERT_EQ(1u, table.size());
+    AISTargetTable::TargetStatistics stats;
+    ASSERT_FALSE(table.getStatistics(1, stats));
+    ASSERT_TRUE(table.getStatistics(2, stats));
+}
+
+TEST_F(AISTargetTableTest, it_prunes_automatically_on_updates) {
+    table.updatePosition(makePosition(1), at(0));
+    table.updatePosition(makePosition(2), at(1300));
+    ASSERT_EQ(1u, table.size());
+}
+
+TEST_F(AISTargetTableTest, it_decimates_positions_received_within_the_minimum_interval) {
+    auto position = makePosition(1);
+    ASSERT_TRUE(table.updatePosition(position, at(0), at(10)));
+    position.speed_over_ground = 3;
+    ASSERT_FALSE(table.updatePosition(position, at(5), at(10)));
+    ASSERT_TRUE(table.updatePosition(position, at(10), at(10)));
+    ASSERT_EQ(1u, table.getPositionDecimatedCount());
+    ASSERT_EQ(0u, table.getPositionSuppressedCount());
+
+    AISTargetTable::TargetStatistics stats;
+    table.getStatistics(1, stats);
+    ASSERT_EQ(2u, stats.positions_sent);
+    ASSERT_EQ(1u, stats.positions_decimated);
+}
+
+TEST_F(AISTargetTableTest, it_does_not_record_a_position_over_budget) {
+    auto position = makePosition(1);
+    ASSERT_TRUE(table.updatePosition(position, at(0), at(10)));
+    position.speed_over_ground = 3;
+    ASSERT_FALSE(table.updatePosition(position, at(10), at(10), false));
+    ASSERT_EQ(1u, table.getPositionOverBudgetCount());
+    // Sent as soon as there is budget, and not suppressed as a duplicate
+    ASSERT_TRUE(table.updatePosition(position, at(11), at(10)));
+
+    AISTargetTable::TargetStatistics stats;
+    table.getStatistics(1, stats);
+    ASSERT_EQ(1u, stats.positions_over_budget);
+}
+
+TEST_F(AISTargetTableTest, it_counts_a_position_as_over_budget_only_if_it_would_be_sent) {
+    auto position = makePosition(1);
+    table.updatePosition(position, at(0));
+    ASSERT_FALSE(table.updatePosition(position, at(1), base::Time(), false));
+    ASSERT_EQ(1u, table.getPositionSuppressedCount());
+    ASSERT_EQ(0u, table.getPositionOverBudgetCount());
+}
@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include "../src/ContactBuffer.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+struct ContactBufferTest : public ::testing::Test {
+    ContactBuffer buffer;
+
+    ContactBufferTest() {
+        ContactBuffer::Configuration config;
+        config.timeout = at(60);
+        buffer.setConfiguration(config);
+    }
+
+    static base::Time at(double seconds) {
+        return base::Time::fromSeconds(seconds);
+    }
+
+    static ais_base::Position makePosition(
+        uint32_t mmsi, double latitude, double longitude
+    ) {
+        ais_base::Position position;
+        position.mmsi = mmsi;
+        position.latitude = base::Angle::fromDeg(latitude);
+        position.longitude = base::Angle::fromDeg(longitude);
+        return position;
+    }
+
+    static ais_base::VesselInformation makeVessel(uint32_t mmsi, double length) {
+        ais_base::VesselInformation vessel;
+        vessel.mmsi = mmsi;
+        vessel.length = length;
+        return vessel;
+    }
+
+    /** Length in mercator meters of a contact at the given latitude */
+    static float mercatorLength(double length, double latitude) {
+        return length / cos(latitude * M_PI / 180);
+    }
+
+    ContactBuffer::Snapshot snapshot() {
+        ContactBuffer::Snapshot result;
+        buffer.updateSnapshot(result);
+        return result;
+    }
+
+    /** Index of a contact in a snapshot, from its position */
+    static size_t find(
+        ContactBuffer::Snapshot const& snapshot, double latitude, double longitude
+    ) {
+        Eigen::Vector2d local = snapshot.origin.toLocal(latitude, longitude);
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            if (fabs(snapshot.positions[2 * i] - local.x()) < 1 &&
+                fabs(snapshot.positions[2 * i + 1] - local.y()) < 1) {
+                return i;
+            }
+        }
+        return snapshot.size();
+    }
+};
+
+TEST_F(ContactBufferTest, it_stores_positions_relative_to_the_first_contact) {
+    buffer.updatePosition(makePosition(1, 48, -4), at(0));
+    buffer.updatePosition(makePosition(2, 48.01, -3.99), at(0));
+
+    auto result = snapshot();
+    ASSERT_EQ(2, result.size());
+    ASSERT_EQ(4, result.positions.size());
+    ASSERT_DOUBLE_EQ(48, result.origin.latitude_deg);
+    ASSERT_DOUBLE_EQ(-4, result.origin.longitude_deg);
+    ASSERT_FLOAT_EQ(0, result.positions[0]);
+    ASSERT_FLOAT_EQ(0, result.positions[1]);
+
+    Eigen::Vector2d expected = result.origin.toLocal(48.01, -3.99);
+    ASSERT_FLOAT_EQ(expected.x(), result.positions[2]);
+    ASSERT_FLOAT_EQ(expected.y(), result.positions[3]);
+}
+
+TEST_F(ContactBufferTest, it_updates_a_known_contact_in_place) {
+    buffer.updatePosition(makePosition(1, 48, -4), at(0));
+    buffer.updatePosition(makePosition(2, 48.01, -4), at(0));
+    buffer.updatePosition(makePosition(1, 48.02, -4), at(1));
+
+    auto result = snapshot();
+    ASSERT_EQ(2, result.size());
+    Eigen::Vector2d expected = result.origin.toLocal(48.02, -4);
+    ASSERT_FLOAT_EQ(expected.x(), result.positions[0]);
+    ASSERT_FLOAT_EQ(expected.y(), result.positions[1]);
+}
+
+TEST_F(ContactBufferTest, it_ignores_positions_without_latitude_or_longitude) {
+    ais_base::Position position = makePosition(1, 48, -4);
+    position.latitude = base::Angle();
+    buffer.updatePosition(position, at(0));
+    ASSERT_EQ(0, buffer.size());
+}
+
+TEST_F(ContactBufferTest, it_uses_the_yaw_then_the_course_as_heading) {
+    auto position = makePosition(1, 48, -4);
+    position.yaw = base::Angle::fromDeg(30);
+    position.course_over_ground = base::Angle::fromDeg(40);
+    buffer.updatePosition(position, at(0));
+    ASSERT_FLOAT_EQ(M_PI / 6, snapshot().headings[0]);
+
+    position.yaw = base::Angle();
+    buffer.updatePosition(position, at(1));
+    ASSERT_FLOAT_EQ(40 * M_PI / 180, snapshot().headings[0]);
+
+    position.course_over_ground = base::Angle();
+    buffer.updatePosition(position, at(2));
+    ASSERT_FLOAT_EQ(0, snapshot().headings[0]);
+}
+
+TEST_F(ContactBufferTest, it_stores_the_target_class) {
+    auto class_a = makePosition(227006760, 48, -4);
+    class_a.status = static_cast<decltype(class_a.status)>(0);
+    buffer.updatePosition(class_a, at(0));
+    buffer.updatePosition(makePosition(227006761, 48.01, -4), at(0));
+    buffer.updatePosition(makePosition(992271234, 48.02, -4), at(0));
+
+    auto result = snapshot();
+    ASSERT_EQ(AISEncoder::CLASS_A, result.classes[0]);
+    ASSERT_EQ(AISEncoder::CLASS_B, result.classes[1]);
+    ASSERT_EQ(AISEncoder::AID_TO_NAVIGATION, result.classes[2]);
+
+    AISEncoder::TargetClass target_class;
+    ASSERT_TRUE(buffer.getTargetClass(227006761, target_class));
+    ASSERT_EQ(AISEncoder::CLASS_B, target_class);
+    ASSERT_FALSE(buffer.getTargetClass(1, target_class));
+}
+
+TEST_F(ContactBufferTest, it_applies_the_length_of_known_contacts) {
+    buffer.updatePosition(makePosition(1, 48, -4), at(0));
+    ASSERT_FLOAT_EQ(0, snapshot().lengths[0]);
+
+    buffer.updateStatic(makeVessel(1, 25), at(1));
+    ASSERT_FLOAT_EQ(mercatorLength(25, 48), snapshot().lengths[0]);
+}
+
+TEST_F(ContactBufferTest, it_keeps_the_length_received_before_the_first_position) {
+    buffer.updateStatic(makeVessel(1, 25), at(0));
+    ASSERT_EQ(0, buffer.size());
+
+    buffer.updatePosition(makePosition(1, 48, -4), at(1));
+    ASSERT_FLOAT_EQ(mercatorLength(25, 48), snapshot().lengths[0]);
+}
+
+TEST_F(ContactBufferTest, it_scales_the_lengths_to_mercator_meters) {
+    buffer.updatePosition(makePosition(1, 0, -4), at(0));
+    buffer.updateStatic(makeVessel(1, 100), at(0));
+    ASSERT_FLOAT_EQ(100, snapshot().lengths[0]);
+
+    buffer.updatePosition(makePosition(1, 60, -4), at(1));
+    ASSERT_FLOAT_EQ(200, snapshot().lengths[0]);
+    buffer.updateStatic(makeVessel(1, 50), at(2));
+    ASSERT_FLOAT_EQ(100, snapshot().lengths[0]);
+    buffer.updatePosition(makePosition(1, -60, -4), at(3));
+    ASSERT_FLOAT_EQ(100, snapshot().lengths[0]);
+}
+
+TEST_F(ContactBufferTest, it_handles_an_unknown_length_as_zero) {
+    buffer.updatePosition(makePosition(1, 48, -4), at(0));
+    buffer.updateStatic(makeVessel(1, base::unknown<double>()), at(0));
+    ASSERT_FLOAT_EQ(0, snapshot().lengths[0]);
+}
+
+TEST_F(ContactBufferTest, it_removes_stale_contacts_and_keeps_the_others_consistent) {
+    buffer.updatePosition(makePosition(1, 48, -4), at(0));
+    buffer.updateStatic(makeVessel(1, 10), at(0));
+    buffer.updatePosition(makePosition(2, 48.01, -4), at(0));
+    buffer.updateStatic(makeVessel(2, 20), at(0));
+    buffer.updatePosition(makePosition(3, 48.02, -4), at(30));
+    buffer.updateStatic(makeVessel(3, 30), at(30));
+
+    buffer.prune(at(61));
+    auto result = snapshot();
+    ASSERT_EQ(1, result.size());
+    ASSERT_EQ(0, find(result, 48.02, -4));
+    ASSERT_FLOAT_EQ(mercatorLength(30, 48.02), result.lengths[0]);
+
+    AISEncoder::TargetClass target_class;
+    ASSERT_FALSE(buffer.getTargetClass(1, target_class));
+    ASSERT_TRUE(buffer.getTargetClass(3, target_class));
+
+    // Updating the moved contact must update it, not add a new one
+    buffer.updatePosition(makePosition(3, 48.03, -4), at(62));
+    result = snapshot();
+    ASSERT_EQ(1, result.size());
+    ASSERT_EQ(0, find(result, 48.03, -4));
+}
+
+TEST_F(ContactBufferTest, it_prunes_while_updating_at_most_once_per_timeout) {
+    buffer.updatePosition(makePosition(1, 48, -4), at(0));
+    buffer.updatePosition(makePosition(2, 48.01, -4), at(10));
+    buffer.updatePosition(makePosition(3, 48.02, -4), at(61));
+    ASSERT_EQ(2, buffer.size());
+
+    // Contact 2 is stale, but the last prune was less than a timeout ago
+    buffer.updatePosition(makePosition(3, 48.02, -4), at(75));
+    ASSERT_EQ(2, buffer.size());
+    buffer.updatePosition(makePosition(3, 48.02, -4), at(121));
+    ASSERT_EQ(1, buffer.size());
+}
+
+TEST_F(ContactBufferTest, it_removes_contacts_when_no_further_update_arrives) {
+    buffer.updatePosition(makePosition(1, 48, -4), at(0));
+    buffer.updatePosition(makePosition(2, 48.01, -4), at(30));
+
+    ASSERT_FALSE(buffer.prune(at(60)));
+    ASSERT_EQ(2, buffer.size());
+    ASSERT_TRUE(buffer.prune(at(61)));
+    ASSERT_EQ(1, buffer.size());
+    ASSERT_TRUE(buffer.prune(at(91)));
+    ASSERT_EQ(0, buffer.size());
+    ASSERT_EQ(0, snapshot().size());
+}
+
+TEST_F(ContactBufferTest, it_forgets_the_static_data_of_targets_without_position) {
+    buffer.updateStatic(makeVessel(1, 25), at(0));
+    buffer.prune(at(61));
+    buffer.updatePosition(makePosition(1, 48, -4), at(62));
+    ASSERT_FLOAT_EQ(0, snapshot().lengths[0]);
+}
+
+TEST_F(ContactBufferTest, it_copies_the_snapshot_only_if_the_contacts_changed) {
+    ContactBuffer::Snapshot result;
+    ASSERT_FALSE(buffer.updateSnapshot(result));
+
+    buffer.updatePosition(makePosition(1, 48, -4), at(0));
+    ASSERT_TRUE(buffer.updateSnapshot(result));
+    ASSERT_EQ(buffer.getRevision(), result.revision);
+    ASSERT_FALSE(buffer.updateSnapshot(result));
+
+    buffer.updateStatic(makeVessel(1, 25), at(0));
+    ASSERT_TRUE(buffer.updateSnapshot(result));
+    buffer.updateStatic(makeVessel(1, 25), at(1));
+    ASSERT_FALSE(buffer.updateSnapshot(result));
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include "../src/Mercator.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+struct MercatorTest : public ::testing::Test {
+    /** Transcription of OpenCPN's toSM and ViewPort::GetDoublePixFromLL for
+     * the mercator projection, i.e. what GetCanvasPixLL computes before
+     * rounding to integer pixels
+     */
+    Eigen::Vector2d ocpnPixel(
+        mercator::Viewport const& vp, double lat, double lon
+    ) {
+        double xlon = lon;
+        if ((lon * vp.center_longitude_deg < 0.) &&
+            (fabs(lon - vp.center_longitude_deg) > 180.)) {
+            lon < 0.0 ? xlon += 360.0 : xlon -= 360.0;
+        }
+        const double z = 6378137.0 * 0.9996;
+        double easting = (xlon - vp.center_longitude_deg) * M_PI / 180 * z;
+        const double s = sin(lat * M_PI / 180);
+        const double y3 = (.5 * log((1 + s) / (1 - s))) * z;
+        const double s0 = sin(vp.center_latitude_deg * M_PI / 180);
+        const double y30 = (.5 * log((1 + s0) / (1 - s0))) * z;
+        double northing = y3 - y30;
+
+        double epix = easting * vp.scale;
+        double npix = northing * vp.scale;
+        double dxr = epix * cos(vp.rotation_rad) + npix * sin(vp.rotation_rad);
+        double dyr = npix * cos(vp.rotation_rad) - epix * sin(vp.rotation_rad);
+        return Eigen::Vector2d(vp.width / 2.0 + dxr, vp.height / 2.0 - dyr);
+    }
+
+    /** Project through float local coordinates, as the GPU does */
+    Eigen::Vector2d pixelThroughFloat(
+        mercator::Origin const& origin, mercator::Viewport const& vp,
+        double lat, double lon
+    ) {
+        Eigen::Vector2d local = origin.toLocal(lat, lon);
+        Eigen::Vector2d asFloat(
+            static_cast<float>(local.x()), static_cast<float>(local.y())
+        );
+        return mercator::toPixel(origin, vp, asFloat);
+    }
+};
+
+TEST_F(MercatorTest, it_has_a_zero_northing_at_the_equator) {
+    ASSERT_NEAR(0, mercator::northing(0), 1e-9);
+}
+
+TEST_F(MercatorTest, it_computes_the_easting_across_the_antimeridian) {
+    double expected = 2 * M_PI / 180 * mercator::RADIUS;
+    ASSERT_NEAR(expected, mercator::easting(-179, 179), 1e-6);
+    ASSERT_NEAR(-expected, mercator::easting(179, -179), 1e-6);
+}
+
+TEST_F(MercatorTest, it_maps_local_coordinates_relative_to_the_origin) {
+    mercator::Origin origin(-23.5, -46.3);
+    Eigen::Vector2d local = origin.toLocal(-23.5, -46.3);
+    ASSERT_NEAR(0, local.x(), 1e-9);
+    ASSERT_NEAR(0, local.y(), 1e-9);
+}
+
+TEST_F(MercatorTest, it_projects_the_viewport_center_at_the_middle_of_the_canvas) {
+    mercator::Origin origin(-23.5, -46.3);
+    mercator::Viewport vp;
+    vp.center_latitude_deg = -23.6;
+    vp.center_longitude_deg = -46.2;
+    vp.scale = 0.1;
+    vp.rotation_rad = 0.3;
+    vp.width = 800;
+    vp.height = 600;
+
+    Eigen::Vector2d pixel = mercator::toPixel(
+        origin, vp, origin.toLocal(-23.6, -46.2)
+    );
+    ASSERT_NEAR(400, pixel.x(), 1e-6);
+    ASSERT_NEAR(300, pixel.y(), 1e-6);
+}
+
+TEST_F(MercatorTest, it_matches_OpenCPNs_projection_with_sub_pixel_accuracy) {
+    mercator::Origin origin(-23.95, -46.31);
+
+    // From ocean scale to harbour scale, points up to 50km from the origin
+    for (double scale = 1e-4; scale < 10; scale *= 3) {
+        for (double rotation = -M_PI; rotation < M_PI; rotation += 0.7) {
+            mercator::Viewport vp;
+            vp.center_latitude_deg = -23.9;
+            vp.center_longitude_deg = -46.25;
+            vp.scale = scale;
+            vp.rotation_rad = rotation;
+            vp.width = 1920;
+            vp.height = 1080;
+
+            for (double dlat = -0.4; dlat <= 0.4; dlat += 0.05) {
+                for (double dlon = -0.4; dlon <= 0.4; dlon += 0.05) {
+                    double lat = origin.latitude_deg + dlat;
+                    double lon = origin.longitude_deg + dlon;
+                    auto expected = ocpnPixel(vp, lat, lon);
+                    auto actual = pixelThroughFloat(origin, vp, lat, lon);
+                    ASSERT_NEAR(expected.x(), actual.x(), 0.1)
+                        << "scale=" << scale << " lat=" << lat << " lon=" << lon;
+                    ASSERT_NEAR(expected.y(), actual.y(), 0.1)
+                        << "scale=" << scale << " lat=" << lat << " lon=" << lon;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(MercatorTest, it_matches_OpenCPNs_projection_across_the_antimeridian) {
+    mercator::Origin origin(-17.7, 179.9);
+    mercator::Viewport vp;
+    vp.center_latitude_deg = -17.7;
+    vp.center_longitude_deg = -179.95;
+    vp.scale = 0.05;
+    vp.width = 1920;
+    vp.height = 1080;
+
+    for (double lon : { 179.8, 179.95, -179.99, -179.9 }) {
+        auto expected = ocpnPixel(vp, -17.71, lon);
+        auto actual = pixelThroughFloat(origin, vp, -17.71, lon);
+        ASSERT_NEAR(expected.x(), actual.x(), 0.1) << "lon=" << lon;
+        ASSERT_NEAR(expected.y(), actual.y(), 0.1) << "lon=" << lon;
+    }
+}
+
+TEST_F(MercatorTest, it_converts_lat_lon_bounds_to_local_bounds) {
+    mercator::Origin origin(-23.5, -46.3);
+    auto box = origin.toLocal(-24, -23, -47, -46);
+    auto min = origin.toLocal(-24, -47);
+    auto max = origin.toLocal(-23, -46);
+    ASSERT_NEAR(min.x(), box.min().x(), 1e-6);
+    ASSERT_NEAR(min.y(), box.min().y(), 1e-6);
+    ASSERT_NEAR(max.x(), box.max().x(), 1e-6);
+    ASSERT_NEAR(max.y(), box.max().y(), 1e-6);
+}
+
+TEST_F(MercatorTest, it_does_not_bound_X_if_the_bounds_cross_the_origins_antimeridian) {
+    mercator::Origin origin(-23.5, 0);
+    auto box = origin.toLocal(-24, -23, 170, -170);
+    ASSERT_TRUE(std::isinf(box.min().x()));
+    ASSERT_TRUE(std::isinf(box.max().x()));
+    ASSERT_FALSE(std::isinf(box.min().y()));
+}
+
+TEST_F(MercatorTest, it_does_not_bound_X_if_the_bounds_cover_the_whole_world) {
+    mercator::Origin origin(-23.5, 0);
+    auto box = origin.toLocal(-24, -23, -180, 180);
+    ASSERT_TRUE(std::isinf(box.min().x()));
+    ASSERT_TRUE(std::isinf(box.max().x()));
+}
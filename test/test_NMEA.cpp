@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 #include "../src/NMEA.hpp"
 
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
 using namespace std;
 using namespace seabots_pi;
 
@@ -15,6 +21,26 @@ TEST_F(NMEATest, it_builds_a_valid_NMEA_package_from_its_checksum) {
     ASSERT_EQ(string("$PFEC,GPint,RMC05*2D"), nmea::createPackage("PFEC,GPint,RMC05"));
 }
 
+TEST_F(NMEATest, it_always_writes_two_checksum_digits) {
+    ASSERT_EQ(string("$AB*03"), nmea::createPackage("AB"));
+    ASSERT_EQ(string("03"), nmea::computeChecksum("AB"));
+}
+
+TEST_F(NMEATest, it_frames_a_payload_in_a_fixed_buffer) {
+    nmea::Sentence sentence;
+    sentence.put("garbage");
+    nmea::frameSentence(sentence, "PFEC,GPint,RMC05", 16);
+    ASSERT_EQ("$PFEC,GPint,RMC05*2D", sentence.str());
+    ASSERT_FALSE(sentence.hasOverflowed());
+}
+
+TEST_F(NMEATest, it_reports_payloads_too_long_to_be_framed) {
+    string payload(nmea::Sentence::CAPACITY - 3, 'a');
+    nmea::Sentence sentence;
+    nmea::frameSentence(sentence, payload.c_str(), payload.size());
+    ASSERT_TRUE(sentence.hasOverflowed());
+}
+
 TEST_F(NMEATest, it_builds_a_VTG_message_with_all_required_info) {
     base::Angle geographic = base::Angle::fromDeg(10.42);
     base::Angle magnetic = base::Angle::fromDeg(15.21);
@@ -50,6 +76,70 @@ TEST_F(NMEATest, it_converts_a_time_into_the_UTC_format_required_by_NMEA) {
     ASSERT_EQ("250419", converted.second);
 }
 
+static string formatTimeAndDate(
+    nmea::TimeFormatter& formatter, base::Time const& time
+) {
+    nmea::Sentence sentence;
+    formatter.putTime(sentence, time);
+    sentence.put(',');
+    formatter.putDate(sentence, time);
+    return sentence.str();
+}
+
+TEST_F(NMEATest, it_patches_the_centiseconds_within_the_same_second) {
+    nmea::TimeFormatter formatter;
+    base::Time time = base::Time::fromMilliseconds(1556222665123);
+    ASSERT_EQ("200425.12,250419", formatTimeAndDate(formatter, time));
+    time = base::Time::fromMilliseconds(1556222665999);
+    ASSERT_EQ("200425.99,250419", formatTimeAndDate(formatter, time));
+}
+
+TEST_F(NMEATest, it_updates_the_cached_time_on_second_rollovers) {
+    nmea::TimeFormatter formatter;
+    base::Time time = base::Time::fromMilliseconds(1556222665999);
+    ASSERT_EQ("200425.99,250419", formatTimeAndDate(formatter, time));
+    time = base::Time::fromMilliseconds(1556222666000);
+    ASSERT_EQ("200426.00,250419", formatTimeAndDate(formatter, time));
+}
+
+TEST_F(NMEATest, it_updates_the_cached_date_on_midnight_rollovers) {
+    nmea::TimeFormatter formatter;
+    // 2019-12-31 23:59:59.99
+    base::Time time = base::Time::fromMilliseconds(1577836799990);
+    ASSERT_EQ("235959.99,311219", formatTimeAndDate(formatter, time));
+    time = base::Time::fromMilliseconds(1577836800000);
+    ASSERT_EQ("000000.00,010120", formatTimeAndDate(formatter, time));
+}
+
+TEST_F(NMEATest, it_handles_times_going_backwards) {
+    nmea::TimeFormatter formatter;
+    base::Time time = base::Time::fromMilliseconds(1577836800000);
+    ASSERT_EQ("000000.00,010120", formatTimeAndDate(formatter, time));
+    time = base::Time::fromMilliseconds(1577836799990);
+    ASSERT_EQ("235959.99,311219", formatTimeAndDate(formatter, time));
+}
+
+TEST_F(NMEATest, it_formats_times_like_gmtime) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int64_t> values(0, 4102444800000LL);
+    nmea::TimeFormatter formatter;
+    for (int i = 0; i < 10000; ++i) {
+        int64_t ms = values(rng);
+        time_t unix_time = ms / 1000;
+        struct tm utc_time;
+        gmtime_r(&unix_time, &utc_time);
+        char expected[32];
+        strftime(expected, sizeof(expected), "%H%M%S", &utc_time);
+        string expected_str = string(expected) + "." +
+            to_string(ms / 100 % 10) + to_string(ms / 10 % 10);
+        strftime(expected, sizeof(expected), ",%d%m%y", &utc_time);
+        expected_str += expected;
+
+        ASSERT_EQ(expected_str, formatTimeAndDate(
+            formatter, base::Time::fromMilliseconds(ms)));
+    }
+}
+
 TEST_F(NMEATest, it_converts_an_angle_in_DMS_format) {
     base::Angle angle = base::Angle::fromDeg(43.2135634);
     ASSERT_EQ("4312.813", nmea::getAngleDMS(angle, 2));
@@ -116,5 +206,150 @@ TEST_F(NMEATest, it_goes_west_for_a_negative_longitude) {
 TEST_F(NMEATest, it_creates_a_heading_message) {
     base::Angle heading = base::Angle::fromDeg(10.42);
     string msg = nmea::createHDT(heading);
-    ASSERT_EQ("$SBHDT,349.58,T*0", msg);
+    ASSERT_EQ("$SBHDT,349.58,T*00", msg);
+}
+
+TEST_F(NMEATest, it_creates_a_GGA_message) {
+    base::Time time = base::Time::fromMilliseconds(1556222665123);
+    base::Angle latitude = base::Angle::fromDeg(43.2135634);
+    base::Angle longitude = base::Angle::fromDeg(43.018);
+    string msg = nmea::createGGA(time, latitude, longitude, 1, 8, 12.5);
+    ASSERT_EQ("$SBGGA,200425.12,4312.813,N,04301.079,E,1,08,,12.5,M,,M,,*60", msg);
+}
+
+TEST_F(NMEATest, it_creates_a_ZDA_message) {
+    base::Time time = base::Time::fromMilliseconds(1556222665123);
+    ASSERT_EQ("$SBZDA,200425.12,25,04,2019,00,00*6B", nmea::createZDA(time));
+}
+
+TEST_F(NMEATest, it_creates_a_ROT_message_positive_towards_starboard) {
+    ASSERT_EQ("$SBROT,-60.0,A*2C", nmea::createROT(M_PI / 180));
+    ASSERT_EQ("$SBROT,30.0,A*04", nmea::createROT(-M_PI / 360));
+}
+
+TEST_F(NMEATest, it_parses_the_list_of_pose_sentences) {
+    ASSERT_EQ(nmea::POSE_RMC | nmea::POSE_ROT | nmea::POSE_ZDA,
+        nmea::parsePoseSentences("RMC,ROT,ZDA"));
+    ASSERT_EQ(0, nmea::parsePoseSentences(""));
+    ASSERT_THROW(nmea::parsePoseSentences("RMC,XXX"), std::invalid_argument);
+}
+
+TEST_F(NMEATest, it_encodes_the_selected_sentences_of_a_pose_burst) {
+    nmea::Pose pose;
+    pose.time = base::Time::fromMilliseconds(1556222665123);
+    pose.latitude = base::Angle::fromDeg(43.2135634);
+    pose.longitude = base::Angle::fromDeg(43.018);
+    pose.altitude = 12.5;
+    pose.speed_over_ground = 1.4;
+    pose.track = base::Angle::fromDeg(10.42);
+    pose.heading = base::Angle::fromDeg(10.42);
+    pose.yaw_rate = M_PI / 180;
+
+    string burst = "garbage";
+    nmea::encodePoseBurst(burst, pose, nmea::POSE_ALL);
+    string expected =
+        nmea::createRMC(pose.time, pose.latitude, pose.longitude, 1.4,
+            pose.track, base::Angle::fromRad(0)) + "\n" +
+        nmea::createHDT(pose.heading) + "\n" +
+        nmea::createVTG(pose.track, pose.track, 1.4) + "\n" +
+        nmea::createGGA(pose.time, pose.latitude, pose.longitude, 1, 0, 12.5) + "\n" +
+        nmea::createZDA(pose.time) + "\n" +
+        nmea::createROT(M_PI / 180);
+    ASSERT_EQ(expected, burst);
+
+    nmea::encodePoseBurst(burst, pose, nmea::POSE_HDT | nmea::POSE_ROT);
+    ASSERT_EQ(nmea::createHDT(pose.heading) + "\n" + nmea::createROT(M_PI / 180),
+        burst);
+}
+
+TEST_F(NMEATest, it_encodes_the_RMC_message_in_a_fixed_buffer) {
+    base::Time time = base::Time::fromMilliseconds(1556222665123);
+    base::Angle latitude = base::Angle::fromDeg(43.2135634);
+    base::Angle longitude = base::Angle::fromDeg(43.018);
+    base::Angle track = base::Angle::fromDeg(10.42);
+
+    nmea::Sentence sentence;
+    nmea::encodeRMC(sentence, time, latitude, longitude, 1.4,
+        track, base::Angle::fromDeg(2));
+
+    ASSERT_EQ("$SBRMC,200425.12,A,4312.813,N,04301.079,E,2.7,349.6,250419,2.0,E*5E",
+        sentence.str());
+    ASSERT_FALSE(sentence.hasOverflowed());
+}
+
+TEST_F(NMEATest, it_encodes_the_VTG_message_in_a_fixed_buffer) {
+    nmea::Sentence sentence;
+    nmea::encodeVTG(sentence, base::Angle::fromDeg(10.42),
+        base::Angle::fromDeg(15.21), 1.4);
+    ASSERT_EQ("$SBVTG,349.58,T,344.79,M,2.72,N,5.04,K*40", sentence.str());
+}
+
+TEST_F(NMEATest, it_reuses_the_sentence_buffer) {
+    nmea::Sentence sentence;
+    nmea::encodeVTG(sentence, base::Angle::fromDeg(10.42),
+        base::Angle::fromDeg(15.21), 1.4);
+    nmea::encodeHDT(sentence, base::Angle::fromDeg(10.42));
+    ASSERT_EQ("$SBHDT,349.58,T*00", sentence.str());
+}
+
+TEST_F(NMEATest, it_formats_fixed_point_values_like_iostreams) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> values(-1000, 1000);
+    for (int i = 0; i < 10000; ++i) {
+        double v = values(rng);
+        for (int precision = 0; precision < 4; ++precision) {
+            nmea::Sentence sentence;
+            sentence.putFixed(v, precision);
+
+            ostringstream expected;
+            expected << fixed << setprecision(precision) << v;
+            ASSERT_EQ(expected.str(), sentence.str()) << setprecision(17) << v;
+        }
+    }
+}
+
+TEST_F(NMEATest, it_rounds_fixed_point_values_like_printf) {
+    double values[] = { 0.15, 1.45, 2.25, 0.25, 0.35, 2.675, 1.005, 0.5, 1.5, 2.5 };
+    for (double v : values) {
+        for (int precision = 0; precision < 4; ++precision) {
+            for (double signed_v : { v, -v }) {
+                nmea::Sentence sentence;
+                sentence.putFixed(signed_v, precision);
+
+                char expected[32];
+                snprintf(expected, sizeof(expected), "%.*f", precision, signed_v);
+                ASSERT_EQ(expected, sentence.str())
+                    << setprecision(17) << signed_v << " " << precision;
+            }
+        }
+    }
+
+    nmea::Sentence sentence;
+    sentence.putFixed(0.15, 1);
+    sentence.put(',');
+    sentence.putFixed(1.45, 1);
+    sentence.put(',');
+    sentence.putFixed(2.25, 1);
+    ASSERT_EQ("0.1,1.4,2.2", sentence.str());
+}
+
+TEST_F(NMEATest, it_zero_pads_integers) {
+    nmea::Sentence sentence;
+    sentence.putUInt(7, 3);
+    sentence.put(',');
+    sentence.putUInt(1234, 2);
+    sentence.put(',');
+    sentence.putUInt(0);
+    ASSERT_EQ("007,1234,0", sentence.str());
+}
+
+TEST_F(NMEATest, it_reports_overflows) {
+    nmea::Sentence sentence;
+    for (size_t i = 0; i < nmea::Sentence::CAPACITY; ++i) {
+        sentence.put('a');
+    }
+    ASSERT_FALSE(sentence.hasOverflowed());
+    sentence.put("bc");
+    ASSERT_TRUE(sentence.hasOverflowed());
+    ASSERT_EQ(nmea::Sentence::CAPACITY, sentence.size());
 }
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include "../src/NMEACoalescingQueue.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+typedef NMEACoalescingQueue::Key Key;
+
+struct NMEACoalescingQueueTest : public ::testing::Test {
+    NMEACoalescingQueue queue;
+    vector<string> sent;
+
+    size_t flush(size_t budget) {
+        return queue.flush(budget, [this](string const& s) { sent.push_back(s); });
+    }
+};
+
+TEST_F(NMEACoalescingQueueTest, it_sends_the_entries_in_order) {
+    queue.push(Key(1, 1), "a");
+    queue.push(Key(1, 2), "b");
+    queue.push(Key(2, 1), "c");
+    ASSERT_EQ(3, flush(0));
+    ASSERT_EQ((vector<string> { "a", "b", "c" }), sent);
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST_F(NMEACoalescingQueueTest, it_keeps_only_the_latest_sentences_of_a_key) {
+    queue.push(Key(1, 1), "a");
+    queue.push(Key(1, 2), "b");
+    queue.push(Key(1, 1), "c");
+    ASSERT_EQ(2, queue.size());
+    ASSERT_EQ(1, queue.getCoalescedCount());
+    flush(0);
+    ASSERT_EQ((vector<string> { "c", "b" }), sent);
+}
+
+TEST_F(NMEACoalescingQueueTest, it_counts_each_replaced_sentence_as_coalesced) {
+    queue.push(Key(1, 1), "a\nb\nc\nd");
+    queue.push(Key(1, 1), "e\nf");
+    ASSERT_EQ(4, queue.getCoalescedCount());
+    queue.push(Key(1, 1), "g");
+    ASSERT_EQ(6, queue.getCoalescedCount());
+}
+
+TEST_F(NMEACoalescingQueueTest, it_limits_the_number_of_sentences_per_flush) {
+    queue.push(Key(1, 1), "a\nb");
+    queue.push(Key(1, 2), "c");
+    queue.push(Key(1, 3), "d\ne");
+    ASSERT_EQ(3, flush(4));
+    ASSERT_EQ((vector<string> { "a\nb", "c" }), sent);
+    ASSERT_EQ(1, queue.size());
+}
+
+TEST_F(NMEACoalescingQueueTest, it_always_sends_the_oldest_entry) {
+    queue.push(Key(1, 1), "a\nb\nc");
+    queue.push(Key(1, 2), "d");
+    ASSERT_EQ(3, flush(2));
+    ASSERT_EQ((vector<string> { "a\nb\nc" }), sent);
+}
+
+TEST_F(NMEACoalescingQueueTest, it_coalesces_into_entries_pushed_after_a_partial_flush) {
+    queue.push(Key(1, 1), "a");
+    queue.push(Key(1, 2), "b");
+    queue.push(Key(1, 3), "c");
+    flush(1);
+    queue.push(Key(1, 3), "d");
+    queue.push(Key(1, 1), "e");
+    flush(0);
+    ASSERT_EQ((vector<string> { "a", "b", "d", "e" }), sent);
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include "../src/NMEAIngest.hpp"
+#include "../src/NMEA.hpp"
+
+#include <vector>
+
+using namespace std;
+using namespace seabots_pi;
+
+struct NMEAIngestTest : public ::testing::Test {
+    vector<gps_base::Solution> solutions;
+    vector<ais_base::Position> positions;
+    vector<ais_base::VesselInformation> vessels;
+    NMEAIngest ingest;
+
+    NMEAIngestTest()
+        : ingest(16, makeOutputs()) {}
+
+    NMEAIngest::Outputs makeOutputs() {
+        NMEAIngest::Outputs outputs;
+        outputs.solution = [this](gps_base::Solution const& s) {
+            solutions.push_back(s);
+        };
+        outputs.position = [this](ais_base::Position const& p) {
+            positions.push_back(p);
+        };
+        outputs.vessel = [this](ais_base::VesselInformation const& v) {
+            vessels.push_back(v);
+        };
+        return outputs;
+    }
+
+    bool push(string const& sentence,
+              base::Time const& time = base::Time::fromSeconds(764426119)) {
+        return ingest.push(time, sentence.data(), sentence.size());
+    }
+};
+
+TEST_F(NMEAIngestTest, it_converts_a_RMC_sentence_into_a_solution) {
+    push("$GPRMC,123519,A,4807.038,N,01131.000,W,022.4,084.4,230394,003.1,W*78\r\n");
+    ASSERT_EQ(1u, ingest.process());
+    ASSERT_EQ(1u, solutions.size());
+    ASSERT_EQ(base::Time::fromSeconds(764426119), solutions[0].time);
+    ASSERT_NEAR(48 + 7.038 / 60, solutions[0].latitude, 1e-9);
+    ASSERT_NEAR(-(11 + 31.0 / 60), solutions[0].longitude, 1e-9);
+    ASSERT_EQ(1u, ingest.getPublishedCount());
+}
+
+TEST_F(NMEAIngestTest, it_dates_a_GGA_sentence_from_its_reception_time) {
+    // Received shortly after midnight, for a fix made before midnight
+    push("$GPGGA,235959,4807.038,S,01131.000,E,4,08,0.9,545.4,M,46.9,M,,*53",
+         base::Time::fromSeconds(764467200 + 2));
+    ingest.process();
+    ASSERT_EQ(1u, solutions.size());
+    ASSERT_EQ(base::Time::fromSeconds(764467199), solutions[0].time);
+    ASSERT_EQ(gps_base::RTK_FIXED, solutions[0].positionType);
+    ASSERT_EQ(8, solutions[0].noOfSatellites);
+    ASSERT_DOUBLE_EQ(545.4, solutions[0].altitude);
+}
+
+TEST_F(NMEAIngestTest, it_rejects_sentences_with_an_invalid_checksum) {
+    push("$GPRMC,123519,A,4807.038,N,01131.000,W,022.4,084.4,230394,003.1,W*79");
+    ingest.process();
+    ASSERT_TRUE(solutions.empty());
+    ASSERT_EQ(1u, ingest.getRejectedCount());
+}
+
+TEST_F(NMEAIngestTest, it_ignores_the_plugins_own_sentences) {
+    push(nmea::createRMC(base::Time::fromSeconds(764426119),
+                         base::Angle::fromDeg(48), base::Angle::fromDeg(11),
+                         1, base::Angle::fromDeg(-10),
+                         base::Angle::fromDeg(0)));
+    ingest.process();
+    ASSERT_TRUE(solutions.empty());
+    ASSERT_EQ(0u, ingest.getRejectedCount());
+}
+
+TEST_F(NMEAIngestTest, it_converts_AIS_messages) {
+    push("!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C");
+    push("!AIVDM,2,1,1,A,55?MbV02;H;s<HtKR20EHE:0@T4@Dn2222222216L961O5Gf0NSQEp6ClRp8,0*1C");
+    push("!AIVDM,2,2,1,A,88888888880,2*25");
+    ASSERT_EQ(3u, ingest.process());
+    ASSERT_EQ(1u, positions.size());
+    ASSERT_EQ(477553000, positions[0].mmsi);
+    ASSERT_EQ(base::Time::fromSeconds(764426119), positions[0].time);
+    ASSERT_EQ(1u, vessels.size());
+    ASSERT_EQ(351759000, vessels[0].mmsi);
+}
+
+TEST_F(NMEAIngestTest, it_ignores_the_AIS_targets_sent_by_the_plugin) {
+    ingest.ignoreAISTarget(477553000, base::Time::fromSeconds(764426000));
+    push("!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C");
+    ingest.process();
+    ASSERT_TRUE(positions.empty());
+}
+
+TEST_F(NMEAIngestTest, it_stops_ignoring_a_target_the_plugin_did_not_send_for_the_timeout) {
+    ingest.setIgnoredAISTargetTimeout(base::Time::fromSeconds(60));
+    ingest.ignoreAISTarget(477553000, base::Time::fromSeconds(1000));
+    push("!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C",
+         base::Time::fromSeconds(1060));
+    ingest.process();
+    ASSERT_TRUE(positions.empty());
+
+    push("!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C",
+         base::Time::fromSeconds(1061));
+    ingest.process();
+    ASSERT_EQ(1u, positions.size());
+}
+
+TEST_F(NMEAIngestTest, it_forgets_expired_ignored_targets_when_ignoring_new_ones) {
+    ingest.setIgnoredAISTargetTimeout(base::Time::fromSeconds(60));
+    ingest.ignoreAISTarget(477553000, base::Time::fromSeconds(1000));
+    // Prunes the first target, which must then not be ignored even for
+    // messages stamped before its expiry
+    ingest.ignoreAISTarget(1, base::Time::fromSeconds(1100));
+    push("!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C",
+         base::Time::fromSeconds(1030));
+    ingest.process();
+    ASSERT_EQ(1u, positions.size());
+}
+
+TEST_F(NMEAIngestTest, it_drops_sentences_when_the_queue_is_full) {
+    string sentence = "$GPRMC,123519,A,4807.038,N,01131.000,W,022.4,084.4,230394,003.1,W*78";
+    size_t pushed = 0;
+    for (int i = 0; i < 32; ++i) {
+        pushed += push(sentence) ? 1 : 0;
+    }
+    ASSERT_EQ(32 - pushed, ingest.getDropCount());
+    ASSERT_EQ(pushed, ingest.process());
+}
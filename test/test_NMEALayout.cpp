@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include "../src/NMEALayout.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+using namespace seabots_pi::nmea;
+
+static_assert(layout::checksum("SBHDT,,T") == layout::HDT::constantChecksum(),
+    "the constant part of HDT is the address, the separators and the unit");
+static_assert(layout::checksum("SBVTG,,T,,M,,N,,K") == layout::VTG::constantChecksum(),
+    "the constant part of VTG is the address, the separators and the units");
+static_assert(layout::checksum("SBRMC,,A,,,,,,") == layout::RMC::constantChecksum(),
+    "the separators embedded in the RMC fields are written at runtime");
+
+struct NMEALayoutTest : public ::testing::Test {
+    /** Expected result computed with the runtime checksum */
+    string finalize(string payload) {
+        Sentence sentence;
+        sentence.put(payload.c_str());
+        finalizeSentence(sentence);
+        return sentence.str();
+    }
+};
+
+TEST_F(NMEALayoutTest, it_computes_the_checksum_of_a_string_at_compile_time) {
+    ASSERT_EQ(0x2D, layout::checksum("PFEC,GPint,RMC05"));
+}
+
+TEST_F(NMEALayoutTest, it_encodes_a_sentence_made_of_constant_fields_only) {
+    typedef layout::Layout<
+        layout::Address<'S', 'B', 'T', 'S', 'T'>,
+        layout::Const<'A', 'B'>, layout::Empty, layout::Const<'C'>
+    > Test;
+
+    Sentence sentence;
+    Test::encode(sentence);
+    ASSERT_EQ(finalize("$SBTST,AB,,C"), sentence.str());
+}
+
+TEST_F(NMEALayoutTest, it_combines_the_constant_and_runtime_checksums) {
+    typedef layout::Layout<
+        layout::Address<'S', 'B', 'G', 'L', 'L'>,
+        layout::Latitude, layout::Longitude, layout::Time,
+        layout::Const<'A'>, layout::UInt<3>, layout::Fixed<3>
+    > Test;
+
+    Sentence sentence;
+    Test::encode(sentence,
+        base::Angle::fromDeg(-43.2135634), base::Angle::fromDeg(43.018),
+        base::Time::fromMilliseconds(1556222665123), 7, -1.5);
+    ASSERT_EQ(finalize("$SBGLL,4312.813,S,04301.079,E,200425.12,A,007,-1.500"),
+        sentence.str());
+}
+
+TEST_F(NMEALayoutTest, it_writes_the_direction_of_signed_fields) {
+    typedef layout::Layout<
+        layout::Address<'S', 'B', 'T', 'S', 'T'>,
+        layout::SignedFixed<1, 'E', 'W'>, layout::SignedFixed<1, 'E', 'W'>
+    > Test;
+
+    Sentence sentence;
+    Test::encode(sentence, 2.04, -3.0);
+    ASSERT_EQ(finalize("$SBTST,2.0,E,3.0,W"), sentence.str());
+}
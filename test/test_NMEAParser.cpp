@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+#include "../src/NMEAParser.hpp"
+#include "../src/NMEA.hpp"
+
+#include <cmath>
+#include <random>
+
+using namespace std;
+using namespace seabots_pi;
+
+struct NMEAParserTest : public ::testing::Test {
+    bool validate(string const& sentence) {
+        return nmea::validateChecksum(sentence.data(), sentence.size());
+    }
+};
+
+TEST_F(NMEAParserTest, it_validates_the_checksum) {
+    ASSERT_TRUE(validate("$PFEC,GPint,RMC05*2D"));
+    ASSERT_TRUE(validate("$PFEC,GPint,RMC05*2d"));
+    ASSERT_FALSE(validate("$PFEC,GPint,RMC06*2D"));
+    ASSERT_FALSE(validate("$PFEC,GPint,RMC05*2"));
+    ASSERT_FALSE(validate("PFEC,GPint,RMC05*2D"));
+    ASSERT_FALSE(validate("$PFEC,GPint,RMC05*2G"));
+}
+
+TEST_F(NMEAParserTest, it_validates_the_checksum_of_sentences_of_any_length) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> chars(' ', '~');
+    for (int length = 0; length < 80; ++length) {
+        string payload;
+        for (int i = 0; i < length; ++i) {
+            char c = chars(rng);
+            payload += (c == '*' ? '+' : c);
+        }
+        string sentence = nmea::createPackage(payload);
+        ASSERT_TRUE(validate(sentence)) << sentence;
+        sentence[sentence.size() - 1] ^= 1;
+        ASSERT_FALSE(validate(sentence)) << sentence;
+    }
+}
+
+TEST_F(NMEAParserTest, it_trims_line_terminators) {
+    string sentence = "$PFEC,GPint,RMC05*2D\r\n";
+    ASSERT_EQ(sentence.size() - 2,
+        nmea::trimSentence(sentence.data(), sentence.size()));
+}
+
+TEST_F(NMEAParserTest, it_splits_the_fields_of_a_sentence) {
+    string sentence = "$GPXXX,a,,bc*03";
+    nmea::FieldReader reader(sentence.data(), sentence.size());
+    nmea::Field field;
+    ASSERT_TRUE(reader.next(field));
+    ASSERT_EQ("a", string(field.data, field.size));
+    ASSERT_TRUE(reader.next(field));
+    ASSERT_TRUE(field.empty());
+    ASSERT_TRUE(reader.next(field));
+    ASSERT_EQ("bc", string(field.data, field.size));
+    ASSERT_FALSE(reader.next(field));
+}
+
+TEST_F(NMEAParserTest, it_parses_decimal_numbers) {
+    double value;
+    ASSERT_TRUE(nmea::parseDouble(nmea::Field("-12.50", 6), value));
+    ASSERT_DOUBLE_EQ(-12.5, value);
+    ASSERT_TRUE(nmea::parseDouble(nmea::Field("7", 1), value));
+    ASSERT_DOUBLE_EQ(7, value);
+    ASSERT_FALSE(nmea::parseDouble(nmea::Field("1.2.3", 5), value));
+    ASSERT_FALSE(nmea::parseDouble(nmea::Field("", 0), value));
+    ASSERT_FALSE(nmea::parseDouble(nmea::Field("1e3", 3), value));
+}
+
+TEST_F(NMEAParserTest, it_parses_a_RMC_sentence) {
+    string sentence =
+        "$GPRMC,123519,A,4807.038,N,01131.000,W,022.4,084.4,230394,003.1,W*78";
+    nmea::RMCData rmc;
+    ASSERT_TRUE(nmea::parseRMC(sentence.data(), sentence.size(), rmc));
+
+    // 1994-03-23T12:35:19Z
+    ASSERT_EQ(base::Time::fromSeconds(764426119), rmc.time);
+    ASSERT_TRUE(rmc.valid);
+    ASSERT_NEAR(48 + 7.038 / 60, rmc.latitude.getDeg(), 1e-9);
+    ASSERT_NEAR(-(11 + 31.0 / 60), rmc.longitude.getDeg(), 1e-9);
+    ASSERT_NEAR(22.4 * 1852 / 3600, rmc.speed_over_ground, 1e-9);
+    ASSERT_NEAR(-84.4, rmc.track.getDeg(), 1e-9);
+}
+
+TEST_F(NMEAParserTest, it_handles_empty_RMC_fields) {
+    string sentence = "$GPRMC,123519,V,,,,,,,230394,,*33";
+    nmea::RMCData rmc;
+    ASSERT_TRUE(nmea::parseRMC(sentence.data(), sentence.size(), rmc));
+    ASSERT_FALSE(rmc.valid);
+    ASSERT_TRUE(base::isUnknown(rmc.latitude.getRad()));
+    ASSERT_TRUE(base::isUnknown(rmc.speed_over_ground));
+    ASSERT_TRUE(base::isUnknown(rmc.track.getRad()));
+}
+
+TEST_F(NMEAParserTest, it_parses_a_GGA_sentence) {
+    string sentence =
+        "$GPGGA,123519,4807.038,S,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*5A";
+    nmea::GGAData gga;
+    ASSERT_TRUE(nmea::parseGGA(sentence.data(), sentence.size(), gga));
+    ASSERT_EQ(base::Time::fromSeconds(12 * 3600 + 35 * 60 + 19), gga.time_of_day);
+    ASSERT_NEAR(-(48 + 7.038 / 60), gga.latitude.getDeg(), 1e-9);
+    ASSERT_NEAR(11 + 31.0 / 60, gga.longitude.getDeg(), 1e-9);
+    ASSERT_EQ(1, gga.quality);
+    ASSERT_EQ(8, gga.satellites);
+    ASSERT_DOUBLE_EQ(0.9, gga.hdop);
+    ASSERT_DOUBLE_EQ(545.4, gga.altitude);
+    ASSERT_DOUBLE_EQ(46.9, gga.geoidal_separation);
+}
+
+TEST_F(NMEAParserTest, it_rejects_sentences_of_another_type) {
+    string sentence =
+        "$GPGGA,123519,4807.038,S,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*5A";
+    nmea::RMCData rmc;
+    ASSERT_FALSE(nmea::parseRMC(sentence.data(), sentence.size(), rmc));
+}
+
+TEST_F(NMEAParserTest, it_parses_a_VDM_fragment) {
+    string sentence = "!AIVDM,2,1,3,A,55?MbV02;H;s<HtKR20EHE:0@T4@Dn2222222216L961O5Gf0NSQEp6ClRp8,0*1E";
+    nmea::VDMFragment fragment;
+    ASSERT_TRUE(nmea::parseVDM(sentence.data(), sentence.size(), fragment));
+    ASSERT_EQ(2, fragment.count);
+    ASSERT_EQ(1, fragment.number);
+    ASSERT_EQ(3, fragment.sequence_id);
+    ASSERT_EQ('A', fragment.channel);
+    ASSERT_EQ("55?MbV02;H;s<HtKR20EHE:0@T4@Dn2222222216L961O5Gf0NSQEp6ClRp8",
+        string(fragment.payload.data, fragment.payload.size));
+    ASSERT_EQ(0, fragment.fill_bits);
+}
+
+TEST_F(NMEAParserTest, it_parses_a_VTG_sentence) {
+    string sentence = "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48";
+    nmea::VTGData vtg;
+    ASSERT_TRUE(nmea::parseVTG(sentence.data(), sentence.size(), vtg));
+    ASSERT_NEAR(-54.7, vtg.track_true_north.getDeg(), 1e-9);
+    ASSERT_NEAR(-34.4, vtg.track_magnetic.getDeg(), 1e-9);
+    ASSERT_NEAR(10.2 / 3.6, vtg.speed, 1e-9);
+}
+
+TEST_F(NMEAParserTest, it_parses_a_HDT_sentence) {
+    string sentence = "$HEHDT,274.07,T*19";
+    base::Angle heading;
+    ASSERT_TRUE(nmea::parseHDT(sentence.data(), sentence.size(), heading));
+    ASSERT_NEAR(360 - 274.07, heading.getDeg(), 1e-9);
+}
+
+/** Randomized encode/parse round trips
+ *
+ * The tolerances are the precision of the encoded fields
+ */
+struct NMEARoundTripTest : public NMEAParserTest {
+    static const int COUNT = 1000;
+    std::mt19937 rng { 1234 };
+
+    double uniform(double min, double max) {
+        return std::uniform_real_distribution<double>(min, max)(rng);
+    }
+
+    base::Angle angle(double min_deg, double max_deg) {
+        return base::Angle::fromDeg(uniform(min_deg, max_deg));
+    }
+};
+
+TEST_F(NMEARoundTripTest, it_parses_what_createRMC_generates) {
+    for (int i = 0; i < COUNT; ++i) {
+        // Within the 1980-2079 range of the two-digit years
+        base::Time time = base::Time::fromMicroseconds(
+            std::uniform_int_distribution<int64_t>(
+                315532800000000LL, 3471292799000000LL
+            )(rng)
+        );
+        base::Angle latitude = angle(-89.9, 89.9);
+        base::Angle longitude = angle(-179.9, 179.9);
+        double speed = uniform(0, 50);
+        base::Angle track = angle(-180, 180);
+        base::Angle variation = angle(-30, 30);
+        string sentence = nmea::createRMC(
+            time, latitude, longitude, speed, track, variation
+        );
+        ASSERT_TRUE(validate(sentence)) << sentence;
+
+        nmea::RMCData rmc;
+        ASSERT_TRUE(nmea::parseRMC(sentence.data(), sentence.size(), rmc))
+            << sentence;
+        ASSERT_TRUE(rmc.valid);
+        ASSERT_NEAR(time.toMicroseconds(), rmc.time.toMicroseconds(), 10000)
+            << sentence;
+        ASSERT_NEAR(latitude.getDeg(), rmc.latitude.getDeg(), 2e-5) << sentence;
+        ASSERT_NEAR(longitude.getDeg(), rmc.longitude.getDeg(), 2e-5) << sentence;
+        ASSERT_NEAR(speed, rmc.speed_over_ground, 0.05 * 1852 / 3600 + 1e-9)
+            << sentence;
+        ASSERT_TRUE(track.isApprox(rmc.track, base::Angle::deg2Rad(0.05 + 1e-9)))
+            << sentence;
+        ASSERT_TRUE(variation.isApprox(
+            rmc.magnetic_variation, base::Angle::deg2Rad(0.05 + 1e-9)
+        )) << sentence;
+    }
+}
+
+TEST_F(NMEARoundTripTest, it_parses_what_createVTG_generates) {
+    for (int i = 0; i < COUNT; ++i) {
+        base::Angle track = angle(-180, 180);
+        base::Angle magnetic = angle(-180, 180);
+        double speed = uniform(-50, 50);
+        string sentence = nmea::createVTG(track, magnetic, speed);
+        ASSERT_TRUE(validate(sentence)) << sentence;
+
+        nmea::VTGData vtg;
+        ASSERT_TRUE(nmea::parseVTG(sentence.data(), sentence.size(), vtg))
+            << sentence;
+        // Negative speeds are encoded as positive speeds in the opposite
+        // direction
+        if (speed < 0) {
+            track.flip();
+            magnetic.flip();
+        }
+        ASSERT_NEAR(fabs(speed), vtg.speed, 0.005 / 3.6 + 1e-9) << sentence;
+        ASSERT_TRUE(track.isApprox(
+            vtg.track_true_north, base::Angle::deg2Rad(0.005 + 1e-9)
+        )) << sentence;
+        ASSERT_TRUE(magnetic.isApprox(
+            vtg.track_magnetic, base::Angle::deg2Rad(0.005 + 1e-9)
+        )) << sentence;
+    }
+}
+
+TEST_F(NMEARoundTripTest, it_parses_what_createHDT_generates) {
+    for (int i = 0; i < COUNT; ++i) {
+        base::Angle heading = angle(-180, 180);
+        string sentence = nmea::createHDT(heading);
+        ASSERT_TRUE(validate(sentence)) << sentence;
+
+        base::Angle parsed;
+        ASSERT_TRUE(nmea::parseHDT(sentence.data(), sentence.size(), parsed))
+            << sentence;
+        ASSERT_TRUE(heading.isApprox(parsed, base::Angle::deg2Rad(0.005 + 1e-9)))
+            << sentence;
+    }
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "../src/PosePublicationPolicy.hpp"
+
+using namespace std;
+using namespace seabots_pi;
+
+struct PosePublicationPolicyTest : public ::testing::Test {
+    PosePublicationPolicy policy;
+
+    PosePublicationPolicyTest() {
+        PosePublicationPolicy::Configuration config;
+        config.min_period = base::Time::fromMilliseconds(100);
+        config.heartbeat_period = base::Time::fromSeconds(1);
+        config.position_deadband = 1;
+        config.angle_deadband = 0.01;
+        config.speed_deadband = 0.1;
+        policy.setConfiguration(config);
+    }
+
+    base::samples::RigidBodyState makePose(int64_t ms) {
+        base::samples::RigidBodyState rbs;
+        rbs.time = base::Time::fromMilliseconds(ms);
+        rbs.position = Eigen::Vector3d::Zero();
+        rbs.orientation = Eigen::Quaterniond::Identity();
+        rbs.velocity = Eigen::Vector3d(1, 0, 0);
+        return rbs;
+    }
+};
+
+TEST_F(PosePublicationPolicyTest, it_publishes_the_first_pose) {
+    ASSERT_TRUE(policy.update(makePose(0)));
+    ASSERT_EQ(1, policy.getPublishedCount());
+}
+
+TEST_F(PosePublicationPolicyTest, it_suppresses_poses_within_the_minimum_period) {
+    policy.update(makePose(0));
+    auto rbs = makePose(50);
+    rbs.position.x() = 10;
+    ASSERT_FALSE(policy.update(rbs));
+    ASSERT_EQ(1, policy.getRateSuppressedCount());
+    rbs.time = base::Time::fromMilliseconds(100);
+    ASSERT_TRUE(policy.update(rbs));
+}
+
+TEST_F(PosePublicationPolicyTest, it_suppresses_poses_within_the_deadband) {
+    policy.update(makePose(0));
+    auto rbs = makePose(200);
+    rbs.position = Eigen::Vector3d(0.5, 0.5, 10);
+    rbs.velocity = Eigen::Vector3d(1.05, 0, 0);
+    rbs.orientation = Eigen::AngleAxisd(0.005, Eigen::Vector3d::UnitZ());
+    ASSERT_FALSE(policy.update(rbs));
+    ASSERT_EQ(1, policy.getDeadbandSuppressedCount());
+    ASSERT_EQ(0, policy.getRateSuppressedCount());
+}
+
+TEST_F(PosePublicationPolicyTest, it_publishes_a_heartbeat) {
+    policy.update(makePose(0));
+    ASSERT_FALSE(policy.update(makePose(999)));
+    ASSERT_TRUE(policy.update(makePose(1000)));
+    ASSERT_FALSE(policy.update(makePose(1999)));
+}
+
+TEST_F(PosePublicationPolicyTest, it_publishes_on_position_changes) {
+    policy.update(makePose(0));
+    auto rbs = makePose(200);
+    rbs.position.y() = 1.1;
+    ASSERT_TRUE(policy.update(rbs));
+}
+
+TEST_F(PosePublicationPolicyTest, it_publishes_on_heading_changes) {
+    policy.update(makePose(0));
+    auto rbs = makePose(200);
+    rbs.orientation = Eigen::AngleAxisd(-0.02, Eigen::Vector3d::UnitZ());
+    ASSERT_TRUE(policy.update(rbs));
+}
+
+TEST_F(PosePublicationPolicyTest, it_publishes_on_course_changes) {
+    policy.update(makePose(0));
+    auto rbs = makePose(200);
+    rbs.velocity = Eigen::Vector3d(cos(0.02), sin(0.02), 0);
+    ASSERT_TRUE(policy.update(rbs));
+}
+
+TEST_F(PosePublicationPolicyTest, it_ignores_the_course_at_low_speeds) {
+    auto rbs = makePose(0);
+    rbs.velocity = Eigen::Vector3d(0.05, 0, 0);
+    policy.update(rbs);
+    rbs.time = base::Time::fromMilliseconds(200);
+    rbs.velocity = Eigen::Vector3d(0, 0.05, 0);
+    ASSERT_FALSE(policy.update(rbs));
+}
+
+TEST_F(PosePublicationPolicyTest, it_publishes_on_speed_changes) {
+    policy.update(makePose(0));
+    auto rbs = makePose(200);
+    rbs.velocity = Eigen::Vector3d(1.2, 0, 0);
+    ASSERT_TRUE(policy.update(rbs));
+}
+
+TEST_F(PosePublicationPolicyTest, it_resets_if_time_goes_backwards) {
+    policy.update(makePose(1000));
+    ASSERT_TRUE(policy.update(makePose(500)));
+    ASSERT_FALSE(policy.update(makePose(550)));
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "../src/SPSCQueue.hpp"
+
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace seabots_pi;
+
+struct SPSCQueueTest : public ::testing::Test {
+};
+
+TEST_F(SPSCQueueTest, it_pops_the_elements_in_the_order_they_were_pushed) {
+    SPSCQueue<string> queue(4);
+    ASSERT_TRUE(queue.push("a"));
+    ASSERT_TRUE(queue.push("b"));
+
+    string value;
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ("a", value);
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ("b", value);
+    ASSERT_FALSE(queue.pop(value));
+}
+
+TEST_F(SPSCQueueTest, it_drops_and_counts_the_elements_pushed_while_full) {
+    SPSCQueue<int> queue(2);
+    ASSERT_TRUE(queue.push(1));
+    ASSERT_TRUE(queue.push(2));
+    ASSERT_FALSE(queue.push(3));
+    ASSERT_FALSE(queue.push(4));
+    ASSERT_EQ(2u, queue.getDropCount());
+
+    int value;
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(1, value);
+    ASSERT_TRUE(queue.push(5));
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(2, value);
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(5, value);
+}
+
+TEST_F(SPSCQueueTest, it_tracks_the_high_water_mark) {
+    SPSCQueue<int> queue(8);
+    int value;
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    queue.pop(value);
+    queue.pop(value);
+    queue.push(4);
+    ASSERT_EQ(3u, queue.getHighWaterMark());
+}
+
+TEST_F(SPSCQueueTest, it_transfers_elements_between_two_threads) {
+    SPSCQueue<int> queue(16);
+    int const count = 100000;
+    thread producer([&queue] {
+        for (int i = 0; i < count; ++i) {
+            while (!queue.push(i)) {
+                this_thread::yield();
+            }
+        }
+    });
+
+    // Keep draining on mismatch so that the producer can finish, the
+    // assertions are done once it is joined
+    int received = 0;
+    int mismatchIndex = -1;
+    int mismatchValue = 0;
+    while (received < count) {
+        int value;
+        if (queue.pop(value)) {
+            if (mismatchIndex < 0 && value != received) {
+                mismatchIndex = received;
+                mismatchValue = value;
+            }
+            ++received;
+        }
+    }
+    producer.join();
+    ASSERT_EQ(-1, mismatchIndex) << "received " << mismatchValue;
+    ASSERT_LE(queue.getHighWaterMark(), 16u);
+}
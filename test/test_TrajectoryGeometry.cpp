@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "../src/TrajectoryGeometry.hpp"
+#include <cmath>
+
+using namespace std;
+using namespace seabots_pi;
+
+struct TrajectoryGeometryTest : public ::testing::Test {
+    struct Point {
+        float x;
+        float y;
+    };
+};
+
+TEST_F(TrajectoryGeometryTest, it_packs_trajectories_in_a_single_vertex_array) {
+    TrajectoryGeometry geometry;
+    geometry.addTrajectory(vector<Point> { { 0, 1 }, { 2, 3 } });
+    geometry.addTrajectory(vector<Point> { { 4, 5 }, { 6, 7 }, { 8, 9 } });
+
+    ASSERT_EQ(vector<float>({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }), geometry.vertices);
+    ASSERT_EQ(vector<int>({ 0, 2 }), geometry.levels[0].firsts);
+    ASSERT_EQ(vector<int>({ 2, 3 }), geometry.levels[0].counts);
+}
+
+TEST_F(TrajectoryGeometryTest, it_does_not_create_strips_for_trajectories_with_less_than_two_points) {
+    TrajectoryGeometry geometry;
+    geometry.addTrajectory(vector<Point> { { 0, 1 } });
+    geometry.addTrajectory(vector<Point> {});
+    geometry.addTrajectory(vector<Point> { { 4, 5 }, { 6, 7 } });
+
+    ASSERT_EQ(1u, geometry.getStripCount());
+    ASSERT_EQ(vector<int>({ 1 }), geometry.levels[0].firsts);
+    ASSERT_EQ(vector<int>({ 2 }), geometry.levels[0].counts);
+}
+
+TEST_F(TrajectoryGeometryTest, it_simplifies_straight_lines_to_their_endpoints) {
+    vector<Point> points;
+    for (int i = 0; i < 100; ++i) {
+        points.push_back(Point { static_cast<float>(i), static_cast<float>(2 * i) });
+    }
+
+    TrajectoryGeometry geometry;
+    geometry.addTrajectory(points);
+    geometry.buildLevelsOfDetail();
+
+    ASSERT_EQ(2u, geometry.levels.size());
+    auto const& level = geometry.levels[1];
+    ASSERT_EQ(vector<int>({ 100 }), level.firsts);
+    ASSERT_EQ(vector<int>({ 2 }), level.counts);
+    ASSERT_FLOAT_EQ(0, geometry.vertices[200]);
+    ASSERT_FLOAT_EQ(99, geometry.vertices[202]);
+    ASSERT_FLOAT_EQ(198, geometry.vertices[203]);
+}
+
+TEST_F(TrajectoryGeometryTest, it_keeps_the_vertices_farther_than_the_tolerance) {
+    TrajectoryGeometry geometry;
+    geometry.addTrajectory(vector<Point> {
+        { 0, 0 }, { 10, 0.5 }, { 20, 0 }, { 30, 3 }, { 40, 0 }
+    });
+    geometry.buildLevelsOfDetail(1, 4, 12);
+
+    // tolerance 1 removes the vertex at 0.5, tolerance 4 the one at 3
+    ASSERT_EQ(3u, geometry.levels.size());
+    ASSERT_EQ(1, geometry.levels[1].tolerance);
+    ASSERT_EQ(vector<int>({ 4 }), geometry.levels[1].counts);
+    ASSERT_EQ(4, geometry.levels[2].tolerance);
+    ASSERT_EQ(vector<int>({ 2 }), geometry.levels[2].counts);
+}
+
+TEST_F(TrajectoryGeometryTest, it_bounds_the_vertex_count_by_the_tolerance) {
+    // A circle of 10km radius sampled every ~1m
+    vector<Point> points;
+    int n = 62832;
+    for (int i = 0; i <= n; ++i) {
+        double a = 2 * M_PI * i / n;
+        points.push_back(Point {
+            static_cast<float>(10000 * cos(a)), static_cast<float>(10000 * sin(a))
+        });
+    }
+
+    TrajectoryGeometry geometry;
+    geometry.addTrajectory(points);
+    geometry.buildLevelsOfDetail();
+
+    // The sagitta of a chord c on a circle of radius r is c^2 / (8 r). A
+    // segment is split only if its sagitta is above the tolerance, so the
+    // resulting chords are at least half of sqrt(8 r tolerance)
+    ASSERT_GT(geometry.levels.size(), 5u);
+    for (size_t i = 1; i < geometry.levels.size(); ++i) {
+        auto const& level = geometry.levels[i];
+        double min_chord = sqrt(8 * 10000 * level.tolerance) / 2;
+        ASSERT_GE(2 * M_PI * 10000 / min_chord, level.getVertexCount() - 1);
+    }
+}
+
+TEST_F(TrajectoryGeometryTest, it_selects_the_least_detailed_level_within_the_pixel_tolerance) {
+    TrajectoryGeometry geometry;
+    geometry.levels.resize(4);
+    geometry.levels[1].tolerance = 1;
+    geometry.levels[2].tolerance = 4;
+    geometry.levels[3].tolerance = 16;
+
+    ASSERT_EQ(&geometry.levels[0], &geometry.selectLevel(1, 0.5));
+    ASSERT_EQ(&geometry.levels[1], &geometry.selectLevel(0.5, 0.5));
+    ASSERT_EQ(&geometry.levels[2], &geometry.selectLevel(0.1, 0.5));
+    ASSERT_EQ(&geometry.levels[3], &geometry.selectLevel(0.001, 0.5));
+}
+
+TEST_F(TrajectoryGeometryTest, it_splits_trajectories_in_chunks_sharing_their_end_vertex) {
+    vector<Point> points;
+    int n = TrajectoryGeometry::CHUNK_SIZE * 2;
+    for (int i = 0; i < n; ++i) {
+        points.push_back(Point { static_cast<float>(i), 0 });
+    }
+
+    TrajectoryGeometry geometry;
+    geometry.addTrajectory(vector<Point> { { 0, 1 }, { 2, 3 } });
+    geometry.addTrajectory(points);
+
+    int size = TrajectoryGeometry::CHUNK_SIZE;
+    auto const& level = geometry.levels[0];
+    ASSERT_EQ(2u, level.trajectories.size());
+    ASSERT_EQ(vector<int>({ 0, 2, 2 + size - 1, 2 + 2 * (size - 1) }), level.firsts);
+    ASSERT_EQ(vector<int>({ 2, size, size, 2 }), level.counts);
+    ASSERT_EQ(Eigen::Vector2f(0, 1), level.bounds[0].min());
+    ASSERT_EQ(Eigen::Vector2f(2, 3), level.bounds[0].max());
+    ASSERT_EQ(Eigen::Vector2f(size - 1, 0), level.bounds[2].min());
+    ASSERT_EQ(Eigen::Vector2f(2 * (size - 1), 0), level.bounds[2].max());
+}
+
+TEST_F(TrajectoryGeometryTest, it_returns_the_chunks_that_intersect_the_view) {
+    vector<Point> points;
+    int n = TrajectoryGeometry::CHUNK_SIZE * 3;
+    for (int i = 0; i < n; ++i) {
+        points.push_back(Point { static_cast<float>(i), 0 });
+    }
+
+    TrajectoryGeometry geometry;
+    geometry.addTrajectory(points);
+
+    vector<int> firsts, counts;
+    float start = TrajectoryGeometry::CHUNK_SIZE + 10;
+    geometry.levels[0].cull(
+        Eigen::AlignedBox2f(Eigen::Vector2f(start, -1), Eigen::Vector2f(start + 10, 1)),
+        firsts, counts
+    );
+    ASSERT_EQ(vector<int>({ TrajectoryGeometry::CHUNK_SIZE - 1 }), firsts);
+    ASSERT_EQ(vector<int>({ TrajectoryGeometry::CHUNK_SIZE }), counts);
+
+    geometry.levels[0].cull(
+        Eigen::AlignedBox2f(Eigen::Vector2f(0, 2), Eigen::Vector2f(n, 3)),
+        firsts, counts
+    );
+    ASSERT_TRUE(firsts.empty());
+    ASSERT_TRUE(counts.empty());
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "../src/WorkerPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <set>
+
+using namespace std;
+using namespace seabots_pi;
+
+struct WorkerPoolTest : public ::testing::Test {
+    template<typename Predicate>
+    bool waitFor(Predicate predicate) {
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+        while (!predicate()) {
+            if (chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        return true;
+    }
+};
+
+TEST_F(WorkerPoolTest, it_creates_at_least_one_thread_by_default) {
+    WorkerPool pool;
+    ASSERT_GE(pool.getSize(), 1u);
+}
+
+TEST_F(WorkerPoolTest, it_executes_all_pushed_jobs) {
+    WorkerPool pool(4);
+    atomic<int> count(0);
+    for (int i = 0; i < 100; ++i) {
+        pool.push([&count] { ++count; });
+    }
+    ASSERT_TRUE(waitFor([&count] { return count == 100; }));
+}
+
+TEST_F(WorkerPoolTest, it_executes_jobs_in_parallel) {
+    WorkerPool pool(2);
+    atomic<int> running(0);
+    atomic<bool> both_running(false);
+    for (int i = 0; i < 2; ++i) {
+        pool.push([&] {
+            ++running;
+            waitFor([&] { return running == 2; });
+            both_running = (running == 2);
+        });
+    }
+    ASSERT_TRUE(waitFor([&] { return both_running.load(); }));
+}
+
+TEST_F(WorkerPoolTest, it_does_not_block_the_pushing_thread) {
+    WorkerPool pool(1);
+    atomic<bool> started(false);
+    atomic<bool> release(false);
+    atomic<bool> done(false);
+    pool.push([&] {
+        started = true;
+        waitFor([&] { return release.load(); });
+    });
+    ASSERT_TRUE(waitFor([&] { return started.load(); }));
+
+    // The only worker is blocked, pushing must still return
+    pool.push([&] { done = true; });
+    ASSERT_FALSE(release);
+    ASSERT_FALSE(done);
+
+    release = true;
+    ASSERT_TRUE(waitFor([&] { return done.load(); }));
+}